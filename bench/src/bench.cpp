@@ -0,0 +1,63 @@
+//
+// Copyright (c) 2024, Daily
+//
+
+#include "bench.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+static std::atomic<size_t> ALLOCATIONS {0};
+
+size_t bench::allocations() {
+    return ALLOCATIONS.load(std::memory_order_relaxed);
+}
+
+// Counts every allocation, so benchmarks can report allocations per call.
+void* operator new(size_t size) {
+    ALLOCATIONS.fetch_add(1, std::memory_order_relaxed);
+    if (void* ptr = std::malloc(size == 0 ? 1 : size)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+    std::free(ptr);
+}
+
+// Runs all the benchmark groups, or the ones given as arguments.
+int main(int argc, char* argv[]) {
+    struct Group {
+        const char* name;
+        void (*run)();
+    };
+
+    const Group groups[] = {
+            {"audio", bench::audio},
+            {"calls", bench::calls},
+            {"dispatch", bench::dispatch},
+            {"messages", bench::messages},
+#ifdef BENCH_TEMPLATES
+            {"templates", bench::templates},
+#endif
+    };
+
+    for (const Group& group : groups) {
+        bool selected = argc < 2;
+        for (int i = 1; i < argc; ++i) {
+            selected = selected || std::strcmp(argv[i], group.name) == 0;
+        }
+        if (selected) {
+            group.run();
+        }
+    }
+
+    return 0;
+}
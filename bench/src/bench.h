@@ -0,0 +1,76 @@
+//
+// Copyright (c) 2024, Daily
+//
+
+#ifndef DAILY_PIPECAT_BENCH_H
+#define DAILY_PIPECAT_BENCH_H
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+
+namespace bench {
+
+// Keeps the compiler from optimizing away a result that is otherwise unused.
+template <typename T>
+inline void keep(const T& value) {
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "g"(&value) : "memory");
+#else
+    static volatile const void* sink;
+    sink = &value;
+#endif
+}
+
+// Returns the best time per call of `function`, in nanoseconds, over a few
+// runs of `iterations` calls each.
+template <typename Function>
+double measure_ns(size_t iterations, Function&& function) {
+    double best = 0;
+    for (int run = 0; run < 5; ++run) {
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < iterations; ++i) {
+            function();
+        }
+        std::chrono::duration<double, std::nano> elapsed =
+                std::chrono::steady_clock::now() - start;
+        double per_call = elapsed.count() / iterations;
+        best = run == 0 ? per_call : std::min(best, per_call);
+    }
+    return best;
+}
+
+inline void report(const char* group, const char* name, double ns) {
+    std::printf("%-12s %-36s %12.1f ns\n", group, name, ns);
+}
+
+// Number of heap allocations made so far by the process (all threads).
+size_t allocations();
+
+// Returns the number of heap allocations made by one call of `function`.
+template <typename Function>
+size_t count_allocations(Function&& function) {
+    size_t before = allocations();
+    function();
+    return allocations() - before;
+}
+
+inline void report_allocations(
+        const char* group,
+        const char* name,
+        size_t allocations
+) {
+    std::printf("%-12s %-36s %12zu allocations\n", group, name, allocations);
+}
+
+// Benchmark groups, each in its own file.
+void audio();
+void calls();
+void dispatch();
+void messages();
+void templates();
+
+}  // namespace bench
+
+#endif
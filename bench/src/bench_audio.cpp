@@ -0,0 +1,135 @@
+//
+// Copyright (c) 2024, Daily
+//
+
+#include "bench.h"
+
+#include "daily_audio.h"
+#include "daily_audio_ring.h"
+
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace rtvi;
+
+// 10 ms of 48 kHz stereo audio, the most common buffer size.
+static const size_t NUM_SAMPLES = 960;
+
+static const size_t ITERATIONS = 100000;
+
+// How an application would convert planar float audio itself before calling
+// `DailyTransport::send_user_audio()` with int16 frames.
+static void app_planar_float_to_int16(
+        const float* src,
+        int16_t* dst,
+        size_t num_frames,
+        uint32_t num_channels
+) {
+    for (size_t i = 0; i < num_frames; ++i) {
+        for (uint32_t c = 0; c < num_channels; ++c) {
+            float value = src[c * num_frames + i] * 32768.0f;
+            value = std::fmin(std::fmax(value, -32768.0f), 32767.0f);
+            dst[i * num_channels + c] = static_cast<int16_t>(std::lrint(value));
+        }
+    }
+}
+
+void bench::audio() {
+    std::mt19937 rng(1234);
+    std::uniform_int_distribution<int> dist(-32768, 32767);
+
+    std::vector<int16_t> a(NUM_SAMPLES);
+    std::vector<int16_t> b(NUM_SAMPLES);
+    for (size_t i = 0; i < NUM_SAMPLES; ++i) {
+        a[i] = static_cast<int16_t>(dist(rng));
+        b[i] = static_cast<int16_t>(dist(rng));
+    }
+    std::vector<int16_t> dst(NUM_SAMPLES * 2);
+    std::vector<float> floats(NUM_SAMPLES);
+
+    const char* names[] = {"scalar", "sse2", "avx2", "neon"};
+    for (const char* name : names) {
+        if (!audio_select_kernels(name)) {
+            continue;
+        }
+
+        auto run = [&](const char* kernel, auto&& function) {
+            std::string label = std::string(kernel) + " (" + name + ")";
+            report("audio", label.c_str(), measure_ns(ITERATIONS, function));
+        };
+
+        run("peak", [&] { keep(audio_peak(a.data(), NUM_SAMPLES)); });
+        run("sum_squares", [&] {
+            keep(audio_sum_squares(a.data(), NUM_SAMPLES));
+        });
+        run("gain", [&] {
+            audio_gain(dst.data(), NUM_SAMPLES, 0.9f);
+            keep(dst);
+        });
+        run("mix", [&] {
+            audio_mix(dst.data(), b.data(), NUM_SAMPLES);
+            keep(dst);
+        });
+        run("int16_to_float", [&] {
+            audio_int16_to_float(a.data(), floats.data(), NUM_SAMPLES);
+            keep(floats);
+        });
+        run("float_to_int16", [&] {
+            audio_float_to_int16(floats.data(), dst.data(), NUM_SAMPLES);
+            keep(dst);
+        });
+        run("stereo_to_mono", [&] {
+            audio_stereo_to_mono(a.data(), dst.data(), NUM_SAMPLES / 2);
+            keep(dst);
+        });
+        run("mono_to_stereo", [&] {
+            audio_mono_to_stereo(a.data(), dst.data(), NUM_SAMPLES);
+            keep(dst);
+        });
+        run("planar_float_to_int16", [&] {
+            audio_planar_float_to_int16(
+                    floats.data(),
+                    dst.data(),
+                    NUM_SAMPLES / 2,
+                    2,
+                    NUM_SAMPLES / 2
+            );
+            keep(dst);
+        });
+    }
+
+    // `DailyTransport::send_user_audio()` with float32 planar audio, which is
+    // converted inside the transport, vs an application converting it and
+    // sending int16 frames. Both end up writing int16 frames to a ring, like
+    // paced user audio. The kernels are the last (fastest) ones selected
+    // above, which are also the default ones.
+    const size_t num_frames = NUM_SAMPLES / 2;
+    for (size_t i = 0; i < NUM_SAMPLES; ++i) {
+        floats[i] = a[i] / 32768.0f;
+    }
+    DailyAudioRing ring(num_frames * 10, 2);
+    auto send_int16 = [&](const int16_t* frames) {
+        size_t written = ring.write(frames, num_frames);
+        ring.skip(written);
+        keep(written);
+    };
+
+    report("audio", "send int16", measure_ns(ITERATIONS, [&] {
+               send_int16(a.data());
+           }));
+    report("audio", "send float planar", measure_ns(ITERATIONS, [&] {
+               audio_planar_float_to_int16(
+                       floats.data(), dst.data(), num_frames, 2, num_frames
+               );
+               send_int16(dst.data());
+           }));
+    report("audio", "app planar to int16 + send", measure_ns(ITERATIONS, [&] {
+               app_planar_float_to_int16(
+                       floats.data(), dst.data(), num_frames, 2
+               );
+               send_int16(dst.data());
+           }));
+}
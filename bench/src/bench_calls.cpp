@@ -0,0 +1,118 @@
+//
+// Copyright (c) 2024, Daily
+//
+
+#include "bench.h"
+
+#include "daily_audio_ring.h"
+
+#include <array>
+#include <cstdint>
+
+using namespace rtvi;
+
+// Per-call cost of the audio entry points: a virtual call through the
+// transport interface (like `RTVITransport::send_user_audio()`, which is how
+// RTVIClient calls the transport) vs a direct call with the block size fixed
+// at compile time, which is what compile-time transport profiles would allow.
+// Both write the same 10 ms block to a ring, as the paced user audio does.
+//
+// The ring is in the library, so these also show the cost of calls into each
+// of its variants (shared, LTO or PGO, see the build options).
+
+// 10 ms of 16 kHz mono audio, the default user audio format.
+static const size_t BLOCK_FRAMES = 160;
+
+static const size_t ITERATIONS = 1000000;
+
+namespace {
+
+class AudioSink {
+   public:
+    virtual ~AudioSink() {}
+
+    virtual int32_t send(const int16_t* frames, size_t num_frames) = 0;
+};
+
+class RingSink : public AudioSink {
+   public:
+    RingSink() : _ring(BLOCK_FRAMES * 10, 1) {}
+
+    int32_t send(const int16_t* frames, size_t num_frames) override {
+        return write(frames, num_frames);
+    }
+
+    template <size_t NumFrames>
+    int32_t send_block(const std::array<int16_t, NumFrames>& block) {
+        return write(block.data(), NumFrames);
+    }
+
+   private:
+    int32_t write(const int16_t* frames, size_t num_frames) {
+        size_t written = _ring.write(frames, num_frames);
+        // Keep the ring from filling up, like its reader would.
+        _ring.skip(written);
+        return static_cast<int32_t>(written);
+    }
+
+    DailyAudioRing _ring;
+};
+
+// Only counts frames, to measure the calls alone.
+class CountingSink : public AudioSink {
+   public:
+    int32_t send(const int16_t* frames, size_t num_frames) override {
+        _frames += num_frames;
+        return static_cast<int32_t>(num_frames);
+    }
+
+    template <size_t NumFrames>
+    int32_t send_block(const std::array<int16_t, NumFrames>& block) {
+        _frames += NumFrames;
+        return static_cast<int32_t>(NumFrames);
+    }
+
+   private:
+    uint64_t _frames = 0;
+};
+
+}  // namespace
+
+// Like a transport owned by RTVIClient, the compiler can't tell which
+// implementation is behind the pointer.
+template <typename Sink>
+static AudioSink* opaque(Sink& sink) {
+    AudioSink* volatile pointer = &sink;
+    return pointer;
+}
+
+void bench::calls() {
+    std::array<int16_t, BLOCK_FRAMES> block {};
+    for (size_t i = 0; i < BLOCK_FRAMES; ++i) {
+        block[i] = static_cast<int16_t>(i * 100);
+    }
+
+    CountingSink counting;
+    AudioSink* counting_virtual = opaque(counting);
+    report("calls", "virtual, no work", measure_ns(ITERATIONS, [&] {
+               keep(counting_virtual->send(block.data(), BLOCK_FRAMES));
+           }));
+    report("calls", "direct, no work", measure_ns(ITERATIONS, [&] {
+               keep(counting.send_block(block));
+           }));
+
+    // A library call that does (almost) nothing.
+    DailyAudioRing library_ring(BLOCK_FRAMES, 1);
+    report("calls", "library call, no work", measure_ns(ITERATIONS, [&] {
+               keep(library_ring.available());
+           }));
+
+    RingSink ring;
+    AudioSink* ring_virtual = opaque(ring);
+    report("calls", "virtual, 10ms block to ring", measure_ns(ITERATIONS, [&] {
+               keep(ring_virtual->send(block.data(), BLOCK_FRAMES));
+           }));
+    report("calls", "direct, 10ms block to ring", measure_ns(ITERATIONS, [&] {
+               keep(ring.send_block(block));
+           }));
+}
@@ -0,0 +1,106 @@
+//
+// Copyright (c) 2024, Daily
+//
+
+#include "bench.h"
+
+#include "daily_dispatch.h"
+
+#include <nlohmann/json.hpp>
+
+#include <map>
+#include <string>
+#include <string_view>
+
+static const size_t ITERATIONS = 100000;
+
+// Event actions handled by the transport.
+static constexpr rtvi::DailyPerfectHash<7> ACTIONS({
+        "participant-joined",
+        "participant-updated",
+        "participant-left",
+        "app-message",
+        "call-state-updated",
+        "network-connection",
+        "request-completed",
+});
+
+// Actions looked up, in the proportion they're received during a call.
+static const std::string_view RECEIVED[] = {
+        "app-message",
+        "app-message",
+        "app-message",
+        "participant-updated",
+        "network-stats-updated",
+        "network-stats-updated",
+        "active-speaker-changed",
+        "request-completed",
+};
+
+// An event nobody handles, received every couple of seconds per call.
+static const char* NETWORK_STATS_EVENT = R"({
+  "action": "network-stats-updated",
+  "stats": {
+    "latest": {
+      "timestamp": 1718000000000,
+      "recvBitsPerSecond": 48213,
+      "sendBitsPerSecond": 41877,
+      "totalRecvPacketLoss": 0.001,
+      "totalSendPacketLoss": 0,
+      "videoRecvBitsPerSecond": 0,
+      "videoSendBitsPerSecond": 0,
+      "audioRecvBitsPerSecond": 48213,
+      "audioSendBitsPerSecond": 41877
+    },
+    "worstVideoRecvPacketLoss": 0,
+    "worstVideoSendPacketLoss": 0,
+    "averageNetworkRoundTripTime": 0.042
+  },
+  "threshold": "good",
+  "quality": 100
+})";
+
+static int32_t find_compare(std::string_view action) {
+    for (size_t i = 0; i < 7; ++i) {
+        if (ACTIONS.key(i) == action) {
+            return static_cast<int32_t>(i);
+        }
+    }
+    return -1;
+}
+
+template <typename Function>
+static void run(const char* name, Function&& function) {
+    function();
+    bench::report("dispatch", name, bench::measure_ns(ITERATIONS, function));
+}
+
+void bench::dispatch() {
+    std::map<std::string, int32_t, std::less<>> actions;
+    for (size_t i = 0; i < 7; ++i) {
+        actions.emplace(ACTIONS.key(i), static_cast<int32_t>(i));
+    }
+
+    // Time per lookup, averaged over the received actions.
+    const size_t num_received = sizeof(RECEIVED) / sizeof(RECEIVED[0]);
+    size_t next = 0;
+    auto received = [&] { return RECEIVED[next++ % num_received]; };
+
+    run("lookup (perfect hash)", [&] { keep(ACTIONS.find(received())); });
+    run("lookup (std::map)", [&] {
+        auto it = actions.find(received());
+        keep(it == actions.end() ? -1 : it->second);
+    });
+    run("lookup (string compares)", [&] {
+        keep(find_compare(received()));
+    });
+
+    std::string_view event(NETWORK_STATS_EVENT);
+    run("unhandled event action (peek)", [&] {
+        keep(rtvi::daily_json_peek_string(event, "action"));
+    });
+    run("unhandled event action (parse)", [&] {
+        nlohmann::json parsed = nlohmann::json::parse(event);
+        keep(parsed.value("action", ""));
+    });
+}
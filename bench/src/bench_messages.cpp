@@ -0,0 +1,229 @@
+//
+// Copyright (c) 2024, Daily
+//
+
+#include "bench.h"
+
+#include <nlohmann/json.hpp>
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+static const size_t ITERATIONS = 20000;
+
+// An LLM action, one of the largest messages usually sent by a client.
+static const char* ACTION_MESSAGE = R"({
+  "id": "d6c1d1ee-6a7f-4a0e-a4c3-3f2b7d1c9e55",
+  "label": "rtvi-ai",
+  "type": "action",
+  "data": {
+    "service": "llm",
+    "action": "append_to_messages",
+    "arguments": [
+      {
+        "name": "messages",
+        "value": [
+          {
+            "role": "user",
+            "content": "What is the weather like today in San Francisco?"
+          }
+        ]
+      },
+      { "name": "run_immediately", "value": true }
+    ]
+  }
+})";
+
+// The most frequent event received from daily-core.
+static const char* PARTICIPANT_UPDATED_EVENT = R"({
+  "action": "participant-updated",
+  "participant": {
+    "id": "7d0c3fa2-3b6e-4d38-8f0e-0b8d2f1c4a6e",
+    "info": {
+      "userName": "bot",
+      "isLocal": false,
+      "isOwner": false,
+      "joinedAt": 1718000000
+    },
+    "media": {
+      "microphone": {
+        "state": "playable",
+        "subscribed": "subscribed",
+        "offReasons": []
+      },
+      "camera": {
+        "state": "off",
+        "subscribed": "unsubscribed",
+        "offReasons": ["user"]
+      },
+      "screenVideo": { "state": "off", "offReasons": ["user"] },
+      "screenAudio": { "state": "off", "offReasons": ["user"] }
+    }
+  }
+})";
+
+// A bump allocator shared by all the JSON values of a thread and released at
+// once, as a per-session arena would be.
+class Arena {
+   public:
+    static Arena& current() {
+        thread_local Arena arena;
+        return arena;
+    }
+
+    void* allocate(size_t bytes) {
+        bytes = (bytes + 15) & ~size_t(15);
+        if (_used + bytes > _buffer.size()) {
+            _blocks.push_back(std::move(_buffer));
+            _buffer.resize(std::max<size_t>(bytes, 64 * 1024));
+            _used = 0;
+        }
+        void* ptr = _buffer.data() + _used;
+        _used += bytes;
+        return ptr;
+    }
+
+    void reset() {
+        _blocks.clear();
+        _used = 0;
+    }
+
+   private:
+    Arena() : _buffer(64 * 1024), _used(0) {}
+
+    std::vector<unsigned char> _buffer;
+    std::vector<std::vector<unsigned char>> _blocks;
+    size_t _used;
+};
+
+template <typename T>
+struct ArenaAllocator {
+    using value_type = T;
+
+    ArenaAllocator() = default;
+
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U>&) {}
+
+    T* allocate(size_t n) {
+        return static_cast<T*>(Arena::current().allocate(n * sizeof(T)));
+    }
+
+    void deallocate(T*, size_t) {}
+
+    template <typename U>
+    bool operator==(const ArenaAllocator<U>&) const {
+        return true;
+    }
+
+    template <typename U>
+    bool operator!=(const ArenaAllocator<U>&) const {
+        return false;
+    }
+};
+
+using ArenaJson = nlohmann::basic_json<
+        std::map,
+        std::vector,
+        std::string,
+        bool,
+        std::int64_t,
+        std::uint64_t,
+        double,
+        ArenaAllocator>;
+
+// The RTVI interfaces take `nlohmann::json`, so an arena-backed value needs
+// to be converted at every boundary.
+static nlohmann::json to_json(const ArenaJson& value) {
+    switch (value.type()) {
+    case nlohmann::json::value_t::object: {
+        nlohmann::json object = nlohmann::json::object();
+        for (const auto& item : value.items()) {
+            object[item.key()] = to_json(item.value());
+        }
+        return object;
+    }
+    case nlohmann::json::value_t::array: {
+        nlohmann::json array = nlohmann::json::array();
+        for (const auto& item : value) {
+            array.push_back(to_json(item));
+        }
+        return array;
+    }
+    case nlohmann::json::value_t::string:
+        return value.get<std::string>();
+    case nlohmann::json::value_t::boolean:
+        return value.get<bool>();
+    case nlohmann::json::value_t::number_integer:
+        return value.get<std::int64_t>();
+    case nlohmann::json::value_t::number_unsigned:
+        return value.get<std::uint64_t>();
+    case nlohmann::json::value_t::number_float:
+        return value.get<double>();
+    default:
+        return nullptr;
+    }
+}
+
+// Serialization as done before user-026: the tree was copied into the queue
+// and dumped by the send thread.
+static std::string serialize_copy(const nlohmann::json& message) {
+    nlohmann::json queued = message;
+    return queued.dump();
+}
+
+// Serialization through a reused per-thread buffer, which needs nlohmann's
+// internal serializer.
+static std::string serialize_scratch(const nlohmann::json& message) {
+    thread_local std::string buffer;
+    buffer.clear();
+    nlohmann::detail::serializer<nlohmann::json> serializer(
+            nlohmann::detail::output_adapter<char>(buffer), ' '
+    );
+    serializer.dump(message, false, false, 0);
+    return std::string(buffer);
+}
+
+static std::string serialize_dump(const nlohmann::json& message) {
+    return message.dump();
+}
+
+// Reports the time and the allocations of one call of `function`.
+template <typename Function>
+static void run(const char* name, Function&& function) {
+    // Warm up per-thread buffers and arenas.
+    function();
+    bench::report("messages", name, bench::measure_ns(ITERATIONS, function));
+    bench::report_allocations(
+            "messages", name, bench::count_allocations(function)
+    );
+}
+
+void bench::messages() {
+    nlohmann::json action = nlohmann::json::parse(ACTION_MESSAGE);
+    std::string event(PARTICIPANT_UPDATED_EVENT);
+    const char* begin = event.data();
+    const char* end = event.data() + event.size();
+
+    run("serialize (copy + dump)", [&] { keep(serialize_copy(action)); });
+    run("serialize (scratch buffer)", [&] {
+        keep(serialize_scratch(action));
+    });
+    run("serialize (dump)", [&] { keep(serialize_dump(action)); });
+
+    run("parse event", [&] { keep(nlohmann::json::parse(begin, end)); });
+    run("parse event (arena)", [&] {
+        keep(ArenaJson::parse(begin, end));
+        Arena::current().reset();
+    });
+    run("parse event (arena + convert)", [&] {
+        {
+            ArenaJson value = ArenaJson::parse(begin, end);
+            keep(to_json(value["participant"]));
+        }
+        Arena::current().reset();
+    });
+}
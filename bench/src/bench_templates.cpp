@@ -0,0 +1,77 @@
+//
+// Copyright (c) 2024, Daily
+//
+
+#include "bench.h"
+
+#include "daily_message_template.h"
+
+#include <nlohmann/json.hpp>
+
+#include <string>
+#include <vector>
+
+static const size_t ITERATIONS = 20000;
+
+// Arguments of an LLM action, which change with every message.
+static const char* ARGUMENTS = R"([
+  {
+    "name": "messages",
+    "value": [
+      {
+        "role": "user",
+        "content": "What is the weather like today in San Francisco?"
+      }
+    ]
+  },
+  { "name": "run_immediately", "value": true }
+])";
+
+// Builds the whole message and serializes it, as `send_message()` callers do.
+static std::string build_and_dump(const nlohmann::json& arguments) {
+    nlohmann::json message = {
+            {"id", "d6c1d1ee-6a7f-4a0e-a4c3-3f2b7d1c9e55"},
+            {"label", "rtvi-ai"},
+            {"type", "action"},
+            {"data",
+             {{"service", "llm"},
+              {"action", "append_to_messages"},
+              {"arguments", arguments}}}
+    };
+    return message.dump();
+}
+
+template <typename Function>
+static void run(const char* name, Function&& function) {
+    function();
+    bench::report("templates", name, bench::measure_ns(ITERATIONS, function));
+    bench::report_allocations(
+            "templates", name, bench::count_allocations(function)
+    );
+}
+
+void bench::templates() {
+    nlohmann::json arguments = nlohmann::json::parse(ARGUMENTS);
+    std::string serialized_arguments = arguments.dump();
+
+    rtvi::DailyMessageTemplate action({
+            {"id", "{{id}}"},
+            {"label", "rtvi-ai"},
+            {"type", "action"},
+            {"data",
+             {{"service", "llm"},
+              {"action", "append_to_messages"},
+              {"arguments", "{{arguments}}"}}}
+    });
+    std::string id = rtvi::DailyMessageTemplate::quote(
+            "d6c1d1ee-6a7f-4a0e-a4c3-3f2b7d1c9e55"
+    );
+
+    run("build + dump", [&] { keep(build_and_dump(arguments)); });
+    run("render (dump arguments)", [&] {
+        keep(action.render({id, arguments.dump()}));
+    });
+    run("render (serialized arguments)", [&] {
+        keep(action.render({id, serialized_arguments}));
+    });
+}
@@ -0,0 +1,52 @@
+# DailyPipecatOptimization.cmake
+#
+# This module defines:
+#   daily_pipecat_optimize(target)
+#
+# which enables link-time and profile-guided optimization on the given
+# library target, as selected by DAILY_PIPECAT_LTO, DAILY_PIPECAT_PGO and
+# DAILY_PIPECAT_PGO_DIR. It is shared by the library and the benchmarks.
+#
+
+function(daily_pipecat_optimize target)
+  if(DAILY_PIPECAT_LTO)
+    include(CheckIPOSupported)
+    check_ipo_supported(RESULT LTO_SUPPORTED OUTPUT LTO_ERROR)
+    if(LTO_SUPPORTED)
+      set_target_properties(${target} PROPERTIES
+        INTERPROCEDURAL_OPTIMIZATION TRUE
+      )
+    else()
+      message(WARNING "Link-time optimization not supported: ${LTO_ERROR}")
+    endif()
+  endif()
+
+  if(DAILY_PIPECAT_PGO)
+    if(NOT CMAKE_CXX_COMPILER_ID MATCHES "GNU|Clang")
+      message(FATAL_ERROR "Profile-guided optimization requires GCC or Clang")
+    endif()
+
+    if(DAILY_PIPECAT_PGO STREQUAL "GENERATE")
+      target_compile_options(${target}
+        PRIVATE -fprofile-generate=${DAILY_PIPECAT_PGO_DIR}
+      )
+      target_link_options(${target}
+        PUBLIC -fprofile-generate=${DAILY_PIPECAT_PGO_DIR}
+      )
+    elseif(DAILY_PIPECAT_PGO STREQUAL "USE")
+      if(CMAKE_CXX_COMPILER_ID MATCHES "Clang")
+        # Raw profiles need to be merged first with:
+        #   llvm-profdata merge -o default.profdata *.profraw
+        target_compile_options(${target}
+          PRIVATE -fprofile-use=${DAILY_PIPECAT_PGO_DIR}/default.profdata
+        )
+      else()
+        target_compile_options(${target}
+          PRIVATE -fprofile-use=${DAILY_PIPECAT_PGO_DIR} -fprofile-correction
+        )
+      endif()
+    else()
+      message(FATAL_ERROR "Invalid DAILY_PIPECAT_PGO: ${DAILY_PIPECAT_PGO}")
+    endif()
+  endif()
+endfunction()
@@ -0,0 +1,11 @@
+# Cross-compilation system information.
+set(CMAKE_SYSTEM_NAME Linux)
+set(CMAKE_SYSTEM_PROCESSOR aarch64)
+
+set(CMAKE_LIBRARY_ARCHITECTURE aarch64-linux-gnu)
+
+set(CMAKE_C_COMPILER aarch64-linux-gnu-gcc)
+set(CMAKE_CXX_COMPILER aarch64-linux-gnu-g++)
+#set(CMAKE_LINKER aarch64-linux-gnu-ld)
+
+set(CMAKE_FIND_ROOT_PATH_MODE_PROGRAM NEVER)
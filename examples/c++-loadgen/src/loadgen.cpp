@@ -0,0 +1,785 @@
+//
+// Copyright (c) 2024, Daily
+//
+
+#include "daily_rtvi.h"
+
+#include <signal.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <random>
+#include <sstream>
+
+#ifndef _WIN32
+#include <sys/resource.h>
+#include <time.h>
+#endif
+
+using Clock = std::chrono::steady_clock;
+
+static const uint32_t SAMPLE_RATE = 16000;
+static const size_t BLOCK_FRAMES = SAMPLE_RATE / 100;
+static const double PI = 3.14159265358979323846;
+
+static std::atomic<bool> running(true);
+
+static double elapsed_ms(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start)
+            .count();
+}
+
+// Process CPU time (user + system) in seconds.
+static double process_cpu_seconds() {
+#ifndef _WIN32
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_utime.tv_sec + usage.ru_utime.tv_usec / 1e6 +
+           usage.ru_stime.tv_sec + usage.ru_stime.tv_usec / 1e6;
+#else
+    return 0.0;
+#endif
+}
+
+// CPU time of the calling thread in seconds.
+static double thread_cpu_seconds() {
+#ifndef _WIN32
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+#else
+    return 0.0;
+#endif
+}
+
+// Resident memory in bytes.
+static uint64_t resident_memory() {
+#if defined(__linux__)
+    std::ifstream statm("/proc/self/statm");
+    uint64_t size = 0;
+    uint64_t resident = 0;
+    statm >> size >> resident;
+    return resident * sysconf(_SC_PAGESIZE);
+#elif !defined(_WIN32)
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    // Peak resident memory, in bytes on macOS.
+    return usage.ru_maxrss;
+#else
+    return 0;
+#endif
+}
+
+class Latencies {
+   public:
+    void add(double value) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _values.push_back(value);
+    }
+
+    void print(const std::string& name, const char* unit = "ms") {
+        std::lock_guard<std::mutex> lock(_mutex);
+
+        std::cout << "  " << std::left << std::setw(16) << name;
+
+        if (_values.empty()) {
+            std::cout << "no samples" << std::endl;
+            return;
+        }
+
+        std::vector<double> sorted = _values;
+        std::sort(sorted.begin(), sorted.end());
+
+        std::cout << std::fixed << std::setprecision(1)
+                  << "n=" << sorted.size()
+                  << " p50=" << percentile(sorted, 50) << unit
+                  << " p90=" << percentile(sorted, 90) << unit
+                  << " p99=" << percentile(sorted, 99) << unit
+                  << " max=" << sorted.back() << unit << std::endl;
+    }
+
+   private:
+    static double percentile(const std::vector<double>& sorted, double p) {
+        size_t rank = static_cast<size_t>(std::ceil(p / 100 * sorted.size()));
+        return sorted[std::max<size_t>(rank, 1) - 1];
+    }
+
+   private:
+    std::mutex _mutex;
+    std::vector<double> _values;
+};
+
+struct Stats {
+    std::atomic<uint32_t> connected {0};
+    std::atomic<uint32_t> errors {0};
+    std::atomic<uint64_t> frames_sent {0};
+    std::atomic<uint64_t> frames_read {0};
+    std::atomic<uint64_t> actions {0};
+    // Stress mode: connect/disconnect cycles and messages sent.
+    std::atomic<uint64_t> cycles {0};
+    std::atomic<uint64_t> messages {0};
+    Latencies connect;
+    Latencies disconnect;
+    Latencies bot_ready;
+    Latencies action;
+    Latencies audio_cpu;
+    // How late audio threads wake up for each 10ms block.
+    Latencies audio_wakeup;
+    // Memory used by each transport itself (see
+    // `DailyTransport::memory_report()`), in KiB.
+    Latencies transport_memory;
+    // Average processing time of a 10ms block per stage (one sample per
+    // session).
+    std::mutex stages_mutex;
+    std::map<std::string, Latencies> stages;
+};
+
+struct ScriptStep {
+    uint32_t delay_ms;
+    nlohmann::json action;
+};
+
+struct LoadgenOptions {
+    std::string url;
+    nlohmann::json config;
+    uint32_t num_sessions;
+    uint32_t duration_s;
+    uint32_t ramp_ms;
+    bool audio_processing;
+    // Only run the audio loops, without connecting, to measure scheduling
+    // latency.
+    bool latency_only;
+    // Busy threads competing with the audio threads.
+    uint32_t load_threads;
+    // Reconnect over and over, keeping each connection for up to this many
+    // ms, while audio and messages keep flowing. 0 disables stress mode.
+    uint32_t stress_ms;
+    rtvi::DailyThreadConfig audio_thread;
+    // Shared by all the sessions.
+    std::shared_ptr<const rtvi::DailyTransportParams> transport_params;
+    std::shared_ptr<std::vector<int16_t>> audio;
+    std::vector<ScriptStep> script;
+};
+
+class Session : public rtvi::RTVIEventCallbacks {
+   public:
+    Session(uint32_t id, const LoadgenOptions& options, Stats& stats)
+        : _id(id), _options(options), _stats(stats) {
+        auto endpoints = rtvi::RTVIClientEndpoints {.connect = options.url};
+
+        auto params = rtvi::RTVIClientParams {
+                .endpoints = endpoints,
+                .request = options.config,
+                .headers = headers()
+        };
+
+        auto client_options =
+                rtvi::RTVIClientOptions {.params = params, .callbacks = this};
+
+        _client = std::make_unique<rtvi::DailyVoiceClient>(
+                client_options, options.transport_params
+        );
+    }
+
+    virtual ~Session() {}
+
+    void start() { _thread = std::thread(&Session::run, this); }
+
+    void join() {
+        if (_thread.joinable()) {
+            _thread.join();
+        }
+    }
+
+    // RTVIEventCallbacks
+
+    void on_bot_ready() override {
+        if (_options.stress_ms == 0) {
+            _stats.bot_ready.add(elapsed_ms(_connect_start));
+        }
+    }
+
+    void on_error(const nlohmann::json& error) override { _stats.errors++; }
+
+   private:
+    static std::vector<std::string> headers() {
+        std::vector<std::string> headers;
+        const char* api_key = std::getenv("DAILY_BOTS_API_KEY");
+        if (api_key) {
+            std::stringstream auth;
+            auth << "Authorization: Bearer " << api_key;
+            headers.push_back(auth.str());
+        }
+        return headers;
+    }
+
+    void run() {
+        rtvi::daily_configure_thread(
+                "audio-" + std::to_string(_id), _options.audio_thread
+        );
+
+        _connect_start = Clock::now();
+
+        if (_options.latency_only) {
+            audio_loop();
+            return;
+        }
+
+        if (_options.stress_ms > 0) {
+            stress();
+            return;
+        }
+
+        try {
+            _client->initialize();
+            _client->connect();
+        } catch (const std::exception& ex) {
+            std::cerr << "session " << _id << ": unable to connect: "
+                      << ex.what() << std::endl;
+            _stats.errors++;
+            return;
+        }
+
+        _stats.connect.add(elapsed_ms(_connect_start));
+        _stats.connected++;
+
+        std::thread script_thread(&Session::script_thread, this);
+
+        audio_loop();
+
+        script_thread.join();
+
+        add_stage_stats();
+
+        rtvi::DailyMemoryReport memory =
+                _client->transport()->memory_report();
+        _stats.transport_memory.add(memory.total() / 1024.0);
+
+        _client->disconnect();
+    }
+
+    // Connects and disconnects over and over from one thread, while the
+    // audio loop and a message thread keep calling into the client whether
+    // it's connected or not. Timings are random, so every run exercises
+    // different interleavings with daily-core events.
+    void stress() {
+        try {
+            _client->initialize();
+        } catch (const std::exception& ex) {
+            std::cerr << "session " << _id << ": unable to initialize: "
+                      << ex.what() << std::endl;
+            _stats.errors++;
+            return;
+        }
+
+        std::thread connect_thread(&Session::stress_connect_thread, this);
+        std::thread message_thread(&Session::stress_message_thread, this);
+
+        audio_loop();
+
+        message_thread.join();
+        connect_thread.join();
+    }
+
+    void stress_connect_thread() {
+        std::mt19937 random(_id);
+        std::uniform_int_distribution<uint32_t> hold_ms(0, _options.stress_ms);
+
+        auto end = _connect_start + std::chrono::seconds(_options.duration_s);
+        bool connected = false;
+
+        while (running && Clock::now() < end) {
+            auto start = Clock::now();
+            try {
+                _client->connect();
+                _stats.connect.add(elapsed_ms(start));
+                if (!connected) {
+                    _stats.connected++;
+                    connected = true;
+                }
+            } catch (const std::exception& ex) {
+                _stats.errors++;
+            }
+
+            std::this_thread::sleep_for(
+                    std::chrono::milliseconds(hold_ms(random))
+            );
+
+            start = Clock::now();
+            _client->disconnect();
+            _stats.disconnect.add(elapsed_ms(start));
+            _stats.cycles++;
+
+            std::this_thread::sleep_for(
+                    std::chrono::milliseconds(hold_ms(random) / 4)
+            );
+        }
+    }
+
+    // Sends the script actions (or "client-ready" messages without a script)
+    // in every priority lane at random times.
+    void stress_message_thread() {
+        std::mt19937 random(_id + _options.num_sessions);
+        std::uniform_int_distribution<uint32_t> pause_ms(0, 50);
+        std::uniform_int_distribution<size_t> priority(
+                0, rtvi::DAILY_MESSAGE_PRIORITIES - 1
+        );
+
+        auto end = _connect_start + std::chrono::seconds(_options.duration_s);
+        nlohmann::json client_ready = rtvi::RTVIMessage::client_ready();
+        size_t step = 0;
+
+        while (running && Clock::now() < end) {
+            const nlohmann::json& message =
+                    _options.script.empty()
+                            ? client_ready
+                            : _options.script[step++ % _options.script.size()]
+                                      .action;
+
+            _client->transport()->send_message(
+                    message,
+                    static_cast<rtvi::DailyMessagePriority>(priority(random))
+            );
+            _stats.messages++;
+
+            std::this_thread::sleep_for(
+                    std::chrono::milliseconds(pause_ms(random))
+            );
+        }
+    }
+
+    // Sends a 10ms block of user audio and drains bot audio at real-time
+    // rate until the test is over.
+    void audio_loop() {
+        const std::vector<int16_t>& audio = *_options.audio;
+        int16_t bot_audio[BLOCK_FRAMES];
+        size_t position = 0;
+
+        double cpu_start = thread_cpu_seconds();
+
+        auto end = _connect_start + std::chrono::seconds(_options.duration_s);
+        auto next = Clock::now();
+
+        while (running && Clock::now() < end) {
+            if (!_options.latency_only) {
+                if (position + BLOCK_FRAMES > audio.size()) {
+                    position = 0;
+                }
+
+                int32_t sent = _client->send_user_audio(
+                        audio.data() + position, BLOCK_FRAMES
+                );
+                position += BLOCK_FRAMES;
+                if (sent > 0) {
+                    _stats.frames_sent += sent;
+                }
+
+                int32_t read;
+                while ((read = _client->read_bot_audio(
+                                bot_audio, BLOCK_FRAMES
+                        )) > 0) {
+                    _stats.frames_read += read;
+                }
+            }
+
+            next += std::chrono::milliseconds(10);
+            std::this_thread::sleep_until(next);
+
+            auto late = Clock::now() - next;
+            _stats.audio_wakeup.add(
+                    std::chrono::duration<double, std::micro>(late).count()
+            );
+        }
+
+        _stats.audio_cpu.add((thread_cpu_seconds() - cpu_start) * 1000);
+    }
+
+    void add_stage_stats() {
+        rtvi::DailyAudioProcessor* processor =
+                _client->transport()->user_audio_processor();
+        if (!processor) {
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(_stats.stages_mutex);
+        for (const std::string& name : processor->stage_names()) {
+            rtvi::DailyAudioStageStats stage = processor->stage_stats(name);
+            if (stage.blocks > 0) {
+                _stats.stages[name].add(stage.total_ns / stage.blocks / 1e3);
+            }
+        }
+    }
+
+    void script_thread() {
+        auto end = _connect_start + std::chrono::seconds(_options.duration_s);
+
+        for (const ScriptStep& step : _options.script) {
+            auto at = Clock::now() + std::chrono::milliseconds(step.delay_ms);
+            while (running && Clock::now() < std::min(at, end)) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            }
+            if (!running || Clock::now() >= end) {
+                return;
+            }
+
+            auto start = Clock::now();
+            try {
+                _client->send_action(step.action);
+                _stats.action.add(elapsed_ms(start));
+                _stats.actions++;
+            } catch (const std::exception& ex) {
+                _stats.errors++;
+            }
+        }
+    }
+
+   private:
+    uint32_t _id;
+    const LoadgenOptions& _options;
+    Stats& _stats;
+    Clock::time_point _connect_start;
+    std::thread _thread;
+    std::unique_ptr<rtvi::DailyVoiceClient> _client;
+};
+
+// Two seconds of a 220 Hz tone followed by two seconds of silence, so bots
+// see turns.
+static std::shared_ptr<std::vector<int16_t>> synthetic_audio() {
+    auto audio = std::make_shared<std::vector<int16_t>>(SAMPLE_RATE * 4, 0);
+    for (size_t i = 0; i < SAMPLE_RATE * 2; ++i) {
+        double t = double(i) / SAMPLE_RATE;
+        (*audio)[i] = static_cast<int16_t>(8000 * std::sin(2 * PI * 220 * t));
+    }
+    return audio;
+}
+
+// Raw 16-bit 16 kHz mono PCM.
+static std::shared_ptr<std::vector<int16_t>> file_audio(const char* path) {
+    std::ifstream input(path, std::ios::binary | std::ios::ate);
+    if (!input.is_open()) {
+        throw std::runtime_error(std::string("unable to open ") + path);
+    }
+
+    size_t size = input.tellg();
+    input.seekg(0);
+
+    auto audio = std::make_shared<std::vector<int16_t>>(size / 2);
+    input.read(reinterpret_cast<char*>(audio->data()), audio->size() * 2);
+
+    if (audio->size() < BLOCK_FRAMES) {
+        throw std::runtime_error(std::string("audio file too short: ") + path);
+    }
+
+    return audio;
+}
+
+static nlohmann::json read_json(const char* path) {
+    std::ifstream input(path);
+    if (!input.is_open()) {
+        throw std::runtime_error(std::string("unable to open ") + path);
+    }
+
+    nlohmann::json json;
+    input >> json;
+    return json;
+}
+
+static void print_report(
+        const LoadgenOptions& options,
+        Stats& stats,
+        double seconds,
+        double cpu_seconds,
+        uint64_t idle_memory,
+        uint64_t memory
+) {
+    uint32_t sessions = std::max<uint32_t>(stats.connected, 1);
+    uint32_t idle_sessions = std::max<uint32_t>(options.num_sessions, 1);
+
+    std::cout << std::endl << "Sessions" << std::endl;
+    std::cout << "  requested       " << options.num_sessions << std::endl;
+    std::cout << "  connected       " << stats.connected << std::endl;
+    std::cout << "  errors          " << stats.errors << std::endl;
+
+    std::cout << std::fixed << std::setprecision(2);
+
+    std::cout << std::endl << "Throughput" << std::endl;
+    std::cout << "  user audio      "
+              << stats.frames_sent / seconds / SAMPLE_RATE << " s/s ("
+              << stats.frames_sent << " frames)" << std::endl;
+    std::cout << "  bot audio       "
+              << stats.frames_read / seconds / SAMPLE_RATE << " s/s ("
+              << stats.frames_read << " frames)" << std::endl;
+    std::cout << "  actions         " << stats.actions / seconds << " /s"
+              << std::endl;
+    if (options.stress_ms > 0) {
+        std::cout << "  reconnections   " << stats.cycles / seconds << " /s ("
+                  << stats.cycles << ")" << std::endl;
+        std::cout << "  messages        " << stats.messages / seconds << " /s"
+                  << std::endl;
+    }
+
+    std::cout << std::endl << "Latency" << std::endl;
+    stats.connect.print("connect");
+    if (options.stress_ms > 0) {
+        stats.disconnect.print("disconnect");
+    }
+    stats.bot_ready.print("bot ready");
+    stats.action.print("action");
+    stats.audio_wakeup.print("audio wakeup", "us");
+
+    std::cout << std::endl << "Resources per session" << std::endl;
+    std::cout << "  process CPU     " << cpu_seconds / seconds / sessions * 100
+              << " %" << std::endl;
+    stats.audio_cpu.print("audio thread");
+    std::cout << "  idle memory     " << idle_memory / idle_sessions / 1024
+              << " KiB" << std::endl;
+    std::cout << "  active memory   " << memory / sessions / 1024 << " KiB"
+              << std::endl;
+    stats.transport_memory.print("transport", "KiB");
+
+    if (!stats.stages.empty()) {
+        std::cout << std::endl
+                  << "Audio processing (per 10ms block)" << std::endl;
+        for (auto& [name, stage] : stats.stages) {
+            stage.print(name, "us");
+        }
+    }
+}
+
+static void signal_handler(int signum) {
+    running = false;
+}
+
+static void usage() {
+    std::cout << "Usage: loadgen -b URL -c CONFIG_FILE [OPTIONS]" << std::endl;
+    std::cout << "  -b    Daily Bots URL" << std::endl;
+    std::cout << "  -c    Configuration file" << std::endl;
+    std::cout << "  -n    Number of sessions (default: 10)" << std::endl;
+    std::cout << "  -d    Duration in seconds (default: 60)" << std::endl;
+    std::cout << "  -r    Delay between session starts in ms (default: 100)"
+              << std::endl;
+    std::cout << "  -a    Raw 16-bit 16 kHz mono audio file (default: tone)"
+              << std::endl;
+    std::cout << "  -s    Actions script file" << std::endl;
+    std::cout << "  -p    Process user audio (AEC, NS and AGC)" << std::endl;
+    std::cout << "  -t    Write a Chrome trace of the transports to a file"
+              << std::endl;
+    std::cout << "  -f    Real-time priority of audio threads (1-99)"
+              << std::endl;
+    std::cout << "  -C    CPUs for audio threads (e.g. 0,2-3)" << std::endl;
+    std::cout << "  -x    Number of busy threads to add CPU load" << std::endl;
+    std::cout << "  -l    Only measure audio thread scheduling latency (no "
+                 "connections)"
+              << std::endl;
+    std::cout << "  -S    Stress mode: reconnect continuously, holding each "
+                 "connection up to N ms"
+              << std::endl;
+}
+
+// Parses a CPU list like "0,2-3".
+static std::vector<uint32_t> parse_cpus(const std::string& list) {
+    std::vector<uint32_t> cpus;
+    std::stringstream input(list);
+    std::string range;
+    while (std::getline(input, range, ',')) {
+        size_t dash = range.find('-');
+        uint32_t first = std::stoul(range.substr(0, dash));
+        uint32_t last = dash == std::string::npos
+                                ? first
+                                : std::stoul(range.substr(dash + 1));
+        for (uint32_t cpu = first; cpu <= last; ++cpu) {
+            cpus.push_back(cpu);
+        }
+    }
+    return cpus;
+}
+
+// Synthetic CPU load, until `loading` is cleared.
+static void load_thread(const std::atomic<bool>& loading) {
+    volatile uint64_t counter = 0;
+    while (loading) {
+        for (uint32_t i = 0; i < 1000000; ++i) {
+            counter = counter + i;
+        }
+    }
+}
+
+int main(int argc, char* argv[]) {
+    char* url = nullptr;
+    char* config_file = nullptr;
+    char* audio_file = nullptr;
+    char* script_file = nullptr;
+    char* trace_file = nullptr;
+
+    LoadgenOptions options = {
+            .num_sessions = 10,
+            .duration_s = 60,
+            .ramp_ms = 100,
+            .audio_processing = false,
+            .latency_only = false,
+            .load_threads = 0,
+            .stress_ms = 0
+    };
+
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "-b") == 0 && i + 1 < argc) {
+            url = argv[++i];
+        } else if (strcmp(argv[i], "-c") == 0 && i + 1 < argc) {
+            config_file = argv[++i];
+        } else if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+            options.num_sessions = std::stoul(argv[++i]);
+        } else if (strcmp(argv[i], "-d") == 0 && i + 1 < argc) {
+            options.duration_s = std::stoul(argv[++i]);
+        } else if (strcmp(argv[i], "-r") == 0 && i + 1 < argc) {
+            options.ramp_ms = std::stoul(argv[++i]);
+        } else if (strcmp(argv[i], "-a") == 0 && i + 1 < argc) {
+            audio_file = argv[++i];
+        } else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+            script_file = argv[++i];
+        } else if (strcmp(argv[i], "-p") == 0) {
+            options.audio_processing = true;
+        } else if (strcmp(argv[i], "-t") == 0 && i + 1 < argc) {
+            trace_file = argv[++i];
+        } else if (strcmp(argv[i], "-f") == 0 && i + 1 < argc) {
+            options.audio_thread.realtime_priority = std::stoi(argv[++i]);
+        } else if (strcmp(argv[i], "-C") == 0 && i + 1 < argc) {
+            options.audio_thread.cpus = parse_cpus(argv[++i]);
+        } else if (strcmp(argv[i], "-x") == 0 && i + 1 < argc) {
+            options.load_threads = std::stoul(argv[++i]);
+        } else if (strcmp(argv[i], "-l") == 0) {
+            options.latency_only = true;
+        } else if (strcmp(argv[i], "-S") == 0 && i + 1 < argc) {
+            options.stress_ms = std::stoul(argv[++i]);
+        } else {
+            usage();
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (!options.latency_only && (url == nullptr || config_file == nullptr)) {
+        usage();
+        return EXIT_SUCCESS;
+    }
+
+    try {
+        options.url = url ? url : "";
+        options.config = config_file ? read_json(config_file) : nullptr;
+        options.audio = audio_file ? file_audio(audio_file) : synthetic_audio();
+
+        if (script_file) {
+            for (const auto& step : read_json(script_file)) {
+                options.script.push_back(
+                        {.delay_ms = step["delay_ms"].get<uint32_t>(),
+                         .action = rtvi::RTVIMessage::action(
+                                 step["action"]["service"],
+                                 step["action"]["action"],
+                                 step["action"]["arguments"]
+                         )}
+                );
+            }
+        }
+    } catch (const std::exception& ex) {
+        std::cerr << std::endl << "ERROR: " << ex.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    signal(SIGINT, signal_handler);
+    signal(SIGTERM, signal_handler);
+
+    options.transport_params =
+            std::make_shared<const rtvi::DailyTransportParams>(
+                    rtvi::DailyTransportParams {
+                            .user_audio_sample_rate = SAMPLE_RATE,
+                            .user_audio_channels = 1,
+                            .bot_audio_sample_rate = SAMPLE_RATE,
+                            .bot_audio_channels = 1,
+                            .user_audio_processing = options.audio_processing,
+                            .audio_thread_config = options.audio_thread
+                    }
+            );
+
+    rtvi::DailyTransport::warm_up();
+
+    if (trace_file) {
+        rtvi::DailyTracer::instance().start();
+    }
+
+    std::atomic<bool> loading(true);
+    std::vector<std::thread> load_threads;
+    for (uint32_t i = 0; i < options.load_threads; ++i) {
+        load_threads.emplace_back(load_thread, std::cref(loading));
+    }
+
+    Stats stats;
+    std::vector<std::unique_ptr<Session>> sessions;
+
+    uint64_t memory_start = resident_memory();
+
+    // Create all the sessions before starting any, so the memory of idle
+    // (created but not connected) sessions can be measured.
+    for (uint32_t i = 0; i < options.num_sessions; ++i) {
+        sessions.push_back(std::make_unique<Session>(i, options, stats));
+    }
+
+    uint64_t idle_memory = resident_memory();
+
+    double cpu_start = process_cpu_seconds();
+    auto start = Clock::now();
+
+    std::cout << "Starting " << options.num_sessions << " sessions..."
+              << std::endl;
+
+    for (auto& session : sessions) {
+        if (!running) {
+            break;
+        }
+        session->start();
+        std::this_thread::sleep_for(std::chrono::milliseconds(options.ramp_ms));
+    }
+
+    // Sample memory while all the sessions are active.
+    uint64_t memory = 0;
+    auto ramp = std::chrono::milliseconds(options.ramp_ms);
+    auto end = start + std::chrono::seconds(options.duration_s) +
+               ramp * options.num_sessions;
+    while (running && Clock::now() < end) {
+        std::this_thread::sleep_for(std::chrono::seconds(1));
+        memory = std::max(memory, resident_memory());
+    }
+
+    for (auto& session : sessions) {
+        session->join();
+    }
+
+    loading = false;
+    for (std::thread& thread : load_threads) {
+        thread.join();
+    }
+
+    double seconds = elapsed_ms(start) / 1000;
+    double cpu_seconds = process_cpu_seconds() - cpu_start;
+
+    if (trace_file) {
+        rtvi::DailyTracer::instance().stop();
+        if (!rtvi::DailyTracer::instance().write_chrome_trace(trace_file)) {
+            std::cerr << "ERROR: unable to write " << trace_file << std::endl;
+        }
+    }
+
+    print_report(
+            options,
+            stats,
+            seconds,
+            cpu_seconds,
+            idle_memory > memory_start ? idle_memory - memory_start : 0,
+            memory > memory_start ? memory - memory_start : 0
+    );
+
+    return EXIT_SUCCESS;
+}
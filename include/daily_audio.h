@@ -0,0 +1,84 @@
+//
+// Copyright (c) 2024, Daily
+//
+
+#ifndef DAILY_AUDIO_H
+#define DAILY_AUDIO_H
+
+#include "daily_pipecat_export.h"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace rtvi {
+
+//
+// PCM utility kernels. The best implementation for the running CPU (AVX2,
+// SSE2, NEON or scalar) is selected the first time any of them is used.
+//
+
+// Returns the name of the selected implementation (e.g. "avx2").
+DAILY_PIPECAT_EXPORT const char* audio_kernels_name();
+
+// Forces an implementation ("scalar", "sse2", "avx2" or "neon"), e.g. to
+// compare them in tests and benchmarks. Returns false if it's not supported
+// by the running CPU. Should not be called while audio is being processed.
+DAILY_PIPECAT_EXPORT bool audio_select_kernels(const char* name);
+
+// Returns the absolute peak of the given samples (0 to 32768).
+DAILY_PIPECAT_EXPORT uint32_t
+audio_peak(const int16_t* samples, size_t num_samples);
+
+// Returns the sum of the squared samples (e.g. to compute RMS levels).
+DAILY_PIPECAT_EXPORT uint64_t
+audio_sum_squares(const int16_t* samples, size_t num_samples);
+
+// Multiplies the samples by the given gain in place, saturating to the int16
+// range (NaN results become 0).
+DAILY_PIPECAT_EXPORT void
+audio_gain(int16_t* samples, size_t num_samples, float gain);
+
+// Adds `src` into `dst`, saturating to the int16 range.
+DAILY_PIPECAT_EXPORT void
+audio_mix(int16_t* dst, const int16_t* src, size_t num_samples);
+
+// Converts float samples in the [-1.0, 1.0] range to int16. Values out of
+// range are clipped and NaN becomes 0.
+DAILY_PIPECAT_EXPORT void
+audio_float_to_int16(const float* src, int16_t* dst, size_t num_samples);
+
+// Converts int16 samples to float samples in the [-1.0, 1.0) range.
+DAILY_PIPECAT_EXPORT void
+audio_int16_to_float(const int16_t* src, float* dst, size_t num_samples);
+
+// Averages interleaved stereo frames into mono.
+DAILY_PIPECAT_EXPORT void
+audio_stereo_to_mono(const int16_t* src, int16_t* dst, size_t num_frames);
+
+// Duplicates mono frames into interleaved stereo.
+DAILY_PIPECAT_EXPORT void
+audio_mono_to_stereo(const int16_t* src, int16_t* dst, size_t num_frames);
+
+// Converts planar float samples (`num_channels` planes starting every
+// `plane_stride` samples) to interleaved int16 frames.
+DAILY_PIPECAT_EXPORT void audio_planar_float_to_int16(
+        const float* src,
+        int16_t* dst,
+        size_t num_frames,
+        uint32_t num_channels,
+        size_t plane_stride
+);
+
+// Converts interleaved int16 frames to planar float samples (`num_channels`
+// planes starting every `plane_stride` samples).
+DAILY_PIPECAT_EXPORT void audio_int16_to_planar_float(
+        const int16_t* src,
+        float* dst,
+        size_t num_frames,
+        uint32_t num_channels,
+        size_t plane_stride
+);
+
+}  // namespace rtvi
+
+#endif
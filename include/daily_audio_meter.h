@@ -0,0 +1,74 @@
+//
+// Copyright (c) 2024, Daily
+//
+
+#ifndef DAILY_AUDIO_METER_H
+#define DAILY_AUDIO_METER_H
+
+#include "daily_pipecat_export.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace rtvi {
+
+struct DailyAudioLevels {
+    // Levels of the last 10ms block, from 0 to 1 (full scale).
+    float rms;
+    float peak;
+    bool speaking;
+};
+
+// Measures the RMS and peak levels of every 10ms block of an audio stream and
+// tracks whether someone is speaking. Levels are published through atomics,
+// so they can be read from any thread without blocking the audio thread.
+class DAILY_PIPECAT_EXPORT DailyAudioMeter {
+   public:
+    // Speech starts when a block's RMS level reaches `speaking_threshold_dbfs`
+    // and stops after `speaking_hangover_ms` of blocks below it. Nothing is
+    // measured if a block has no samples (i.e. below 100 Hz or without
+    // channels).
+    DailyAudioMeter(
+            uint32_t sample_rate,
+            uint32_t num_channels,
+            float speaking_threshold_dbfs,
+            uint32_t speaking_hangover_ms
+    );
+
+    // Measures interleaved frames. Frames that don't complete a block are
+    // kept in the running sums until the next call. Returns true if the
+    // speaking state changed. Should be called from a single thread.
+    bool process(const int16_t* frames, size_t num_frames);
+
+    DailyAudioLevels levels() const;
+
+    bool speaking() const { return _speaking.load(std::memory_order_relaxed); }
+
+    // Blocks measured so far.
+    uint64_t blocks() const { return _blocks.load(std::memory_order_relaxed); }
+
+   private:
+    bool finish_block();
+
+   private:
+    uint32_t _num_channels;
+    size_t _block_samples;
+    float _speaking_threshold;
+    uint32_t _hangover_blocks;
+
+    // Current block, only used by the audio thread.
+    size_t _block_filled;
+    uint64_t _sum_squares;
+    uint32_t _peak;
+    uint32_t _quiet_blocks;
+
+    std::atomic<float> _rms_level;
+    std::atomic<float> _peak_level;
+    std::atomic<bool> _speaking;
+    std::atomic<uint64_t> _blocks;
+};
+
+}  // namespace rtvi
+
+#endif
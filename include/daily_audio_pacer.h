@@ -0,0 +1,109 @@
+//
+// Copyright (c) 2024, Daily
+//
+
+#ifndef DAILY_AUDIO_PACER_H
+#define DAILY_AUDIO_PACER_H
+
+#include "daily_pipecat_export.h"
+#include "daily_thread.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace rtvi {
+
+struct DailyAudioPacerStats {
+    // Frames accepted by the writer.
+    uint64_t frames_written;
+    // Frames waiting to be written.
+    uint64_t frames_queued;
+    // Frames the writer failed to write, which are discarded.
+    uint64_t frames_dropped;
+    // Writes that failed.
+    uint64_t write_errors;
+    // Times the queued audio ran out and the pacer waited for more.
+    uint64_t idle_ticks;
+    // How late the pacer thread woke up compared to its schedule.
+    uint64_t max_lateness_us;
+    // Times the pacer fell too far behind and restarted its schedule instead
+    // of bursting to catch up.
+    uint64_t resyncs;
+};
+
+// Queues audio of any size and hands it to a writer in 10ms blocks at
+// real-time rate (or faster, with `speed` > 1). Blocks are scheduled against
+// absolute deadlines of a monotonic clock, so wake-up jitter doesn't
+// accumulate into drift. The pacer thread sleeps while there's no audio
+// queued, and the schedule starts again with the next audio.
+class DAILY_PIPECAT_EXPORT DailyAudioPacer {
+   public:
+    // Returns the number of frames written, or a negative value on error.
+    using Writer =
+            std::function<int32_t(const int16_t* frames, size_t num_frames)>;
+
+    DailyAudioPacer(
+            uint32_t sample_rate,
+            uint32_t num_channels,
+            Writer writer,
+            const DailyThreadConfig& thread_config = {}
+    );
+
+    ~DailyAudioPacer();
+
+    void start(double speed);
+
+    // Stops the pacer thread and discards queued audio.
+    void stop();
+
+    // Queues interleaved frames. Never blocks on the writer.
+    void push(const int16_t* frames, size_t num_frames);
+
+    // Discards queued audio (e.g. when the user interrupts the bot).
+    void clear();
+
+    size_t queued_frames() const;
+
+    // Memory used by queued audio, in bytes.
+    size_t memory_bytes() const;
+
+    DailyAudioPacerStats stats() const;
+
+   private:
+    size_t pop_block();
+    void pace_thread(std::chrono::nanoseconds period);
+
+   private:
+    uint32_t _num_channels;
+    size_t _block_frames;
+    Writer _writer;
+    DailyThreadConfig _thread_config;
+
+    // Queued samples start at `_queue_offset`.
+    mutable std::mutex _mutex;
+    std::condition_variable _cv;
+    std::vector<int16_t> _queue;
+    size_t _queue_offset;
+
+    std::vector<int16_t> _block;
+
+    std::thread _thread;
+    bool _running;
+
+    std::atomic<uint64_t> _frames_written;
+    std::atomic<uint64_t> _frames_dropped;
+    std::atomic<uint64_t> _write_errors;
+    std::atomic<uint64_t> _idle_ticks;
+    std::atomic<uint64_t> _max_lateness_us;
+    std::atomic<uint64_t> _resyncs;
+};
+
+}  // namespace rtvi
+
+#endif
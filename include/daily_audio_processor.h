@@ -0,0 +1,196 @@
+//
+// Copyright (c) 2024, Daily
+//
+
+#ifndef DAILY_AUDIO_PROCESSOR_H
+#define DAILY_AUDIO_PROCESSOR_H
+
+#include "daily_audio_ring.h"
+#include "daily_pipecat_export.h"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace rtvi {
+
+// A step of the user audio processing chain.
+class DAILY_PIPECAT_EXPORT DailyAudioStage {
+   public:
+    virtual ~DailyAudioStage() {}
+
+    virtual const char* name() const = 0;
+
+    // Frames of reference the stage keeps besides the current block (e.g. an
+    // echo canceller's tail). Older reference is useless to the stage.
+    virtual size_t reference_frames() const { return 0; }
+
+    // Processes a 10ms block of interleaved frames in place. `reference` is
+    // the (mono) bot audio read during the same block, which is silence if no
+    // bot audio is being read. Should not allocate or block.
+    virtual void process(
+            int16_t* frames,
+            size_t num_frames,
+            uint32_t num_channels,
+            const int16_t* reference
+    ) = 0;
+};
+
+// Acoustic echo canceller. Removes the bot audio that leaks back into the user
+// audio with a normalized least mean squares (NLMS) adaptive filter covering
+// `tail_ms` of echo path. The filter is limited to 1024 taps (64ms at 16 kHz
+// but only ~21ms at 48 kHz), since its cost grows with both the tail and the
+// sample rate. Only processes mono audio.
+class DAILY_PIPECAT_EXPORT DailyEchoCanceller : public DailyAudioStage {
+   public:
+    explicit DailyEchoCanceller(uint32_t sample_rate, uint32_t tail_ms = 64);
+
+    const char* name() const override { return "aec"; }
+
+    size_t reference_frames() const override { return _num_taps - 1; }
+
+    void process(
+            int16_t* frames,
+            size_t num_frames,
+            uint32_t num_channels,
+            const int16_t* reference
+    ) override;
+
+   private:
+    size_t _num_taps;
+    // Filter coefficients, stored in reverse order.
+    std::vector<float> _weights;
+    // The last `_num_taps - 1` reference samples followed by the current block.
+    std::vector<float> _history;
+    std::vector<float> _near;
+};
+
+// Broadband noise suppressor. Tracks the noise floor and attenuates blocks
+// that are close to it (e.g. background noise between utterances) by up to
+// `max_attenuation_db`.
+class DAILY_PIPECAT_EXPORT DailyNoiseSuppressor : public DailyAudioStage {
+   public:
+    explicit DailyNoiseSuppressor(float max_attenuation_db = 20.0f);
+
+    const char* name() const override { return "ns"; }
+
+    void process(
+            int16_t* frames,
+            size_t num_frames,
+            uint32_t num_channels,
+            const int16_t* reference
+    ) override;
+
+   private:
+    float _min_gain;
+    float _noise_floor;
+    float _gain;
+};
+
+// Automatic gain control. Brings speech to `target_dbfs` (RMS) with at most
+// `max_gain_db` of gain. Gain is reduced quickly and increased slowly.
+class DAILY_PIPECAT_EXPORT DailyGainControl : public DailyAudioStage {
+   public:
+    explicit DailyGainControl(
+            float target_dbfs = -20.0f,
+            float max_gain_db = 20.0f
+    );
+
+    const char* name() const override { return "agc"; }
+
+    void process(
+            int16_t* frames,
+            size_t num_frames,
+            uint32_t num_channels,
+            const int16_t* reference
+    ) override;
+
+   private:
+    float _target_rms;
+    float _max_gain;
+    float _gain;
+};
+
+struct DailyAudioStageStats {
+    // Blocks processed by the stage.
+    uint64_t blocks;
+    // Time spent processing a 10ms block.
+    uint64_t total_ns;
+    uint64_t max_ns;
+};
+
+// Runs user audio through a chain of stages in fixed 10ms blocks. Stages can
+// be enabled or disabled at any time, but need to be added before any audio
+// is processed.
+class DAILY_PIPECAT_EXPORT DailyAudioProcessor {
+   public:
+    DailyAudioProcessor(uint32_t sample_rate, uint32_t num_channels);
+
+    // Creates a processor with echo cancellation, noise suppression and gain
+    // control, in that order.
+    static std::unique_ptr<DailyAudioProcessor>
+    create_default(uint32_t sample_rate, uint32_t num_channels);
+
+    void add_stage(std::unique_ptr<DailyAudioStage> stage);
+
+    std::vector<std::string> stage_names() const;
+
+    // Returns false if there's no stage with the given name.
+    bool set_stage_enabled(const std::string& name, bool enabled);
+
+    DailyAudioStageStats stage_stats(const std::string& name) const;
+
+    size_t block_frames() const { return _block_frames; }
+
+    // Processes `num_frames` interleaved frames into `output`, which needs
+    // room for `num_frames + block_frames()` frames. Frames that don't fill a
+    // block are kept until the next call. Returns the number of frames
+    // written to `output`.
+    size_t process(const int16_t* frames, size_t num_frames, int16_t* output);
+
+    // Feeds the bot audio used as echo reference. Ignored if the sample rate
+    // doesn't match. Should be called from a single thread.
+    void add_reference(
+            const int16_t* frames,
+            size_t num_frames,
+            uint32_t sample_rate,
+            uint32_t num_channels
+    );
+
+   private:
+    struct Slot {
+        std::unique_ptr<DailyAudioStage> stage;
+        std::atomic<bool> enabled;
+        std::atomic<uint64_t> blocks;
+        std::atomic<uint64_t> total_ns;
+        std::atomic<uint64_t> max_ns;
+    };
+
+    Slot* find_slot(const std::string& name) const;
+    void process_block(int16_t* frames);
+
+   private:
+    uint32_t _sample_rate;
+    uint32_t _num_channels;
+    size_t _block_frames;
+
+    std::vector<std::unique_ptr<Slot>> _slots;
+
+    // Frames waiting for a full block.
+    std::vector<int16_t> _pending;
+    size_t _pending_frames;
+
+    // Reference frames kept beyond the blocks being processed, so bot audio
+    // read long before the user audio arrives is dropped.
+    size_t _max_reference_backlog;
+
+    DailyAudioRing _reference;
+    std::vector<int16_t> _reference_block;
+    std::vector<int16_t> _reference_mono;
+};
+
+}  // namespace rtvi
+
+#endif
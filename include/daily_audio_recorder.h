@@ -0,0 +1,109 @@
+//
+// Copyright (c) 2024, Daily
+//
+
+#ifndef DAILY_AUDIO_RECORDER_H
+#define DAILY_AUDIO_RECORDER_H
+
+#include "daily_audio_ring.h"
+#include "daily_pipecat_export.h"
+#include "daily_thread.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace rtvi {
+
+struct DailyRecordingStats {
+    // Frames written to the recording files (user and bot).
+    uint64_t frames_recorded;
+    // Frames dropped because the recording thread didn't keep up.
+    uint64_t dropped_frames;
+    // Size of the recording files.
+    uint64_t bytes_written;
+};
+
+// Records user and bot audio to IMA ADPCM WAV files (4 bits per sample, mono).
+// Audio with more than one channel is downmixed. The audio paths only copy
+// frames into lock-free ring buffers, encoding and (buffered) disk writes
+// happen on a recording thread.
+class DAILY_PIPECAT_EXPORT DailyAudioRecorder {
+   public:
+    struct Track {
+        // The track is not recorded if the path is empty or if it has no
+        // channels.
+        std::string path;
+        uint32_t sample_rate;
+        uint32_t num_channels;
+    };
+
+    DailyAudioRecorder(
+            const Track& user,
+            const Track& bot,
+            const DailyThreadConfig& thread_config = {}
+    );
+
+    ~DailyAudioRecorder();
+
+    // Creates (or truncates) the recording files and starts the recording
+    // thread. Returns false if any of the files can't be created.
+    bool start();
+
+    // Records the remaining audio, finishes the files and stops the recording
+    // thread.
+    void stop();
+
+    // These never block and should each be called from a single thread.
+    void record_user_audio(const int16_t* frames, size_t num_frames);
+    void record_bot_audio(const int16_t* frames, size_t num_frames);
+
+    DailyRecordingStats stats() const;
+
+   private:
+    struct TrackWriter {
+        explicit TrackWriter(const Track& track);
+
+        bool open();
+        void write(const int16_t* samples, size_t num_samples);
+        void close();
+        void encode_block(size_t num_samples);
+
+        bool used() const { return !track.path.empty(); }
+
+        Track track;
+        DailyAudioRing ring;
+        std::FILE* file;
+        // Mono samples waiting for a full ADPCM block.
+        std::vector<int16_t> pending;
+        std::vector<uint8_t> block;
+        int32_t step_index;
+        std::atomic<uint64_t> num_samples;
+        std::atomic<uint64_t> bytes_written;
+    };
+
+    void drain(TrackWriter& writer);
+    void record_thread();
+
+   private:
+    TrackWriter _user;
+    TrackWriter _bot;
+    DailyThreadConfig _thread_config;
+
+    // Scratch buffers, only used by the recording thread.
+    std::vector<int16_t> _frames;
+    std::vector<int16_t> _mono;
+
+    std::thread _thread;
+    bool _running;
+    std::mutex _mutex;
+    std::condition_variable _cv;
+};
+
+}  // namespace rtvi
+
+#endif
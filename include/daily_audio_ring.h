@@ -0,0 +1,60 @@
+//
+// Copyright (c) 2024, Daily
+//
+
+#ifndef DAILY_AUDIO_RING_H
+#define DAILY_AUDIO_RING_H
+
+#include "daily_pipecat_export.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace rtvi {
+
+// A lock-free ring buffer of interleaved int16 frames with a fixed number of
+// channels, for a single writer thread and a single reader thread.
+class DAILY_PIPECAT_EXPORT DailyAudioRing {
+   public:
+    DailyAudioRing(size_t capacity_frames, uint32_t num_channels);
+
+    uint32_t num_channels() const { return _num_channels; }
+
+    // Reads up to `num_frames` frames. Returns the number of frames read,
+    // which is 0 if no audio is available.
+    int32_t read(int16_t* frames, size_t num_frames);
+
+    // Writes the frames that fit, the rest are dropped. Returns the number of
+    // frames written.
+    size_t write(const int16_t* frames, size_t num_frames);
+
+    // Frames waiting to be read. Only accurate from the reader thread.
+    size_t available() const;
+
+    // Discards up to `num_frames` of the oldest frames, from the reader
+    // thread. Returns the number of frames discarded.
+    size_t skip(size_t num_frames);
+
+    // Number of frames dropped because the reader didn't keep up.
+    uint64_t dropped_frames() const { return _dropped_frames; }
+
+    // Memory used by the ring, in bytes.
+    size_t memory_bytes() const {
+        return sizeof(*this) + _capacity * sizeof(int16_t);
+    }
+
+   private:
+    uint32_t _num_channels;
+    // In samples.
+    size_t _capacity;
+    std::unique_ptr<int16_t[]> _buffer;
+    std::atomic<uint64_t> _write_pos;
+    std::atomic<uint64_t> _read_pos;
+    std::atomic<uint64_t> _dropped_frames;
+};
+
+}  // namespace rtvi
+
+#endif
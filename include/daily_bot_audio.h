@@ -0,0 +1,102 @@
+//
+// Copyright (c) 2024, Daily
+//
+
+#ifndef DAILY_BOT_AUDIO_H
+#define DAILY_BOT_AUDIO_H
+
+#include "daily_pipecat_export.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace rtvi {
+
+// Bot audio received through the bot participant's audio renderer,
+// converted to the format requested by the application. daily-core has a
+// single selected speaker for the whole process, so this is how each
+// transport gets the audio of its own bot. Audio at a higher sample rate is
+// low-pass filtered before being downsampled, so it doesn't alias.
+//
+// Audio is written by daily-core's audio thread and read by a single
+// application thread.
+class DAILY_PIPECAT_EXPORT DailyBotAudioStream {
+   public:
+    // Mono or stereo audio, holding up to `capacity_frames`. Older frames are
+    // dropped if the reader doesn't keep up.
+    DailyBotAudioStream(
+            uint32_t sample_rate,
+            uint32_t num_channels,
+            size_t capacity_frames
+    );
+
+    // Reads `num_frames` interleaved frames, waiting for them to be received
+    // for up to the duration of the frames themselves. Missing frames are
+    // filled with silence, so reads are paced like a speaker device. Returns
+    // the number of frames read, which is 0 if the stream is closed.
+    int32_t read(int16_t* frames, size_t num_frames);
+
+    // Internal usage only. Mono and stereo audio at any sample rate is
+    // accepted.
+    void write(
+            const int16_t* frames,
+            size_t num_frames,
+            uint32_t sample_rate,
+            uint32_t num_channels
+    );
+
+    // Discards buffered audio and (re)opens the stream.
+    void open();
+
+    // Wakes up and fails current and future reads.
+    void close();
+
+    // Number of frames dropped because the reader didn't keep up.
+    uint64_t dropped_frames();
+
+    // Memory used by the stream, in bytes.
+    size_t memory_bytes();
+
+   private:
+    // Low-pass filters `num_frames` converted frames into `_filtered`.
+    const int16_t* lowpass(const int16_t* frames, size_t num_frames);
+
+    void push_frame(const int16_t* frame);
+
+    const uint32_t _sample_rate;
+    const uint32_t _num_channels;
+
+    std::mutex _mutex;
+    std::condition_variable _cv;
+    bool _open;
+
+    // Ring of `_capacity` frames.
+    std::vector<int16_t> _buffer;
+    size_t _capacity;
+    size_t _read_frame;
+    size_t _num_buffered;
+    uint64_t _dropped_frames;
+
+    // Linear resampling state: the last input frame, and the position of the
+    // next output frame relative to it (in input frames).
+    uint32_t _input_sample_rate;
+    std::vector<int16_t> _last_frame;
+    double _position;
+
+    // Input converted to our number of channels.
+    std::vector<int16_t> _converted;
+
+    // Anti-aliasing filter taps (empty unless downsampling), and its input:
+    // the last `taps - 1` frames followed by the frames being filtered.
+    std::vector<float> _lowpass;
+    std::vector<float> _lowpass_input;
+    std::vector<int16_t> _filtered;
+};
+
+}  // namespace rtvi
+
+#endif
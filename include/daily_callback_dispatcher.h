@@ -0,0 +1,94 @@
+//
+// Copyright (c) 2024, Daily
+//
+
+#ifndef DAILY_CALLBACK_DISPATCHER_H
+#define DAILY_CALLBACK_DISPATCHER_H
+
+#include "daily_pipecat_export.h"
+#include "daily_thread.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+namespace rtvi {
+
+struct DailyCallbackStats {
+    // Callbacks already delivered.
+    uint64_t delivered;
+    // Callbacks waiting to be delivered.
+    uint64_t pending;
+    // Time between a callback being posted and delivered.
+    uint64_t last_lag_us;
+    uint64_t max_lag_us;
+    uint64_t total_lag_us;
+};
+
+// Delivers callbacks outside of the thread that posts them, either from a
+// dedicated thread or through an application supplied executor. Callbacks are
+// posted through a lock-free multiple-producer single-consumer queue, so
+// posting never blocks on a slow callback.
+class DAILY_PIPECAT_EXPORT DailyCallbackDispatcher {
+   public:
+    using Callback = std::function<void()>;
+    using Executor = std::function<void(Callback)>;
+
+    // If an executor is given callbacks are handed to it (in order), otherwise
+    // they are delivered from a dispatcher thread.
+    explicit DailyCallbackDispatcher(
+            Executor executor = nullptr,
+            const DailyThreadConfig& thread_config = {}
+    );
+
+    ~DailyCallbackDispatcher();
+
+    void start();
+
+    // Delivers the pending callbacks and stops the dispatcher thread.
+    void stop();
+
+    void post(Callback callback);
+
+    DailyCallbackStats stats() const;
+
+   private:
+    struct Node {
+        Callback callback;
+        std::chrono::steady_clock::time_point posted_at;
+        std::atomic<Node*> next;
+    };
+
+    Node* pop();
+    void deliver(Node* node);
+    void dispatch_thread();
+
+   private:
+    Executor _executor;
+    DailyThreadConfig _thread_config;
+
+    // Producers push at the head, the consumer pops from the tail. The tail
+    // always points to a node whose callback has already been consumed.
+    std::atomic<Node*> _head;
+    Node* _tail;
+
+    std::thread _thread;
+    std::atomic<bool> _running;
+    std::atomic<bool> _sleeping;
+    std::mutex _mutex;
+    std::condition_variable _cv;
+
+    std::atomic<uint64_t> _posted;
+    std::atomic<uint64_t> _delivered;
+    std::atomic<uint64_t> _last_lag_us;
+    std::atomic<uint64_t> _max_lag_us;
+    std::atomic<uint64_t> _total_lag_us;
+};
+
+}  // namespace rtvi
+
+#endif
@@ -0,0 +1,110 @@
+//
+// Copyright (c) 2024, Daily
+//
+
+#ifndef DAILY_DISPATCH_H
+#define DAILY_DISPATCH_H
+
+#include "daily_pipecat_export.h"
+
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+
+namespace rtvi {
+
+// Seeded FNV-1a, with a final mix so the low bits depend on all the input.
+constexpr uint32_t daily_hash(std::string_view key, uint32_t seed) {
+    uint32_t hash = 2166136261u ^ seed;
+    for (char c : key) {
+        hash ^= static_cast<uint8_t>(c);
+        hash *= 16777619u;
+    }
+    hash ^= hash >> 16;
+    hash *= 0x45d9f3bu;
+    hash ^= hash >> 16;
+    return hash;
+}
+
+// Perfect hash over a fixed set of keys, built at compile time. Looking up a
+// key costs a single hash and at most one comparison, so it's a good fit for
+// dispatching strings to a `switch` over the key indices:
+//
+//   enum Action { JOINED, LEFT, NUM_ACTIONS };
+//   static constexpr DailyPerfectHash<NUM_ACTIONS> ACTIONS({"joined", "left"});
+//
+//   switch (ACTIONS.find(action)) {
+//   case JOINED:
+//       ...
+//   }
+template <size_t N>
+class DailyPerfectHash {
+   public:
+    // At most half of the slots are used, so a seed is found quickly.
+    static constexpr size_t NUM_SLOTS = [] {
+        size_t slots = 1;
+        while (slots < N * 2) {
+            slots *= 2;
+        }
+        return slots;
+    }();
+
+    constexpr explicit DailyPerfectHash(
+            const std::array<std::string_view, N>& keys
+    )
+        : _keys(keys), _seed(0), _slots() {
+        for (uint32_t seed = 1; seed < MAX_SEED; ++seed) {
+            if (try_seed(seed)) {
+                _seed = seed;
+                return;
+            }
+        }
+    }
+
+    // False if no seed was found (e.g. there are duplicate keys).
+    constexpr bool valid() const { return _seed != 0; }
+
+    // Returns the index of the key, or -1 if it's not in the set.
+    constexpr int32_t find(std::string_view key) const {
+        int32_t index = _slots[daily_hash(key, _seed) & (NUM_SLOTS - 1)];
+        return index >= 0 && _keys[index] == key ? index : -1;
+    }
+
+    constexpr std::string_view key(size_t index) const { return _keys[index]; }
+
+   private:
+    static constexpr uint32_t MAX_SEED = 1024;
+
+    constexpr bool try_seed(uint32_t seed) {
+        for (int32_t& slot : _slots) {
+            slot = -1;
+        }
+
+        for (size_t i = 0; i < N; ++i) {
+            uint32_t hash = daily_hash(_keys[i], seed);
+            int32_t& slot = _slots[hash & (NUM_SLOTS - 1)];
+            if (slot >= 0) {
+                return false;
+            }
+            slot = static_cast<int32_t>(i);
+        }
+
+        return true;
+    }
+
+   private:
+    std::array<std::string_view, N> _keys;
+    uint32_t _seed;
+    std::array<int32_t, NUM_SLOTS> _slots;
+};
+
+// Returns the string value of `key` in the top-level object of `json`
+// without parsing it, or `std::nullopt` if there's no such value or it
+// contains escape sequences. The returned view points into `json`.
+DAILY_PIPECAT_EXPORT std::optional<std::string_view>
+daily_json_peek_string(std::string_view json, std::string_view key);
+
+}  // namespace rtvi
+
+#endif
@@ -0,0 +1,117 @@
+//
+// Copyright (c) 2024, Daily
+//
+
+#ifndef DAILY_MEMORY_H
+#define DAILY_MEMORY_H
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+namespace rtvi {
+
+// Bytes currently allocated (and the maximum reached) for one part of a
+// transport. Can be updated from any thread.
+class DailyMemoryCounter {
+   public:
+    DailyMemoryCounter() : _bytes(0), _peak(0) {}
+
+    void add(size_t bytes) {
+        size_t total = _bytes.fetch_add(bytes, std::memory_order_relaxed) +
+                       bytes;
+        size_t peak = _peak.load(std::memory_order_relaxed);
+        while (total > peak &&
+               !_peak.compare_exchange_weak(
+                       peak, total, std::memory_order_relaxed
+               )) {
+        }
+    }
+
+    void remove(size_t bytes) {
+        _bytes.fetch_sub(bytes, std::memory_order_relaxed);
+    }
+
+    size_t bytes() const { return _bytes.load(std::memory_order_relaxed); }
+
+    size_t peak() const { return _peak.load(std::memory_order_relaxed); }
+
+   private:
+    std::atomic<size_t> _bytes;
+    std::atomic<size_t> _peak;
+};
+
+// A standard allocator that charges every allocation to a counter, so the
+// memory used by a container can be accounted for without walking it:
+//
+//   DailyMemoryCounter counter;
+//   std::vector<int16_t, DailyCountingAllocator<int16_t>> buffer(
+//           DailyCountingAllocator<int16_t>(&counter)
+//   );
+//
+// The counter needs to outlive the containers using it.
+template <typename T>
+class DailyCountingAllocator {
+   public:
+    using value_type = T;
+
+    explicit DailyCountingAllocator(DailyMemoryCounter* counter)
+        : _counter(counter) {}
+
+    template <typename U>
+    DailyCountingAllocator(const DailyCountingAllocator<U>& other)
+        : _counter(other.counter()) {}
+
+    T* allocate(size_t n) {
+        T* ptr = std::allocator<T>().allocate(n);
+        _counter->add(n * sizeof(T));
+        return ptr;
+    }
+
+    void deallocate(T* ptr, size_t n) {
+        _counter->remove(n * sizeof(T));
+        std::allocator<T>().deallocate(ptr, n);
+    }
+
+    DailyMemoryCounter* counter() const { return _counter; }
+
+    template <typename U>
+    bool operator==(const DailyCountingAllocator<U>& other) const {
+        return _counter == other.counter();
+    }
+
+    template <typename U>
+    bool operator!=(const DailyCountingAllocator<U>& other) const {
+        return _counter != other.counter();
+    }
+
+   private:
+    DailyMemoryCounter* _counter;
+};
+
+// Memory used by a transport, in bytes. Memory owned by daily-core (call
+// client, devices, WebRTC) is not included and can only be measured through
+// the process resident memory.
+struct DailyMemoryReport {
+    // The transport object itself, including its inline members.
+    size_t transport;
+    // Serialized messages waiting to be sent.
+    size_t message_queue;
+    // daily-core requests in flight.
+    size_t completions;
+    // Chunks of messages being reassembled.
+    size_t message_assembler;
+    // Audio conversion scratch buffers and queued paced audio.
+    size_t audio_buffers;
+    // Per-participant audio rings.
+    size_t participant_audio;
+
+    size_t total() const {
+        return transport + message_queue + completions + message_assembler +
+               audio_buffers + participant_audio;
+    }
+};
+
+}  // namespace rtvi
+
+#endif
@@ -0,0 +1,107 @@
+//
+// Copyright (c) 2024, Daily
+//
+
+#ifndef DAILY_MESSAGE_CHUNKS_H
+#define DAILY_MESSAGE_CHUNKS_H
+
+#include "daily_memory.h"
+#include "daily_pipecat_export.h"
+
+#include <nlohmann/json.hpp>
+
+#include <cstdint>
+#include <list>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace rtvi {
+
+// App message label of message chunks.
+static constexpr const char* DAILY_MESSAGE_CHUNK_LABEL = "rtvi-ai-chunk";
+
+// Splits a serialized message into app messages carrying at most `chunk_size`
+// bytes of it each, as escaped in the `data` string:
+//
+//   {"label": "rtvi-ai-chunk", "id": 7, "seq": 0, "total": 3, "data": "..."}
+//
+// Chunks never split a UTF-8 sequence or an escape sequence, so a chunk can
+// exceed `chunk_size` only if a single one of them does.
+DAILY_PIPECAT_EXPORT std::vector<std::string> daily_split_message(
+        const std::string& message,
+        uint64_t id,
+        size_t chunk_size
+);
+
+// Reassembles chunked messages. Chunks are kept as they arrive and only
+// concatenated once, into an exact-sized string, when the last one is added.
+// Chunks may arrive in any order and interleaved with chunks of other
+// messages. Not thread-safe, except for `memory()`.
+class DAILY_PIPECAT_EXPORT DailyMessageAssembler {
+   public:
+    // At most `max_pending` messages, using at most `max_bytes` together, are
+    // reassembled at the same time. The oldest ones are discarded to make
+    // room for new chunks, and messages larger than `max_bytes` are dropped.
+    explicit DailyMessageAssembler(
+            size_t max_pending = 16,
+            size_t max_bytes = 8 * 1024 * 1024
+    );
+
+    // Returns the whole message once all its chunks have been added.
+    // Malformed chunks are ignored.
+    std::optional<std::string> add_chunk(
+            const std::string& sender,
+            uint64_t id,
+            uint32_t seq,
+            uint32_t total,
+            std::string data
+    );
+
+    // Same for a received chunk app message (see `daily_split_message()`),
+    // whose fields come from a remote participant. Chunks with missing or
+    // invalid fields (e.g. a negative `seq`) are ignored.
+    std::optional<std::string>
+    add_chunk(const std::string& sender, const nlohmann::json& chunk);
+
+    size_t pending() const { return _pending.size(); }
+
+    // Number of incomplete messages that were discarded.
+    uint64_t discarded() const { return _discarded; }
+
+    // Memory used by the chunks of incomplete messages.
+    const DailyMemoryCounter& memory() const { return _memory; }
+
+    void clear();
+
+   private:
+    struct Pending {
+        std::string sender;
+        uint64_t id;
+        std::vector<std::string> chunks;
+        uint32_t received;
+        size_t size;
+    };
+
+    static size_t pending_bytes(const Pending& pending) {
+        return sizeof(Pending) + pending.chunks.size() * sizeof(std::string) +
+               pending.size;
+    }
+
+    // Discards the oldest messages, except `keep`, until `bytes` more fit in
+    // `_max_bytes`. Returns false if they still don't.
+    bool make_room(size_t bytes, const Pending* keep);
+
+    void discard(std::list<Pending>::iterator it);
+
+    size_t _max_pending;
+    size_t _max_bytes;
+    uint64_t _discarded;
+    DailyMemoryCounter _memory;
+    // Oldest first.
+    std::list<Pending> _pending;
+};
+
+}  // namespace rtvi
+
+#endif
@@ -0,0 +1,109 @@
+//
+// Copyright (c) 2024, Daily
+//
+
+#ifndef DAILY_MESSAGE_QUEUE_H
+#define DAILY_MESSAGE_QUEUE_H
+
+#include "daily_memory.h"
+#include "daily_pipecat_export.h"
+
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace rtvi {
+
+// Outbound messages lanes, from highest to lowest priority.
+enum class DailyMessagePriority {
+    // Time-critical messages (e.g. function call results).
+    Control = 0,
+    Normal = 1,
+    // Large, non-urgent messages (e.g. LLM context updates).
+    Bulk = 2,
+};
+
+static const size_t DAILY_MESSAGE_PRIORITIES = 3;
+
+struct DailyMessageLaneStats {
+    // Messages pushed to the lane.
+    uint64_t pushed;
+    // Messages popped from the lane.
+    uint64_t popped;
+    // Messages currently waiting in the lane.
+    uint64_t pending;
+    // Messages dropped because the queue was full.
+    uint64_t dropped;
+    // Total and maximum time messages waited in the lane.
+    uint64_t total_wait_us;
+    uint64_t max_wait_us;
+};
+
+// A queue of serialized messages with one FIFO per priority. Pops always
+// return the oldest message of the highest priority non-empty lane. Unknown
+// priorities (e.g. cast from an invalid integer) go to the normal lane.
+class DAILY_PIPECAT_EXPORT DailyMessageQueue {
+   public:
+    // Messages are dropped instead of queued if the memory used by the queue
+    // would exceed `max_bytes`. 0 means unbounded.
+    explicit DailyMessageQueue(size_t max_bytes = 0);
+
+    // Returns false if the message was dropped.
+    bool push(std::string message, DailyMessagePriority priority);
+
+    // Queues all the messages (e.g. the chunks of a message) or none of them.
+    bool push(std::vector<std::string> messages, DailyMessagePriority priority);
+
+    // Blocks until there's a message available or the queue is stopped, in
+    // which case `std::nullopt` is returned.
+    std::optional<std::string> blocking_pop();
+
+    // Unblocks `blocking_pop()`. Pending messages are kept.
+    void stop();
+
+    // Allows popping messages again after `stop()`. Messages left from before
+    // are discarded.
+    void restart();
+
+    DailyMessageLaneStats stats(DailyMessagePriority priority);
+
+    // Memory used by the queued messages.
+    const DailyMemoryCounter& memory() const { return _memory; }
+
+   private:
+    struct Entry {
+        std::string message;
+        std::chrono::steady_clock::time_point pushed_at;
+    };
+
+    struct Lane {
+        std::deque<Entry> entries;
+        DailyMessageLaneStats stats;
+    };
+
+    static size_t entry_bytes(const std::string& message) {
+        return sizeof(Entry) + message.capacity();
+    }
+
+    static size_t lane_index(DailyMessagePriority priority);
+
+    void push_locked(std::string message, DailyMessagePriority priority);
+
+    size_t _max_bytes;
+    DailyMemoryCounter _memory;
+
+    std::mutex _mutex;
+    std::condition_variable _cv;
+    std::array<Lane, DAILY_MESSAGE_PRIORITIES> _lanes;
+    bool _stopped;
+};
+
+}  // namespace rtvi
+
+#endif
@@ -0,0 +1,66 @@
+//
+// Copyright (c) 2024, Daily
+//
+
+#ifndef DAILY_MESSAGE_TEMPLATE_H
+#define DAILY_MESSAGE_TEMPLATE_H
+
+#include "daily_pipecat_export.h"
+
+#include <nlohmann/json.hpp>
+
+#include <string>
+#include <vector>
+
+namespace rtvi {
+
+// A message that is serialized once and then rendered many times with
+// different values, without building or dumping a JSON tree. Placeholders are
+// string values of the form "{{name}}", e.g.:
+//
+//   DailyMessageTemplate context({
+//           {"label", "rtvi-ai"},
+//           {"type", "action"},
+//           {"data", {{"action", "set_context"}, {"arguments", "{{args}}"}}}
+//   });
+//   transport.send_raw_message(
+//           context.render({args_json}), DailyMessagePriority::Normal
+//   );
+//
+// Values are serialized JSON, so placeholders can stand for any kind of value.
+// Templates are immutable and can be rendered from any thread.
+class DAILY_PIPECAT_EXPORT DailyMessageTemplate {
+   public:
+    explicit DailyMessageTemplate(const nlohmann::json& message);
+
+    // Placeholder names, in the order their values are given to `render()`.
+    // Names used more than once only appear once.
+    const std::vector<std::string>& placeholders() const {
+        return _placeholders;
+    }
+
+    // Returns the serialized message with the placeholders replaced by
+    // `values`, which need to be serialized JSON (see `quote()` for strings).
+    // Throws `RTVIException` if the number of values doesn't match.
+    std::string render(const std::vector<std::string>& values) const;
+
+    // Serializes a string as a JSON string value.
+    static std::string quote(const std::string& value);
+
+   private:
+    struct Segment {
+        // Literal text preceding the placeholder.
+        size_t offset;
+        size_t length;
+        // Index in `_placeholders`, or -1 for the trailing text.
+        int32_t placeholder;
+    };
+
+    std::string _serialized;
+    std::vector<Segment> _segments;
+    std::vector<std::string> _placeholders;
+};
+
+}  // namespace rtvi
+
+#endif
@@ -0,0 +1,94 @@
+//
+// Copyright (c) 2024, Daily
+//
+
+#ifndef DAILY_PARTICIPANT_AUDIO_H
+#define DAILY_PARTICIPANT_AUDIO_H
+
+#include "daily_audio_ring.h"
+#include "daily_pipecat_export.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace rtvi {
+
+// Audio received from a single remote participant. Audio is written by
+// daily-core's audio thread and read by a single application thread through a
+// lock-free ring buffer, so each participant can be processed independently.
+//
+// daily-core can change the format of the audio at any time. Audio queued in
+// the previous format is then dropped, and the reader switches to the new
+// format either when it checks the format or on its next `read()`, which then
+// returns 0.
+class DAILY_PIPECAT_EXPORT DailyParticipantAudioStream {
+   public:
+    explicit DailyParticipantAudioStream(
+            const std::string& participant_id,
+            size_t capacity_samples
+    );
+
+    const std::string& participant_id() const { return _participant_id; }
+
+    // Format of the audio returned by `read()`, from the reader thread only.
+    // Both are 0 until audio is received.
+    uint32_t sample_rate();
+    uint32_t num_channels();
+
+    // Reads up to `num_frames` interleaved frames. Returns the number of frames
+    // read, which is 0 if no audio is available or if the format changed.
+    int32_t read(int16_t* frames, size_t num_frames);
+
+    // Number of frames dropped because the reader didn't keep up.
+    uint64_t dropped_frames() const { return _dropped_frames; }
+
+    // Memory used by the stream, in bytes.
+    size_t memory_bytes() const {
+        return sizeof(*this) + _participant_id.capacity() + _buffer_bytes;
+    }
+
+    // Internal usage only. Audio without channels is ignored.
+    void write(
+            const int16_t* frames,
+            size_t num_frames,
+            uint32_t sample_rate,
+            uint32_t num_channels
+    );
+
+   private:
+    // Audio in a single format.
+    struct Buffer {
+        Buffer(size_t capacity_samples,
+               uint32_t sample_rate,
+               uint32_t num_channels)
+            : ring(capacity_samples / num_channels, num_channels),
+              sample_rate(sample_rate) {}
+
+        DailyAudioRing ring;
+        uint32_t sample_rate;
+    };
+
+    Buffer* reader_buffer();
+    Buffer* writer_buffer(uint32_t sample_rate, uint32_t num_channels);
+
+   private:
+    std::string _participant_id;
+    size_t _capacity;
+    // Only used by the writer. The current buffer and those the reader might
+    // still be using.
+    std::vector<std::unique_ptr<Buffer>> _buffers;
+    // Published by the writer on format changes.
+    std::atomic<Buffer*> _current;
+    // The buffer used by the reader, the writer doesn't free it.
+    std::atomic<Buffer*> _reading;
+    std::atomic<uint64_t> _dropped_frames;
+    std::atomic<size_t> _buffer_bytes;
+};
+
+}  // namespace rtvi
+
+#endif
@@ -0,0 +1,29 @@
+//
+// Copyright (c) 2024, Daily
+//
+
+#ifndef DAILY_PIPECAT_EXPORT_H
+#define DAILY_PIPECAT_EXPORT_H
+
+// The library is built with hidden symbols by default, only the public API is
+// exported. Applications linking with the shared library on Windows need to
+// define DAILY_PIPECAT_SHARED.
+#if defined(DAILY_PIPECAT_SHARED)
+#if defined(_WIN32)
+#if defined(DAILY_PIPECAT_BUILDING)
+#define DAILY_PIPECAT_EXPORT __declspec(dllexport)
+#else
+#define DAILY_PIPECAT_EXPORT __declspec(dllimport)
+#endif
+#else
+#define DAILY_PIPECAT_EXPORT __attribute__((visibility("default")))
+#endif
+#else
+#if defined(_WIN32)
+#define DAILY_PIPECAT_EXPORT
+#else
+#define DAILY_PIPECAT_EXPORT __attribute__((visibility("default")))
+#endif
+#endif
+
+#endif
@@ -7,7 +7,24 @@
 
 #include "rtvi.h"
 
+#include "daily_audio.h"
+#include "daily_audio_meter.h"
+#include "daily_audio_pacer.h"
+#include "daily_audio_processor.h"
+#include "daily_audio_recorder.h"
+#include "daily_audio_ring.h"
+#include "daily_bot_audio.h"
+#include "daily_callback_dispatcher.h"
+#include "daily_dispatch.h"
+#include "daily_memory.h"
+#include "daily_message_chunks.h"
+#include "daily_message_queue.h"
+#include "daily_message_template.h"
+#include "daily_participant_audio.h"
+#include "daily_thread.h"
+#include "daily_tracer.h"
 #include "daily_transport.h"
 #include "daily_voice_client.h"
+#include "daily_watchdog.h"
 
 #endif
@@ -0,0 +1,41 @@
+//
+// Copyright (c) 2024, Daily
+//
+
+#ifndef DAILY_THREAD_H
+#define DAILY_THREAD_H
+
+#include "daily_pipecat_export.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace rtvi {
+
+// Scheduling of a thread. The default values keep the default scheduling.
+struct DailyThreadConfig {
+    // CPUs the thread can run on. Not supported on macOS.
+    std::vector<uint32_t> cpus;
+
+    // Run with the real-time FIFO policy at this priority (1-99), which
+    // usually requires privileges (e.g. CAP_SYS_NICE or an rtprio limit on
+    // Linux). On Windows any value selects time-critical priority.
+    int32_t realtime_priority = 0;
+
+    // Nice value (-20 to 19) when not real-time. Not supported on macOS.
+    int32_t nice = 0;
+};
+
+// Names the calling thread (truncated to 15 characters on Linux) and applies
+// the given scheduling to it. Applications can use it for their own audio
+// threads. Returns false if some of the configuration couldn't be applied,
+// the rest is applied anyway.
+DAILY_PIPECAT_EXPORT bool daily_configure_thread(
+        const std::string& name,
+        const DailyThreadConfig& config
+);
+
+}  // namespace rtvi
+
+#endif
@@ -0,0 +1,155 @@
+//
+// Copyright (c) 2024, Daily
+//
+
+#ifndef DAILY_TRACER_H
+#define DAILY_TRACER_H
+
+#include "daily_pipecat_export.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace rtvi {
+
+// Process-wide recorder of transport spans (connection phases, app messages,
+// events, audio calls...), exported in the Chrome trace event format, which
+// can be opened with Perfetto (https://ui.perfetto.dev) or chrome://tracing.
+//
+// Each thread records into its own ring buffer without any locking, so
+// tracing can stay enabled while under load. Only the most recent events of
+// each thread are kept. Spans are grouped by session (one per transport).
+//
+// Rings are only allocated for threads that record while tracing is enabled.
+// The rings of threads that exit are released on the next `start()`, so their
+// events can still be exported until then.
+class DAILY_PIPECAT_EXPORT DailyTracer {
+   public:
+    static DailyTracer& instance();
+
+    // Starts recording, discarding previously recorded events. Each thread
+    // keeps its last `events_per_thread` events.
+    void start(size_t events_per_thread = 16384);
+
+    void stop();
+
+    bool enabled() const { return _enabled.load(std::memory_order_relaxed); }
+
+    // Nanoseconds since the tracer was created.
+    uint64_t now() const;
+
+    // `name` needs to be a string literal (or outlive the tracer).
+    void record(
+            uint32_t session,
+            const char* name,
+            uint64_t start_ns,
+            uint64_t end_ns,
+            uint64_t arg
+    );
+
+    // Names the calling thread in the exported trace.
+    void set_thread_name(const std::string& name);
+
+    // Returns a unique session id.
+    uint32_t new_session();
+
+    // Exports the recorded events as Chrome trace JSON. Can be called while
+    // recording.
+    std::string chrome_trace();
+
+    // Returns false if the file can't be written.
+    bool write_chrome_trace(const std::string& path);
+
+    // Memory used by the thread rings, in bytes.
+    size_t memory_bytes();
+
+   private:
+    struct Event {
+        std::atomic<const char*> name;
+        std::atomic<uint64_t> start_ns;
+        std::atomic<uint64_t> duration_ns;
+        std::atomic<uint64_t> arg;
+        std::atomic<uint32_t> session;
+    };
+
+    struct ThreadBuffer {
+        uint32_t tid;
+        // The thread has exited. Protected by the tracer mutex.
+        bool exited;
+        // Recording generation the events belong to.
+        std::atomic<uint64_t> generation;
+        // Total number of events written, the ring holds the last ones.
+        std::atomic<uint64_t> head;
+        std::unique_ptr<Event[]> events;
+        size_t capacity;
+    };
+
+    // Per-thread state, which releases the thread's ring when it exits.
+    struct ThreadState;
+
+    DailyTracer();
+
+    ThreadState& thread_state();
+
+    ThreadBuffer* create_thread_buffer(uint32_t tid);
+
+    void thread_exited(const ThreadState& state);
+
+   private:
+    std::chrono::steady_clock::time_point _start;
+    std::atomic<bool> _enabled;
+    std::atomic<uint64_t> _generation;
+    std::atomic<size_t> _events_per_thread;
+    std::atomic<uint32_t> _session_counter;
+    std::atomic<uint32_t> _thread_counter;
+
+    // A thread's buffer is only released by `start()` once the thread has
+    // exited, so threads can keep a pointer to theirs.
+    std::mutex _mutex;
+    std::vector<std::unique_ptr<ThreadBuffer>> _buffers;
+    std::map<uint32_t, std::string> _thread_names;
+};
+
+// Records a span from its construction to its destruction, if the tracer is
+// enabled.
+class DAILY_PIPECAT_EXPORT DailyTraceSpan {
+   public:
+    DailyTraceSpan(uint32_t session, const char* name, uint64_t arg = 0)
+        : _session(session),
+          _name(name),
+          _arg(arg),
+          _start_ns(
+                  DailyTracer::instance().enabled()
+                          ? DailyTracer::instance().now()
+                          : 0
+          ) {}
+
+    ~DailyTraceSpan() {
+        if (_start_ns) {
+            DailyTracer& tracer = DailyTracer::instance();
+            tracer.record(_session, _name, _start_ns, tracer.now(), _arg);
+        }
+    }
+
+    DailyTraceSpan(const DailyTraceSpan&) = delete;
+    DailyTraceSpan& operator=(const DailyTraceSpan&) = delete;
+
+    void set_name(const char* name) { _name = name; }
+    void set_arg(uint64_t arg) { _arg = arg; }
+
+   private:
+    uint32_t _session;
+    const char* _name;
+    uint64_t _arg;
+    uint64_t _start_ns;
+};
+
+}  // namespace rtvi
+
+#endif
@@ -7,24 +7,208 @@
 
 #include "rtvi.h"
 
+#include "daily_audio_meter.h"
+#include "daily_audio_pacer.h"
+#include "daily_audio_processor.h"
+#include "daily_audio_recorder.h"
+#include "daily_bot_audio.h"
+#include "daily_callback_dispatcher.h"
+#include "daily_dispatch.h"
+#include "daily_memory.h"
+#include "daily_message_chunks.h"
+#include "daily_message_queue.h"
+#include "daily_message_template.h"
+#include "daily_participant_audio.h"
+#include "daily_pipecat_export.h"
+#include "daily_thread.h"
+#include "daily_tracer.h"
+#include "daily_watchdog.h"
+
 extern "C" {
 #include "daily_core.h"
 }
 
 #include <atomic>
+#include <condition_variable>
+#include <functional>
 #include <future>
+#include <map>
+#include <memory>
 #include <mutex>
+#include <thread>
+#include <vector>
 
 namespace rtvi {
 
+class DAILY_PIPECAT_EXPORT DailyTransportCallbacks {
+   public:
+    virtual ~DailyTransportCallbacks() {}
+
+    // Called before every attempt to rejoin the call after a network drop.
+    virtual void on_reconnecting(uint32_t attempt) {}
+
+    virtual void on_reconnected() {}
+
+    // All reconnection attempts failed. The transport is still considered
+    // connected, so `disconnect()` needs to be called to release it.
+    virtual void on_reconnect_failed() {}
+
+    // A daily-core request (e.g. "join" or "send-app-message") didn't
+    // complete in time and has failed. Called from the process-wide watchdog
+    // thread, so it should return quickly.
+    virtual void on_request_timeout(const std::string& request) {}
+
+    // Latest user and bot audio levels, every `audio_levels_interval_ms`.
+    // Called from the audio threads (unless callbacks are dispatched), so it
+    // should return quickly.
+    virtual void on_audio_levels(
+            const DailyAudioLevels& user,
+            const DailyAudioLevels& bot
+    ) {}
+
+    // The local user started or stopped speaking (see `audio_levels`).
+    virtual void on_user_speaking_changed(bool speaking) {}
+};
+
 struct DailyTransportParams {
     uint32_t user_audio_sample_rate;
     uint32_t user_audio_channels;
     uint32_t bot_audio_sample_rate;
     uint32_t bot_audio_channels;
+
+    // Rejoin the call with exponential backoff if we are disconnected after a
+    // network interruption (not if we are ejected or the meeting ends).
+    // Virtual devices, the call client and queued messages are kept while
+    // reconnecting.
+    bool auto_reconnect = false;
+    uint32_t reconnect_max_attempts = 5;
+    uint32_t reconnect_initial_backoff_ms = 250;
+    uint32_t reconnect_max_backoff_ms = 8000;
+
+    // Bot audio reads whose peak stays below this threshold for at least
+    // `bot_audio_silence_min_ms` are reported as silence (see
+    // `DailyTransport::read_bot_audio_chunk()`).
+    uint32_t bot_audio_silence_threshold = 32;
+    uint32_t bot_audio_silence_min_ms = 100;
+
+    // Only subscribe to the bot's microphone instead of every participant's.
+    // Audio from other participants (e.g. observers or recorders) is then not
+    // received or decoded at all.
+    bool subscribe_bot_only = false;
+
+    // Receive each remote participant's audio separately (see
+    // `DailyTransport::participant_audio()`), in addition to the mixed bot
+    // audio.
+    bool participant_audio_streams = false;
+
+    // Feed audio given to `DailyTransport::queue_user_audio()` to the virtual
+    // microphone at real-time rate from a pacer thread. Values of
+    // `user_audio_speed` above 1 feed it faster than real time (e.g. for
+    // tests).
+    bool paced_user_audio = false;
+    double user_audio_speed = 1.0;
+
+    // Run user audio through an echo canceller (with the bot audio read as
+    // reference), a noise suppressor and gain control before sending it (see
+    // `DailyTransport::user_audio_processor()`).
+    bool user_audio_processing = false;
+
+    // Ask WebRTC to cancel echo. Can be disabled if user audio is already
+    // processed (e.g. with `user_audio_processing`).
+    bool webrtc_echo_cancellation = true;
+
+    // Record the user (sent) and bot (read) audio of every connection to
+    // compressed WAV files. Files are overwritten on every connection and
+    // audio is not recorded if the path is empty.
+    std::string user_audio_recording_path;
+    std::string bot_audio_recording_path;
+
+    // Measure the RMS and peak levels of every 10ms block of user (sent) and
+    // bot (read) audio and track whether the user is speaking, so
+    // applications don't need to scan the audio themselves (see
+    // `DailyTransport::user_audio_levels()`). 0 disables the periodic
+    // `on_audio_levels()` callback.
+    bool audio_levels = false;
+    uint32_t audio_levels_interval_ms = 100;
+    float speaking_threshold_dbfs = -45.0f;
+    uint32_t speaking_hangover_ms = 300;
+
+    // Deliver application callbacks (e.g. `on_bot_connected()` or transport
+    // messages) from a dispatcher thread instead of daily-core's events thread,
+    // so slow callbacks don't delay the transport. If an executor is given,
+    // callbacks are handed to it instead and it needs to run them before the
+    // transport is destroyed.
+    bool dispatch_callbacks = false;
+    DailyCallbackDispatcher::Executor callback_executor = nullptr;
+
+    // daily-core requests (join, leave, app messages...) that don't complete
+    // in time fail with an exception instead of blocking forever (see
+    // `DailyTransportCallbacks::on_request_timeout()`). 0 disables timeouts.
+    uint32_t request_timeout_ms = 15000;
+
+    // Send messages given to `DailyTransport::send_message()` without a
+    // priority in a lane chosen by their type: function call results go
+    // first and LLM context updates go last. Otherwise they all go through
+    // the normal lane, in order.
+    bool prioritize_messages = false;
+
+    // Split messages larger than this (serialized, in bytes) into
+    // "rtvi-ai-chunk" app messages carrying at most this many bytes of the
+    // message each (once escaped), so large LLM context updates don't hit
+    // app message size limits. With `prioritize_messages`, chunks are sent in
+    // the bulk lane (unless the message is a control one), so smaller
+    // messages sent in the meantime aren't blocked behind them. The bot needs
+    // to support chunked messages. 0 disables chunking, and chunked messages
+    // received are then ignored. Otherwise they are reassembled, using up to
+    // 8 MiB for incomplete ones.
+    uint32_t message_chunk_size = 0;
+
+    // Drop messages instead of queueing them once the queued messages use
+    // this much memory (see `DailyMessageLaneStats::dropped`), so a stalled
+    // connection can't grow a session without bounds. 0 means unbounded.
+    size_t max_queued_message_bytes = 0;
+
+    // Scheduling of the user audio pacer thread, the only transport thread on
+    // the audio path (e.g. pinned to a dedicated CPU with real-time priority).
+    DailyThreadConfig audio_thread_config;
+
+    // Scheduling of the other transport threads (messages, reconnection,
+    // callbacks and recording).
+    DailyThreadConfig thread_config;
+
+    DailyTransportCallbacks* callbacks = nullptr;
+};
+
+enum class DailyAudioLayout {
+    // Samples of each frame are stored together (L R L R ...).
+    Interleaved,
+    // Each channel is stored in its own plane (L L ... R R ...).
+    Planar
+};
+
+// A view over `num_frames` audio frames of `num_channels` channels.
+template <typename T>
+struct DailyAudioSpan {
+    T* data;
+    size_t num_frames;
+    uint32_t num_channels;
+    DailyAudioLayout layout;
+
+    size_t num_samples() const { return num_frames * num_channels; }
+};
+
+struct DailyBotAudioChunk {
+    // Number of frames read.
+    int32_t num_frames;
+    // The frames are part of a silence run and can be skipped. The contents of
+    // the buffer should not be used.
+    bool silence;
+    // Total number of frames in the current silence run, including these.
+    uint64_t silence_frames;
 };
 
-class DailyTransport : public RTVITransport {
+class DAILY_PIPECAT_EXPORT DailyTransport : public RTVITransport,
+                                            private DailyWatchdog::Listener {
    public:
     explicit DailyTransport(
             const RTVIClientOptions& options,
@@ -37,40 +221,173 @@ class DailyTransport : public RTVITransport {
             RTVITransportMessageObserver* message_observer
     );
 
+    // Params are immutable, so sessions with the same params (e.g. without
+    // per-session `callbacks`) can share a single copy.
+    explicit DailyTransport(
+            const RTVIClientOptions& options,
+            std::shared_ptr<const DailyTransportParams> params,
+            RTVITransportMessageObserver* message_observer
+    );
+
     virtual ~DailyTransport() override;
 
+    // Initializes the process-wide daily-core context. This only happens once
+    // per process and is also done by `initialize()`, but applications can
+    // call it at startup to take it out of the first connection.
+    static void warm_up();
+
+    const DailyTransportParams& params() const { return *_params; }
+
     void initialize() override;
 
+    // `connect()` and `disconnect()` can be called from any thread (but not
+    // from callbacks). A disconnection waits for an ongoing connection.
     void connect(const nlohmann::json& info) override;
 
     void disconnect() override;
 
+    // Messages are sent in order in the normal lane, or in a lane chosen by
+    // their type with `DailyTransportParams::prioritize_messages`.
     void send_message(const nlohmann::json& message) override;
 
+    void send_message(
+            const nlohmann::json& message,
+            DailyMessagePriority priority
+    );
+
+    // Sends an already serialized message (e.g. a cached one or one rendered
+    // from a `DailyMessageTemplate`), skipping JSON serialization.
+    void send_raw_message(std::string data, DailyMessagePriority priority);
+
+    DailyMessageLaneStats message_lane_stats(DailyMessagePriority priority);
+
+    using Handler = std::function<void(const nlohmann::json& data)>;
+
+    // Calls `handler` with every daily-core event of the given action (e.g.
+    // "active-speaker-changed"), in addition to the transport's own handling.
+    // Events without a handler are not even parsed. Handlers are called like
+    // other callbacks (see `dispatch_callbacks`) and need to be set before
+    // connecting.
+    void set_event_handler(const std::string& action, Handler handler);
+
+    // Same for RTVI messages of the given type (e.g. "bot-llm-text"), in
+    // addition to the message observer.
+    void set_message_handler(const std::string& type, Handler handler);
+
+    // Returns the audio stream of the given remote participant, or `nullptr`
+    // if there's none. Requires `participant_audio_streams`.
+    std::shared_ptr<DailyParticipantAudioStream>
+    participant_audio(const std::string& participant_id);
+
+    // Returns the ids of the participants with an audio stream.
+    std::vector<std::string> participant_audio_ids();
+
+    // Requires `dispatch_callbacks` or `callback_executor`.
+    DailyCallbackStats callback_stats() const;
+
     int32_t send_user_audio(const int16_t* data, size_t num_frames) override;
+
+    // Reads the audio of the bot (the first remote participant to join)
+    // only. Audio of other remote participants is not mixed in, see
+    // `participant_audio_streams`.
     int32_t read_bot_audio(int16_t* data, size_t num_frames) override;
 
-    // Internal usage only.
-    WebrtcAudioDeviceModule* create_audio_device_module(
-            WebrtcTaskQueueFactory* task_queue_factory
-    );
-    char* enumerate_devices();
-    void* get_user_media(
-            WebrtcPeerConnectionFactory* peer_connection_factory,
-            WebrtcThread* webrtc_signaling_thread,
-            WebrtcThread* webrtc_worker_thread,
-            WebrtcThread* webrtc_network_thread,
-            const char* constraints
-    );
+    // Float32 variants. Samples are converted to (and from) int16 inside the
+    // transport. The number of channels needs to match the transport params.
+    int32_t send_user_audio(const DailyAudioSpan<const float>& audio);
+    int32_t read_bot_audio(const DailyAudioSpan<float>& audio);
+
+    // Queues user audio of any size to be sent at real-time rate. Queued audio
+    // is discarded on disconnection. Requires `paced_user_audio` and should
+    // not be mixed with `send_user_audio()`.
+    void queue_user_audio(const int16_t* data, size_t num_frames);
+
+    // Discards queued user audio (e.g. when the user interrupts the bot).
+    void clear_user_audio();
+
+    DailyAudioPacerStats user_audio_stats() const;
+
+    // Stages can be toggled at any time and custom stages can be added
+    // before connecting. Requires `user_audio_processing`.
+    DailyAudioProcessor* user_audio_processor() const {
+        return _user_audio_processor.get();
+    }
 
-    void on_event(const nlohmann::json& event);
+    // Requires a recording path.
+    DailyRecordingStats recording_stats() const;
+
+    // Levels of the last 10ms block. Can be called from any thread. Requires
+    // `audio_levels`.
+    DailyAudioLevels user_audio_levels() const;
+    DailyAudioLevels bot_audio_levels() const;
+
+    // Same as `read_bot_audio()` but also detects silence runs, so consumers
+    // can skip processing (or forwarding) silent audio. Should always be
+    // called from the same thread.
+    DailyBotAudioChunk read_bot_audio_chunk(int16_t* data, size_t num_frames);
+
+    // Memory used by the transport itself. Can be called from any thread.
+    DailyMemoryReport memory_report();
+
+    // Internal usage only.
+    void on_event(std::string_view event_json);
+    void on_audio_data(uint64_t renderer_id, const NativeAudioData* audio_data);
 
    private:
-    uint64_t add_completion(std::promise<void> completion);
-    void resolve_completion(uint64_t request_id);
+    // Scope of a daily-core event or audio callback, which is only handled if
+    // the call client is active (see `_client_active`).
+    class ClientCallbackScope {
+       public:
+        explicit ClientCallbackScope(DailyTransport* transport);
+        ~ClientCallbackScope();
+
+        bool active() const { return _active; }
+
+       private:
+        DailyTransport* _transport;
+        bool _active;
+    };
+
+    void close_client_callbacks();
+
+    void create_devices();
+    void release_devices();
+
+    uint64_t
+    add_completion(std::promise<void> completion, const char* request);
+    void resolve_completion(uint64_t request_id, const nlohmann::json& result);
+    // Drops the completions left once the call client is destroyed.
+    void discard_completions();
+    void on_timer_expired(uint64_t request_id) override;
+
+    void join();
+
+    int32_t write_user_audio(const int16_t* frames, size_t num_frames);
+    void report_audio_levels();
+    void post_callback(DailyCallbackDispatcher::Callback callback);
+
+    void on_call_state_updated(const std::string& state);
+    void on_network_connection(const std::string& event);
+    void start_reconnecting();
+    void reconnect_thread();
+    bool wait_until_joined();
+    bool wait_until_left();
 
     void send_message_thread();
 
+    void on_app_message(const nlohmann::json& event);
+    void deliver_message(const nlohmann::json& message);
+    void deliver(const Handler& handler, nlohmann::json data);
+
+    void update_bot_subscription(
+            const std::string& participant_id,
+            bool subscribed
+    );
+
+    uint64_t add_audio_renderer(const std::string& participant_id);
+    uint64_t add_participant_audio(const std::string& participant_id);
+    void remove_participant_audio(const std::string& participant_id);
+
     void on_participant_joined(const nlohmann::json& participant);
     void on_participant_updated(const nlohmann::json& participant);
     void on_participant_left(
@@ -81,25 +398,123 @@ class DailyTransport : public RTVITransport {
    private:
     std::atomic<bool> _initialized;
     std::atomic<bool> _connected;
+    std::atomic<bool> _joined;
+    std::atomic<bool> _leaving;
+
+    // Serializes `connect()` and `disconnect()`.
+    std::mutex _connection_mutex;
 
-    RTVIClientOptions _options;
-    DailyTransportParams _params;
+    // Only the callbacks are needed from the client options, which are kept
+    // by the client anyway.
+    RTVIEventCallbacks* _callbacks;
+    std::shared_ptr<const DailyTransportParams> _params;
     RTVITransportMessageObserver* _message_observer;
 
     DailyRawCallClient* _client;
-    NativeDeviceManager* _device_manager;
-    DailyVirtualSpeakerDevice* _speaker;
+    // daily-core can still deliver events and audio while (or even after) the
+    // call client is destroyed, so they are only handled while the client is
+    // active. Closing waits for the callbacks in progress.
+    std::atomic<bool> _client_active;
+    std::atomic<uint32_t> _client_callbacks;
+    // Taken from a process-wide pool on the first connection and given back
+    // when the transport is destroyed.
     DailyVirtualMicrophoneDevice* _microphone;
+    std::string _microphone_name;
+    std::string _client_settings;
 
     // daily-core completions
+    struct Completion {
+        std::promise<void> promise;
+        const char* request;
+        DailyWatchdog::Timer timer;
+    };
+
+    using CompletionMap = std::map<
+            uint64_t,
+            Completion,
+            std::less<uint64_t>,
+            DailyCountingAllocator<std::pair<const uint64_t, Completion>>>;
+
     std::mutex _completions_mutex;
     std::atomic<uint64_t> _request_id;
-    std::map<uint64_t, std::promise<void>> _completions;
+    DailyMemoryCounter _completions_memory;
+    CompletionMap _completions;
 
     std::thread _msg_thread;
-    RTVIQueue<nlohmann::json> _msg_queue;
+    DailyMessageQueue _msg_queue;
+
+    // Chunked messages
+    std::atomic<uint64_t> _chunked_message_id;
+    // Only used from the events thread.
+    DailyMessageAssembler _message_assembler;
+
+    // Application handlers, by event action and message type.
+    std::map<std::string, Handler, std::less<>> _event_handlers;
+    std::map<std::string, Handler, std::less<>> _message_handlers;
+
+    // Reconnection. The room URL and token are only kept with
+    // `auto_reconnect`.
+    std::string _room_url;
+    std::string _token;
+    std::mutex _reconnect_mutex;
+    std::condition_variable _reconnect_cv;
+    std::atomic<bool> _reconnecting;
+    std::thread _reconnect_thread;
+    // Set while daily-core reports the connection as interrupted, which is
+    // the only reason to reconnect after leaving.
+    std::atomic<bool> _network_interrupted;
+    // Set if the call was left since the last join was requested, in which
+    // case the join doesn't make us joined even if it succeeded. Guarded by
+    // `_reconnect_mutex`.
+    bool _left_since_join;
+
+    // Bot audio silence detection
+    uint64_t _bot_silence_frames;
+
+    // Scratch buffers for audio conversions (one per direction, since they
+    // are used from different threads).
+    using AudioBuffer = std::vector<int16_t, DailyCountingAllocator<int16_t>>;
+
+    DailyMemoryCounter _audio_buffers_memory;
+    AudioBuffer _user_audio_buffer;
+    AudioBuffer _bot_audio_buffer;
+    AudioBuffer _processed_audio_buffer;
+
+    std::unique_ptr<DailyCallbackDispatcher> _dispatcher;
+
+    std::unique_ptr<DailyAudioPacer> _user_audio_pacer;
+
+    std::unique_ptr<DailyAudioRecorder> _recorder;
+
+    std::unique_ptr<DailyAudioProcessor> _user_audio_processor;
+
+    // Audio levels
+    std::unique_ptr<DailyAudioMeter> _user_audio_meter;
+    std::unique_ptr<DailyAudioMeter> _bot_audio_meter;
+    std::atomic<uint64_t> _next_levels_ns;
+
+    // Per-participant audio streams, by renderer id. Renderer ids start at 1
+    // and are only assigned from the events thread.
+    std::mutex _participant_audio_mutex;
+    uint64_t _renderer_id;
+    std::map<uint64_t, std::shared_ptr<DailyParticipantAudioStream>>
+            _participant_audio;
+
+    // Empty until the bot joins.
+    std::mutex _bot_participant_mutex;
+    std::string _bot_participant_id;
+
+    // Bot audio arrives through the bot's audio renderer (0 if there's no
+    // bot), since the speaker device is shared by all transports.
+    DailyBotAudioStream _bot_audio;
+    std::atomic<uint64_t> _bot_renderer_id;
+
+    // "client-ready" is sent every time the bot audio becomes playable, so
+    // it's only serialized once.
+    std::string _client_ready_message;
 
-    nlohmann::json _bot_participant;
+    // Groups the spans of this transport in traces.
+    uint32_t _trace_session;
 };
 
 }  // namespace rtvi
@@ -7,11 +7,12 @@
 
 #include "rtvi.h"
 
+#include "daily_pipecat_export.h"
 #include "daily_transport.h"
 
 namespace rtvi {
 
-class DailyVoiceClient : public RTVIClient {
+class DAILY_PIPECAT_EXPORT DailyVoiceClient : public RTVIClient {
    public:
     explicit DailyVoiceClient(const RTVIClientOptions& options);
 
@@ -20,10 +21,26 @@ class DailyVoiceClient : public RTVIClient {
             const DailyTransportParams& params
     );
 
+    // Shares the params with other clients (see `DailyTransport`).
+    explicit DailyVoiceClient(
+            const RTVIClientOptions& options,
+            std::shared_ptr<const DailyTransportParams> params
+    );
+
     virtual ~DailyVoiceClient() override;
 
+    // Gives access to Daily specific transport functionality. The transport is
+    // owned by the client.
+    DailyTransport* transport() const { return _transport; }
+
+   private:
+    explicit DailyVoiceClient(
+            const RTVIClientOptions& options,
+            DailyTransport* transport
+    );
+
    private:
-    std::unique_ptr<DailyTransport> _transport;
+    DailyTransport* _transport;
 };
 
 }  // namespace rtvi
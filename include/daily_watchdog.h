@@ -0,0 +1,90 @@
+//
+// Copyright (c) 2024, Daily
+//
+
+#ifndef DAILY_WATCHDOG_H
+#define DAILY_WATCHDOG_H
+
+#include "daily_pipecat_export.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace rtvi {
+
+// Process-wide deadline tracker for outstanding requests. Timers live in a
+// hashed timer wheel (100ms ticks) served by a single thread, so arming and
+// cancelling are O(1) and each tick only visits the timers of one slot, no
+// matter how many sessions are running.
+class DAILY_PIPECAT_EXPORT DailyWatchdog {
+   public:
+    class Listener {
+       public:
+        virtual ~Listener() {}
+
+        // Called from the watchdog thread when the timer armed with `id`
+        // expires.
+        virtual void on_timer_expired(uint64_t id) = 0;
+    };
+
+    // Intrusive timer, owned by the listener. It must stay at the same address
+    // while it's armed.
+    struct Timer {
+        Listener* listener = nullptr;
+        uint64_t id = 0;
+        uint64_t expires_tick = 0;
+        Timer* prev = nullptr;
+        Timer* next = nullptr;
+    };
+
+    static DailyWatchdog& instance();
+
+    ~DailyWatchdog();
+
+    void arm(
+            Timer* timer,
+            Listener* listener,
+            uint64_t id,
+            uint32_t timeout_ms
+    );
+
+    // Does nothing if the timer is not armed (e.g. it already expired).
+    void cancel(Timer* timer);
+
+    // Waits until timers that are currently expiring have been notified. Once
+    // all its timers are cancelled, a listener can be destroyed after calling
+    // this. Must not be called while holding a lock that the listener takes
+    // when notified.
+    void synchronize();
+
+   private:
+    DailyWatchdog();
+
+    uint64_t current_tick() const;
+    void unlink(Timer* timer);
+    void watchdog_thread();
+
+   private:
+    std::chrono::steady_clock::time_point _start;
+
+    std::mutex _mutex;
+    std::condition_variable _cv;
+    // Each slot is a circular list with a sentinel.
+    std::vector<Timer> _slots;
+    uint64_t _tick;
+    size_t _num_armed;
+    bool _running;
+    std::thread _thread;
+
+    // Whether expired timers are being notified.
+    bool _expiring;
+    std::condition_variable _expire_cv;
+};
+
+}  // namespace rtvi
+
+#endif
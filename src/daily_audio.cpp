@@ -0,0 +1,740 @@
+//
+// Copyright (c) 2024, Daily
+//
+
+#include "daily_audio.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#include <immintrin.h>
+#define DAILY_AUDIO_X86
+#ifdef _MSC_VER
+#include <intrin.h>
+#define DAILY_AUDIO_AVX2_TARGET
+#else
+#define DAILY_AUDIO_AVX2_TARGET __attribute__((target("avx2")))
+#endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define DAILY_AUDIO_NEON
+#endif
+
+using namespace rtvi;
+
+struct AudioKernels {
+    const char* name;
+    uint32_t (*peak)(const int16_t*, size_t);
+    uint64_t (*sum_squares)(const int16_t*, size_t);
+    void (*gain)(int16_t*, size_t, float);
+    void (*mix)(int16_t*, const int16_t*, size_t);
+    void (*float_to_int16)(const float*, int16_t*, size_t);
+    void (*int16_to_float)(const int16_t*, float*, size_t);
+    void (*stereo_to_mono)(const int16_t*, int16_t*, size_t);
+    void (*mono_to_stereo)(const int16_t*, int16_t*, size_t);
+};
+
+// NaN becomes 0. SIMD versions need to clamp (and zero NaN) in float before
+// converting, so every implementation returns the same samples.
+static inline int16_t saturate_int16(float value) {
+    if (std::isnan(value)) {
+        return 0;
+    }
+    value = std::min(std::max(value, -32768.0f), 32767.0f);
+    return static_cast<int16_t>(std::lrint(value));
+}
+
+//
+// Scalar. Also used to process the tail of the SIMD versions.
+//
+
+static uint32_t peak_scalar(const int16_t* samples, size_t num_samples) {
+    int32_t max = 0;
+    int32_t min = 0;
+    for (size_t i = 0; i < num_samples; ++i) {
+        max = std::max<int32_t>(max, samples[i]);
+        min = std::min<int32_t>(min, samples[i]);
+    }
+    return static_cast<uint32_t>(std::max(max, -min));
+}
+
+static uint64_t sum_squares_scalar(const int16_t* samples, size_t num_samples) {
+    uint64_t sum = 0;
+    for (size_t i = 0; i < num_samples; ++i) {
+        sum += uint64_t(int32_t(samples[i]) * samples[i]);
+    }
+    return sum;
+}
+
+static void gain_scalar(int16_t* samples, size_t num_samples, float gain) {
+    for (size_t i = 0; i < num_samples; ++i) {
+        samples[i] = saturate_int16(samples[i] * gain);
+    }
+}
+
+static void mix_scalar(int16_t* dst, const int16_t* src, size_t num_samples) {
+    for (size_t i = 0; i < num_samples; ++i) {
+        int32_t sum = int32_t(dst[i]) + src[i];
+        dst[i] = static_cast<int16_t>(std::min(std::max(sum, -32768), 32767));
+    }
+}
+
+static void
+float_to_int16_scalar(const float* src, int16_t* dst, size_t num_samples) {
+    for (size_t i = 0; i < num_samples; ++i) {
+        dst[i] = saturate_int16(src[i] * 32768.0f);
+    }
+}
+
+static void
+int16_to_float_scalar(const int16_t* src, float* dst, size_t num_samples) {
+    for (size_t i = 0; i < num_samples; ++i) {
+        dst[i] = src[i] * (1.0f / 32768.0f);
+    }
+}
+
+static void
+stereo_to_mono_scalar(const int16_t* src, int16_t* dst, size_t num_frames) {
+    for (size_t i = 0; i < num_frames; ++i) {
+        int32_t sum = int32_t(src[2 * i]) + src[2 * i + 1];
+        dst[i] = static_cast<int16_t>(sum >> 1);
+    }
+}
+
+static void
+mono_to_stereo_scalar(const int16_t* src, int16_t* dst, size_t num_frames) {
+    for (size_t i = 0; i < num_frames; ++i) {
+        dst[2 * i] = src[i];
+        dst[2 * i + 1] = src[i];
+    }
+}
+
+static const AudioKernels SCALAR_KERNELS = {
+        .name = "scalar",
+        .peak = peak_scalar,
+        .sum_squares = sum_squares_scalar,
+        .gain = gain_scalar,
+        .mix = mix_scalar,
+        .float_to_int16 = float_to_int16_scalar,
+        .int16_to_float = int16_to_float_scalar,
+        .stereo_to_mono = stereo_to_mono_scalar,
+        .mono_to_stereo = mono_to_stereo_scalar
+};
+
+#if defined(DAILY_AUDIO_X86)
+
+//
+// SSE2 (always available on x86_64).
+//
+
+// Zeroes NaN and clamps to the int16 range, like `saturate_int16()`.
+static inline __m128 clamp_int16_sse2(__m128 v) {
+    v = _mm_and_ps(v, _mm_cmpord_ps(v, v));
+    v = _mm_max_ps(v, _mm_set1_ps(-32768.0f));
+    return _mm_min_ps(v, _mm_set1_ps(32767.0f));
+}
+
+static uint32_t peak_sse2(const int16_t* samples, size_t num_samples) {
+    __m128i vmax = _mm_setzero_si128();
+    __m128i vmin = _mm_setzero_si128();
+    size_t i = 0;
+    for (; i + 8 <= num_samples; i += 8) {
+        __m128i v = _mm_loadu_si128((const __m128i*)(samples + i));
+        vmax = _mm_max_epi16(vmax, v);
+        vmin = _mm_min_epi16(vmin, v);
+    }
+    int16_t lanes_max[8];
+    int16_t lanes_min[8];
+    _mm_storeu_si128((__m128i*)lanes_max, vmax);
+    _mm_storeu_si128((__m128i*)lanes_min, vmin);
+    int32_t max = 0;
+    int32_t min = 0;
+    for (int lane = 0; lane < 8; ++lane) {
+        max = std::max<int32_t>(max, lanes_max[lane]);
+        min = std::min<int32_t>(min, lanes_min[lane]);
+    }
+    uint32_t peak = static_cast<uint32_t>(std::max(max, -min));
+    return std::max(peak, peak_scalar(samples + i, num_samples - i));
+}
+
+// Adjacent squares are added in 32 bits (2 * 32768^2 still fits unsigned) and
+// then widened into 64-bit accumulators.
+static uint64_t sum_squares_sse2(const int16_t* samples, size_t num_samples) {
+    __m128i zero = _mm_setzero_si128();
+    __m128i acc = _mm_setzero_si128();
+    size_t i = 0;
+    for (; i + 8 <= num_samples; i += 8) {
+        __m128i v = _mm_loadu_si128((const __m128i*)(samples + i));
+        __m128i squares = _mm_madd_epi16(v, v);
+        acc = _mm_add_epi64(acc, _mm_unpacklo_epi32(squares, zero));
+        acc = _mm_add_epi64(acc, _mm_unpackhi_epi32(squares, zero));
+    }
+    uint64_t lanes[2];
+    _mm_storeu_si128((__m128i*)lanes, acc);
+    return lanes[0] + lanes[1] +
+           sum_squares_scalar(samples + i, num_samples - i);
+}
+
+static void gain_sse2(int16_t* samples, size_t num_samples, float gain) {
+    __m128 vgain = _mm_set1_ps(gain);
+    size_t i = 0;
+    for (; i + 8 <= num_samples; i += 8) {
+        __m128i v = _mm_loadu_si128((const __m128i*)(samples + i));
+        // Sign extend to 32 bits.
+        __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+        __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16);
+        lo = _mm_cvtps_epi32(
+                clamp_int16_sse2(_mm_mul_ps(_mm_cvtepi32_ps(lo), vgain))
+        );
+        hi = _mm_cvtps_epi32(
+                clamp_int16_sse2(_mm_mul_ps(_mm_cvtepi32_ps(hi), vgain))
+        );
+        _mm_storeu_si128((__m128i*)(samples + i), _mm_packs_epi32(lo, hi));
+    }
+    gain_scalar(samples + i, num_samples - i, gain);
+}
+
+static void mix_sse2(int16_t* dst, const int16_t* src, size_t num_samples) {
+    size_t i = 0;
+    for (; i + 8 <= num_samples; i += 8) {
+        __m128i a = _mm_loadu_si128((const __m128i*)(dst + i));
+        __m128i b = _mm_loadu_si128((const __m128i*)(src + i));
+        _mm_storeu_si128((__m128i*)(dst + i), _mm_adds_epi16(a, b));
+    }
+    mix_scalar(dst + i, src + i, num_samples - i);
+}
+
+static void
+float_to_int16_sse2(const float* src, int16_t* dst, size_t num_samples) {
+    __m128 scale = _mm_set1_ps(32768.0f);
+    size_t i = 0;
+    for (; i + 8 <= num_samples; i += 8) {
+        __m128 lo = clamp_int16_sse2(_mm_mul_ps(_mm_loadu_ps(src + i), scale));
+        __m128 hi =
+                clamp_int16_sse2(_mm_mul_ps(_mm_loadu_ps(src + i + 4), scale));
+        __m128i packed =
+                _mm_packs_epi32(_mm_cvtps_epi32(lo), _mm_cvtps_epi32(hi));
+        _mm_storeu_si128((__m128i*)(dst + i), packed);
+    }
+    float_to_int16_scalar(src + i, dst + i, num_samples - i);
+}
+
+static void
+int16_to_float_sse2(const int16_t* src, float* dst, size_t num_samples) {
+    __m128 scale = _mm_set1_ps(1.0f / 32768.0f);
+    size_t i = 0;
+    for (; i + 8 <= num_samples; i += 8) {
+        __m128i v = _mm_loadu_si128((const __m128i*)(src + i));
+        __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+        __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16);
+        _mm_storeu_ps(dst + i, _mm_mul_ps(_mm_cvtepi32_ps(lo), scale));
+        _mm_storeu_ps(dst + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(hi), scale));
+    }
+    int16_to_float_scalar(src + i, dst + i, num_samples - i);
+}
+
+static void
+stereo_to_mono_sse2(const int16_t* src, int16_t* dst, size_t num_frames) {
+    __m128i ones = _mm_set1_epi16(1);
+    size_t i = 0;
+    for (; i + 8 <= num_frames; i += 8) {
+        __m128i a = _mm_loadu_si128((const __m128i*)(src + 2 * i));
+        __m128i b = _mm_loadu_si128((const __m128i*)(src + 2 * i + 8));
+        // Pairwise (left + right) sums in 32 bits.
+        __m128i sum_a = _mm_srai_epi32(_mm_madd_epi16(a, ones), 1);
+        __m128i sum_b = _mm_srai_epi32(_mm_madd_epi16(b, ones), 1);
+        _mm_storeu_si128((__m128i*)(dst + i), _mm_packs_epi32(sum_a, sum_b));
+    }
+    stereo_to_mono_scalar(src + 2 * i, dst + i, num_frames - i);
+}
+
+static void
+mono_to_stereo_sse2(const int16_t* src, int16_t* dst, size_t num_frames) {
+    size_t i = 0;
+    for (; i + 8 <= num_frames; i += 8) {
+        __m128i v = _mm_loadu_si128((const __m128i*)(src + i));
+        _mm_storeu_si128((__m128i*)(dst + 2 * i), _mm_unpacklo_epi16(v, v));
+        _mm_storeu_si128(
+                (__m128i*)(dst + 2 * i + 8), _mm_unpackhi_epi16(v, v)
+        );
+    }
+    mono_to_stereo_scalar(src + i, dst + 2 * i, num_frames - i);
+}
+
+static const AudioKernels SSE2_KERNELS = {
+        .name = "sse2",
+        .peak = peak_sse2,
+        .sum_squares = sum_squares_sse2,
+        .gain = gain_sse2,
+        .mix = mix_sse2,
+        .float_to_int16 = float_to_int16_sse2,
+        .int16_to_float = int16_to_float_sse2,
+        .stereo_to_mono = stereo_to_mono_sse2,
+        .mono_to_stereo = mono_to_stereo_sse2
+};
+
+//
+// AVX2. Note that 256-bit pack/unpack instructions operate on each 128-bit
+// lane separately, so their results need to be permuted back in order.
+//
+
+DAILY_AUDIO_AVX2_TARGET
+static uint32_t peak_avx2(const int16_t* samples, size_t num_samples) {
+    __m256i vmax = _mm256_setzero_si256();
+    __m256i vmin = _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i + 16 <= num_samples; i += 16) {
+        __m256i v = _mm256_loadu_si256((const __m256i*)(samples + i));
+        vmax = _mm256_max_epi16(vmax, v);
+        vmin = _mm256_min_epi16(vmin, v);
+    }
+    int16_t lanes_max[16];
+    int16_t lanes_min[16];
+    _mm256_storeu_si256((__m256i*)lanes_max, vmax);
+    _mm256_storeu_si256((__m256i*)lanes_min, vmin);
+    int32_t max = 0;
+    int32_t min = 0;
+    for (int lane = 0; lane < 16; ++lane) {
+        max = std::max<int32_t>(max, lanes_max[lane]);
+        min = std::min<int32_t>(min, lanes_min[lane]);
+    }
+    uint32_t peak = static_cast<uint32_t>(std::max(max, -min));
+    return std::max(peak, peak_scalar(samples + i, num_samples - i));
+}
+
+DAILY_AUDIO_AVX2_TARGET
+static uint64_t sum_squares_avx2(const int16_t* samples, size_t num_samples) {
+    __m256i zero = _mm256_setzero_si256();
+    __m256i acc = _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i + 16 <= num_samples; i += 16) {
+        __m256i v = _mm256_loadu_si256((const __m256i*)(samples + i));
+        __m256i squares = _mm256_madd_epi16(v, v);
+        acc = _mm256_add_epi64(acc, _mm256_unpacklo_epi32(squares, zero));
+        acc = _mm256_add_epi64(acc, _mm256_unpackhi_epi32(squares, zero));
+    }
+    uint64_t lanes[4];
+    _mm256_storeu_si256((__m256i*)lanes, acc);
+    return lanes[0] + lanes[1] + lanes[2] + lanes[3] +
+           sum_squares_scalar(samples + i, num_samples - i);
+}
+
+// Zeroes NaN and clamps to the int16 range, like `saturate_int16()`.
+DAILY_AUDIO_AVX2_TARGET
+static inline __m256 clamp_int16_avx2(__m256 v) {
+    v = _mm256_and_ps(v, _mm256_cmp_ps(v, v, _CMP_ORD_Q));
+    v = _mm256_max_ps(v, _mm256_set1_ps(-32768.0f));
+    return _mm256_min_ps(v, _mm256_set1_ps(32767.0f));
+}
+
+DAILY_AUDIO_AVX2_TARGET
+static void gain_avx2(int16_t* samples, size_t num_samples, float gain) {
+    __m256 vgain = _mm256_set1_ps(gain);
+    size_t i = 0;
+    for (; i + 16 <= num_samples; i += 16) {
+        __m256i lo = _mm256_cvtepi16_epi32(
+                _mm_loadu_si128((const __m128i*)(samples + i))
+        );
+        __m256i hi = _mm256_cvtepi16_epi32(
+                _mm_loadu_si128((const __m128i*)(samples + i + 8))
+        );
+        lo = _mm256_cvtps_epi32(
+                clamp_int16_avx2(_mm256_mul_ps(_mm256_cvtepi32_ps(lo), vgain))
+        );
+        hi = _mm256_cvtps_epi32(
+                clamp_int16_avx2(_mm256_mul_ps(_mm256_cvtepi32_ps(hi), vgain))
+        );
+        __m256i packed = _mm256_permute4x64_epi64(
+                _mm256_packs_epi32(lo, hi), _MM_SHUFFLE(3, 1, 2, 0)
+        );
+        _mm256_storeu_si256((__m256i*)(samples + i), packed);
+    }
+    gain_scalar(samples + i, num_samples - i, gain);
+}
+
+DAILY_AUDIO_AVX2_TARGET
+static void mix_avx2(int16_t* dst, const int16_t* src, size_t num_samples) {
+    size_t i = 0;
+    for (; i + 16 <= num_samples; i += 16) {
+        __m256i a = _mm256_loadu_si256((const __m256i*)(dst + i));
+        __m256i b = _mm256_loadu_si256((const __m256i*)(src + i));
+        _mm256_storeu_si256((__m256i*)(dst + i), _mm256_adds_epi16(a, b));
+    }
+    mix_scalar(dst + i, src + i, num_samples - i);
+}
+
+DAILY_AUDIO_AVX2_TARGET
+static void
+float_to_int16_avx2(const float* src, int16_t* dst, size_t num_samples) {
+    __m256 scale = _mm256_set1_ps(32768.0f);
+    size_t i = 0;
+    for (; i + 16 <= num_samples; i += 16) {
+        __m256 lo = clamp_int16_avx2(
+                _mm256_mul_ps(_mm256_loadu_ps(src + i), scale)
+        );
+        __m256 hi = clamp_int16_avx2(
+                _mm256_mul_ps(_mm256_loadu_ps(src + i + 8), scale)
+        );
+        __m256i packed = _mm256_packs_epi32(
+                _mm256_cvtps_epi32(lo), _mm256_cvtps_epi32(hi)
+        );
+        packed = _mm256_permute4x64_epi64(packed, _MM_SHUFFLE(3, 1, 2, 0));
+        _mm256_storeu_si256((__m256i*)(dst + i), packed);
+    }
+    float_to_int16_scalar(src + i, dst + i, num_samples - i);
+}
+
+DAILY_AUDIO_AVX2_TARGET
+static void
+int16_to_float_avx2(const int16_t* src, float* dst, size_t num_samples) {
+    __m256 scale = _mm256_set1_ps(1.0f / 32768.0f);
+    size_t i = 0;
+    for (; i + 8 <= num_samples; i += 8) {
+        __m256i v = _mm256_cvtepi16_epi32(
+                _mm_loadu_si128((const __m128i*)(src + i))
+        );
+        _mm256_storeu_ps(dst + i, _mm256_mul_ps(_mm256_cvtepi32_ps(v), scale));
+    }
+    int16_to_float_scalar(src + i, dst + i, num_samples - i);
+}
+
+DAILY_AUDIO_AVX2_TARGET
+static void
+stereo_to_mono_avx2(const int16_t* src, int16_t* dst, size_t num_frames) {
+    __m256i ones = _mm256_set1_epi16(1);
+    size_t i = 0;
+    for (; i + 16 <= num_frames; i += 16) {
+        __m256i a = _mm256_loadu_si256((const __m256i*)(src + 2 * i));
+        __m256i b = _mm256_loadu_si256((const __m256i*)(src + 2 * i + 16));
+        __m256i sum_a = _mm256_srai_epi32(_mm256_madd_epi16(a, ones), 1);
+        __m256i sum_b = _mm256_srai_epi32(_mm256_madd_epi16(b, ones), 1);
+        __m256i packed = _mm256_permute4x64_epi64(
+                _mm256_packs_epi32(sum_a, sum_b), _MM_SHUFFLE(3, 1, 2, 0)
+        );
+        _mm256_storeu_si256((__m256i*)(dst + i), packed);
+    }
+    stereo_to_mono_scalar(src + 2 * i, dst + i, num_frames - i);
+}
+
+DAILY_AUDIO_AVX2_TARGET
+static void
+mono_to_stereo_avx2(const int16_t* src, int16_t* dst, size_t num_frames) {
+    size_t i = 0;
+    for (; i + 16 <= num_frames; i += 16) {
+        __m256i v = _mm256_loadu_si256((const __m256i*)(src + i));
+        __m256i lo = _mm256_unpacklo_epi16(v, v);
+        __m256i hi = _mm256_unpackhi_epi16(v, v);
+        _mm256_storeu_si256(
+                (__m256i*)(dst + 2 * i), _mm256_permute2x128_si256(lo, hi, 0x20)
+        );
+        _mm256_storeu_si256(
+                (__m256i*)(dst + 2 * i + 16),
+                _mm256_permute2x128_si256(lo, hi, 0x31)
+        );
+    }
+    mono_to_stereo_scalar(src + i, dst + 2 * i, num_frames - i);
+}
+
+static const AudioKernels AVX2_KERNELS = {
+        .name = "avx2",
+        .peak = peak_avx2,
+        .sum_squares = sum_squares_avx2,
+        .gain = gain_avx2,
+        .mix = mix_avx2,
+        .float_to_int16 = float_to_int16_avx2,
+        .int16_to_float = int16_to_float_avx2,
+        .stereo_to_mono = stereo_to_mono_avx2,
+        .mono_to_stereo = mono_to_stereo_avx2
+};
+
+static bool cpu_has_avx2() {
+#ifdef _MSC_VER
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) {
+        return false;
+    }
+    __cpuid(info, 1);
+    // OSXSAVE and AVX, and the OS saves the YMM registers.
+    bool avx = (info[2] & (1 << 27)) && (info[2] & (1 << 28)) &&
+               ((_xgetbv(0) & 0x6) == 0x6);
+    __cpuidex(info, 7, 0);
+    return avx && (info[1] & (1 << 5));
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+
+#elif defined(DAILY_AUDIO_NEON)
+
+//
+// NEON (always available on aarch64).
+//
+
+static uint32_t peak_neon(const int16_t* samples, size_t num_samples) {
+    int16x8_t vmax = vdupq_n_s16(0);
+    int16x8_t vmin = vdupq_n_s16(0);
+    size_t i = 0;
+    for (; i + 8 <= num_samples; i += 8) {
+        int16x8_t v = vld1q_s16(samples + i);
+        vmax = vmaxq_s16(vmax, v);
+        vmin = vminq_s16(vmin, v);
+    }
+    int32_t max = vmaxvq_s16(vmax);
+    int32_t min = vminvq_s16(vmin);
+    uint32_t peak = static_cast<uint32_t>(std::max(max, -min));
+    return std::max(peak, peak_scalar(samples + i, num_samples - i));
+}
+
+static uint64_t sum_squares_neon(const int16_t* samples, size_t num_samples) {
+    uint64x2_t acc = vdupq_n_u64(0);
+    size_t i = 0;
+    for (; i + 8 <= num_samples; i += 8) {
+        int16x8_t v = vld1q_s16(samples + i);
+        // Each square fits in 31 bits, so they can be added as unsigned.
+        uint32x4_t lo = vreinterpretq_u32_s32(
+                vmull_s16(vget_low_s16(v), vget_low_s16(v))
+        );
+        uint32x4_t hi = vreinterpretq_u32_s32(
+                vmull_s16(vget_high_s16(v), vget_high_s16(v))
+        );
+        acc = vpadalq_u32(acc, lo);
+        acc = vpadalq_u32(acc, hi);
+    }
+    return vaddvq_u64(acc) + sum_squares_scalar(samples + i, num_samples - i);
+}
+
+static void gain_neon(int16_t* samples, size_t num_samples, float gain) {
+    size_t i = 0;
+    for (; i + 8 <= num_samples; i += 8) {
+        int16x8_t v = vld1q_s16(samples + i);
+        float32x4_t lo = vcvtq_f32_s32(vmovl_s16(vget_low_s16(v)));
+        float32x4_t hi = vcvtq_f32_s32(vmovl_s16(vget_high_s16(v)));
+        int32x4_t lo_i = vcvtnq_s32_f32(vmulq_n_f32(lo, gain));
+        int32x4_t hi_i = vcvtnq_s32_f32(vmulq_n_f32(hi, gain));
+        vst1q_s16(
+                samples + i, vcombine_s16(vqmovn_s32(lo_i), vqmovn_s32(hi_i))
+        );
+    }
+    gain_scalar(samples + i, num_samples - i, gain);
+}
+
+static void mix_neon(int16_t* dst, const int16_t* src, size_t num_samples) {
+    size_t i = 0;
+    for (; i + 8 <= num_samples; i += 8) {
+        vst1q_s16(dst + i, vqaddq_s16(vld1q_s16(dst + i), vld1q_s16(src + i)));
+    }
+    mix_scalar(dst + i, src + i, num_samples - i);
+}
+
+static void
+float_to_int16_neon(const float* src, int16_t* dst, size_t num_samples) {
+    size_t i = 0;
+    for (; i + 8 <= num_samples; i += 8) {
+        // Float to int conversion and narrowing both saturate.
+        float32x4_t lo = vmulq_n_f32(vld1q_f32(src + i), 32768.0f);
+        float32x4_t hi = vmulq_n_f32(vld1q_f32(src + i + 4), 32768.0f);
+        int32x4_t lo_i = vcvtnq_s32_f32(lo);
+        int32x4_t hi_i = vcvtnq_s32_f32(hi);
+        vst1q_s16(dst + i, vcombine_s16(vqmovn_s32(lo_i), vqmovn_s32(hi_i)));
+    }
+    float_to_int16_scalar(src + i, dst + i, num_samples - i);
+}
+
+static void
+int16_to_float_neon(const int16_t* src, float* dst, size_t num_samples) {
+    size_t i = 0;
+    for (; i + 8 <= num_samples; i += 8) {
+        int16x8_t v = vld1q_s16(src + i);
+        float32x4_t lo = vcvtq_f32_s32(vmovl_s16(vget_low_s16(v)));
+        float32x4_t hi = vcvtq_f32_s32(vmovl_s16(vget_high_s16(v)));
+        vst1q_f32(dst + i, vmulq_n_f32(lo, 1.0f / 32768.0f));
+        vst1q_f32(dst + i + 4, vmulq_n_f32(hi, 1.0f / 32768.0f));
+    }
+    int16_to_float_scalar(src + i, dst + i, num_samples - i);
+}
+
+static void
+stereo_to_mono_neon(const int16_t* src, int16_t* dst, size_t num_frames) {
+    size_t i = 0;
+    for (; i + 8 <= num_frames; i += 8) {
+        int16x8x2_t v = vld2q_s16(src + 2 * i);
+        vst1q_s16(dst + i, vhaddq_s16(v.val[0], v.val[1]));
+    }
+    stereo_to_mono_scalar(src + 2 * i, dst + i, num_frames - i);
+}
+
+static void
+mono_to_stereo_neon(const int16_t* src, int16_t* dst, size_t num_frames) {
+    size_t i = 0;
+    for (; i + 8 <= num_frames; i += 8) {
+        int16x8_t v = vld1q_s16(src + i);
+        int16x8x2_t stereo = {{v, v}};
+        vst2q_s16(dst + 2 * i, stereo);
+    }
+    mono_to_stereo_scalar(src + i, dst + 2 * i, num_frames - i);
+}
+
+static const AudioKernels NEON_KERNELS = {
+        .name = "neon",
+        .peak = peak_neon,
+        .sum_squares = sum_squares_neon,
+        .gain = gain_neon,
+        .mix = mix_neon,
+        .float_to_int16 = float_to_int16_neon,
+        .int16_to_float = int16_to_float_neon,
+        .stereo_to_mono = stereo_to_mono_neon,
+        .mono_to_stereo = mono_to_stereo_neon
+};
+
+#endif
+
+static const AudioKernels& select_kernels() {
+#if defined(DAILY_AUDIO_X86)
+    return cpu_has_avx2() ? AVX2_KERNELS : SSE2_KERNELS;
+#elif defined(DAILY_AUDIO_NEON)
+    return NEON_KERNELS;
+#else
+    return SCALAR_KERNELS;
+#endif
+}
+
+static std::atomic<const AudioKernels*> selected_kernels(nullptr);
+
+static const AudioKernels& kernels() {
+    const AudioKernels* selected =
+            selected_kernels.load(std::memory_order_acquire);
+    if (!selected) {
+        // Racing threads select the same implementation.
+        selected = &select_kernels();
+        selected_kernels.store(selected, std::memory_order_release);
+    }
+    return *selected;
+}
+
+const char* rtvi::audio_kernels_name() {
+    return kernels().name;
+}
+
+bool rtvi::audio_select_kernels(const char* name) {
+    const AudioKernels* candidates[] = {
+            &SCALAR_KERNELS,
+#if defined(DAILY_AUDIO_X86)
+            &SSE2_KERNELS,
+            cpu_has_avx2() ? &AVX2_KERNELS : nullptr,
+#elif defined(DAILY_AUDIO_NEON)
+            &NEON_KERNELS,
+#endif
+    };
+
+    for (const AudioKernels* candidate : candidates) {
+        if (candidate && strcmp(candidate->name, name) == 0) {
+            selected_kernels.store(candidate, std::memory_order_release);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+uint32_t rtvi::audio_peak(const int16_t* samples, size_t num_samples) {
+    return kernels().peak(samples, num_samples);
+}
+
+uint64_t rtvi::audio_sum_squares(const int16_t* samples, size_t num_samples) {
+    return kernels().sum_squares(samples, num_samples);
+}
+
+void rtvi::audio_gain(int16_t* samples, size_t num_samples, float gain) {
+    kernels().gain(samples, num_samples, gain);
+}
+
+void rtvi::audio_mix(int16_t* dst, const int16_t* src, size_t num_samples) {
+    kernels().mix(dst, src, num_samples);
+}
+
+void rtvi::audio_float_to_int16(
+        const float* src,
+        int16_t* dst,
+        size_t num_samples
+) {
+    kernels().float_to_int16(src, dst, num_samples);
+}
+
+void rtvi::audio_int16_to_float(
+        const int16_t* src,
+        float* dst,
+        size_t num_samples
+) {
+    kernels().int16_to_float(src, dst, num_samples);
+}
+
+void rtvi::audio_stereo_to_mono(
+        const int16_t* src,
+        int16_t* dst,
+        size_t num_frames
+) {
+    kernels().stereo_to_mono(src, dst, num_frames);
+}
+
+void rtvi::audio_mono_to_stereo(
+        const int16_t* src,
+        int16_t* dst,
+        size_t num_frames
+) {
+    kernels().mono_to_stereo(src, dst, num_frames);
+}
+
+// Planes are converted in blocks with the dispatched kernels and then
+// (de)interleaved, so the conversion itself is still vectorized.
+static const size_t PLANAR_BLOCK_SAMPLES = 256;
+
+void rtvi::audio_planar_float_to_int16(
+        const float* src,
+        int16_t* dst,
+        size_t num_frames,
+        uint32_t num_channels,
+        size_t plane_stride
+) {
+    int16_t block[PLANAR_BLOCK_SAMPLES];
+
+    for (uint32_t channel = 0; channel < num_channels; ++channel) {
+        const float* plane = src + channel * plane_stride;
+        for (size_t offset = 0; offset < num_frames;
+             offset += PLANAR_BLOCK_SAMPLES) {
+            size_t count =
+                    std::min(PLANAR_BLOCK_SAMPLES, num_frames - offset);
+            kernels().float_to_int16(plane + offset, block, count);
+            for (size_t i = 0; i < count; ++i) {
+                dst[(offset + i) * num_channels + channel] = block[i];
+            }
+        }
+    }
+}
+
+void rtvi::audio_int16_to_planar_float(
+        const int16_t* src,
+        float* dst,
+        size_t num_frames,
+        uint32_t num_channels,
+        size_t plane_stride
+) {
+    int16_t block[PLANAR_BLOCK_SAMPLES];
+
+    for (uint32_t channel = 0; channel < num_channels; ++channel) {
+        float* plane = dst + channel * plane_stride;
+        for (size_t offset = 0; offset < num_frames;
+             offset += PLANAR_BLOCK_SAMPLES) {
+            size_t count =
+                    std::min(PLANAR_BLOCK_SAMPLES, num_frames - offset);
+            for (size_t i = 0; i < count; ++i) {
+                block[i] = src[(offset + i) * num_channels + channel];
+            }
+            kernels().int16_to_float(block, plane + offset, count);
+        }
+    }
+}
@@ -0,0 +1,98 @@
+//
+// Copyright (c) 2024, Daily
+//
+
+#include "daily_audio_meter.h"
+
+#include "daily_audio.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace rtvi;
+
+static const uint32_t BLOCK_MS = 10;
+
+DailyAudioMeter::DailyAudioMeter(
+        uint32_t sample_rate,
+        uint32_t num_channels,
+        float speaking_threshold_dbfs,
+        uint32_t speaking_hangover_ms
+)
+    : _num_channels(num_channels),
+      _block_samples(sample_rate * BLOCK_MS / 1000 * num_channels),
+      _speaking_threshold(std::pow(10.0f, speaking_threshold_dbfs / 20.0f)),
+      _hangover_blocks(std::max(speaking_hangover_ms / BLOCK_MS, 1u)),
+      _block_filled(0),
+      _sum_squares(0),
+      _peak(0),
+      _quiet_blocks(0),
+      _rms_level(0.0f),
+      _peak_level(0.0f),
+      _speaking(false),
+      _blocks(0) {}
+
+bool DailyAudioMeter::process(const int16_t* frames, size_t num_frames) {
+    if (_block_samples == 0) {
+        return false;
+    }
+
+    size_t num_samples = num_frames * _num_channels;
+    bool changed = false;
+
+    while (num_samples > 0) {
+        size_t count = std::min(num_samples, _block_samples - _block_filled);
+
+        _sum_squares += audio_sum_squares(frames, count);
+        _peak = std::max(_peak, audio_peak(frames, count));
+        _block_filled += count;
+
+        frames += count;
+        num_samples -= count;
+
+        if (_block_filled == _block_samples) {
+            changed |= finish_block();
+        }
+    }
+
+    return changed;
+}
+
+DailyAudioLevels DailyAudioMeter::levels() const {
+    return DailyAudioLevels {
+            .rms = _rms_level.load(std::memory_order_relaxed),
+            .peak = _peak_level.load(std::memory_order_relaxed),
+            .speaking = _speaking.load(std::memory_order_relaxed)
+    };
+}
+
+// Private
+
+bool DailyAudioMeter::finish_block() {
+    float rms = std::sqrt(static_cast<float>(_sum_squares) / _block_samples) /
+                32768.0f;
+    float peak = _peak / 32768.0f;
+
+    _rms_level.store(rms, std::memory_order_relaxed);
+    _peak_level.store(peak, std::memory_order_relaxed);
+    _blocks.fetch_add(1, std::memory_order_relaxed);
+
+    _block_filled = 0;
+    _sum_squares = 0;
+    _peak = 0;
+
+    bool speaking = _speaking.load(std::memory_order_relaxed);
+
+    if (rms >= _speaking_threshold) {
+        _quiet_blocks = 0;
+        if (!speaking) {
+            _speaking.store(true, std::memory_order_relaxed);
+            return true;
+        }
+    } else if (speaking && ++_quiet_blocks >= _hangover_blocks) {
+        _speaking.store(false, std::memory_order_relaxed);
+        return true;
+    }
+
+    return false;
+}
@@ -0,0 +1,211 @@
+//
+// Copyright (c) 2024, Daily
+//
+
+#include "daily_audio_pacer.h"
+
+#include <algorithm>
+#include <cstring>
+
+using namespace rtvi;
+
+static const uint32_t BLOCK_MS = 10;
+
+// If we wake up this many blocks late (e.g. the machine was suspended or
+// heavily loaded) we restart the schedule. Writing all the missed blocks at
+// once would overflow the device.
+static const uint32_t MAX_LATE_BLOCKS = 5;
+
+DailyAudioPacer::DailyAudioPacer(
+        uint32_t sample_rate,
+        uint32_t num_channels,
+        Writer writer,
+        const DailyThreadConfig& thread_config
+)
+    : _num_channels(num_channels),
+      _block_frames(sample_rate * BLOCK_MS / 1000),
+      _writer(std::move(writer)),
+      _thread_config(thread_config),
+      _queue_offset(0),
+      _block(_block_frames * num_channels),
+      _running(false),
+      _frames_written(0),
+      _frames_dropped(0),
+      _write_errors(0),
+      _idle_ticks(0),
+      _max_lateness_us(0),
+      _resyncs(0) {}
+
+DailyAudioPacer::~DailyAudioPacer() {
+    stop();
+}
+
+void DailyAudioPacer::start(double speed) {
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (_running) {
+            return;
+        }
+        _running = true;
+    }
+
+    auto period = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::duration<double, std::milli>(BLOCK_MS / speed)
+    );
+
+    _thread = std::thread(&DailyAudioPacer::pace_thread, this, period);
+}
+
+void DailyAudioPacer::stop() {
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (!_running) {
+            return;
+        }
+        _running = false;
+    }
+    _cv.notify_one();
+
+    _thread.join();
+
+    clear();
+}
+
+void DailyAudioPacer::push(const int16_t* frames, size_t num_frames) {
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+
+        // Reclaim consumed space once it's at least half of the queue, so we
+        // don't shift samples on every block.
+        if (_queue_offset > 0 && _queue_offset >= _queue.size() / 2) {
+            _queue.erase(_queue.begin(), _queue.begin() + _queue_offset);
+            _queue_offset = 0;
+        }
+
+        _queue.insert(
+                _queue.end(), frames, frames + num_frames * _num_channels
+        );
+    }
+    _cv.notify_one();
+}
+
+void DailyAudioPacer::clear() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _queue.clear();
+    _queue_offset = 0;
+}
+
+size_t DailyAudioPacer::queued_frames() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return (_queue.size() - _queue_offset) / _num_channels;
+}
+
+size_t DailyAudioPacer::memory_bytes() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return (_queue.capacity() + _block.capacity()) * sizeof(int16_t);
+}
+
+DailyAudioPacerStats DailyAudioPacer::stats() const {
+    return DailyAudioPacerStats {
+            .frames_written = _frames_written,
+            .frames_queued = queued_frames(),
+            .frames_dropped = _frames_dropped,
+            .write_errors = _write_errors,
+            .idle_ticks = _idle_ticks,
+            .max_lateness_us = _max_lateness_us,
+            .resyncs = _resyncs
+    };
+}
+
+// Private
+
+size_t DailyAudioPacer::pop_block() {
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    size_t num_samples =
+            std::min(_queue.size() - _queue_offset, _block.size());
+    if (num_samples == 0) {
+        return 0;
+    }
+
+    std::memcpy(
+            _block.data(),
+            _queue.data() + _queue_offset,
+            num_samples * sizeof(int16_t)
+    );
+
+    _queue_offset += num_samples;
+    if (_queue_offset == _queue.size()) {
+        _queue.clear();
+        _queue_offset = 0;
+    }
+
+    return num_samples / _num_channels;
+}
+
+void DailyAudioPacer::pace_thread(std::chrono::nanoseconds period) {
+    daily_configure_thread("daily-pacer", _thread_config);
+
+    auto start = std::chrono::steady_clock::now();
+    int64_t ticks = 0;
+
+    while (true) {
+        // The last block of a stream might be shorter than 10ms.
+        size_t num_frames = pop_block();
+
+        // Wait for more audio and start a new schedule, instead of waking up
+        // every block for nothing.
+        if (num_frames == 0) {
+            _idle_ticks++;
+
+            std::unique_lock<std::mutex> lock(_mutex);
+            _cv.wait(lock, [this] {
+                return !_running || _queue.size() > _queue_offset;
+            });
+            if (!_running) {
+                break;
+            }
+            lock.unlock();
+
+            start = std::chrono::steady_clock::now();
+            ticks = 0;
+            continue;
+        }
+
+        // Failed frames are not retried, the audio would be late anyway.
+        int32_t written = _writer(_block.data(), num_frames);
+        if (written < 0) {
+            _write_errors++;
+            written = 0;
+        }
+        _frames_written += written;
+        _frames_dropped += num_frames - written;
+
+        auto deadline = start + period * ++ticks;
+
+        std::unique_lock<std::mutex> lock(_mutex);
+        _cv.wait_until(lock, deadline, [this] { return !_running; });
+        if (!_running) {
+            break;
+        }
+        lock.unlock();
+
+        auto now = std::chrono::steady_clock::now();
+        auto lateness = std::max(
+                now - deadline, std::chrono::steady_clock::duration::zero()
+        );
+
+        uint64_t lateness_us =
+                std::chrono::duration_cast<std::chrono::microseconds>(lateness)
+                        .count();
+        if (lateness_us > _max_lateness_us) {
+            _max_lateness_us = lateness_us;
+        }
+
+        if (lateness > period * MAX_LATE_BLOCKS) {
+            start = now;
+            ticks = 0;
+            _resyncs++;
+        }
+    }
+}
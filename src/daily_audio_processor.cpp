@@ -0,0 +1,469 @@
+//
+// Copyright (c) 2024, Daily
+//
+
+#include "daily_audio_processor.h"
+
+#include "daily_audio.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+
+using namespace rtvi;
+
+static const uint32_t BLOCK_MS = 10;
+
+// Bounds the NLMS cost, which is `2 * taps` multiply-adds per sample.
+static const size_t AEC_MAX_TAPS = 1024;
+
+// NLMS step size and regularization (per tap).
+static const float AEC_STEP = 0.5f;
+static const float AEC_REGULARIZATION = 1e-6f;
+
+// Reference below this peak is considered silence, there's no echo to
+// cancel.
+static const float AEC_SILENCE_PEAK = 1e-3f;
+
+// Geigel double-talk detector. If the user audio is louder than half the
+// recent bot audio peak the user is probably talking, so we stop adapting the
+// filter (assumes at least 6dB of echo loss).
+static const float AEC_DOUBLE_TALK_RATIO = 0.5f;
+
+// The noise floor follows quieter blocks quickly and rises at ~1dB/s.
+static const float NS_FLOOR_FALL = 0.5f;
+static const float NS_FLOOR_RISE = 1.00115f;
+static const float NS_FLOOR_MIN = 1.0f;
+
+// Blocks below 6dB of SNR are fully attenuated, blocks above 12dB are left
+// untouched.
+static const float NS_SNR_LOW = 2.0f;
+static const float NS_SNR_HIGH = 4.0f;
+
+// Attenuation is released over ~100ms, but removed immediately so speech
+// onsets are not clipped.
+static const float NS_RELEASE = 0.1f;
+
+// Blocks below -50 dBFS are not used to update the gain, so we don't boost
+// silence.
+static const float AGC_GATE_RMS = 104.0f;
+static const float AGC_MIN_GAIN = 0.1f;
+static const float AGC_DECAY = 0.5f;
+// ~6dB/s
+static const float AGC_RISE = 1.0069f;
+
+// Seconds of (mono) echo reference we can buffer.
+static const uint32_t REFERENCE_SECONDS = 1;
+
+static float rms(const int16_t* samples, size_t num_samples) {
+    uint64_t sum = audio_sum_squares(samples, num_samples);
+    return std::sqrt(static_cast<float>(sum) / num_samples);
+}
+
+static float dot(const float* a, const float* b, size_t n) {
+    // Independent accumulators so the compiler can keep several multiplies in
+    // flight.
+    float s0 = 0.0f, s1 = 0.0f, s2 = 0.0f, s3 = 0.0f;
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        s0 += a[i] * b[i];
+        s1 += a[i + 1] * b[i + 1];
+        s2 += a[i + 2] * b[i + 2];
+        s3 += a[i + 3] * b[i + 3];
+    }
+    for (; i < n; ++i) {
+        s0 += a[i] * b[i];
+    }
+    return (s0 + s1) + (s2 + s3);
+}
+
+static int16_t saturate(float sample) {
+    return static_cast<int16_t>(std::clamp(sample, -32768.0f, 32767.0f));
+}
+
+// Moves the gain linearly from `from` to `to` over the block, to avoid
+// zipper noise.
+static void apply_gain_ramp(
+        int16_t* frames,
+        size_t num_frames,
+        uint32_t num_channels,
+        float from,
+        float to
+) {
+    if (from == to && from == 1.0f) {
+        return;
+    }
+
+    float step = (to - from) / num_frames;
+    float gain = from;
+    for (size_t i = 0; i < num_frames; ++i) {
+        gain += step;
+        for (uint32_t c = 0; c < num_channels; ++c) {
+            int16_t& sample = frames[i * num_channels + c];
+            sample = saturate(sample * gain);
+        }
+    }
+}
+
+//
+// DailyEchoCanceller
+//
+
+DailyEchoCanceller::DailyEchoCanceller(uint32_t sample_rate, uint32_t tail_ms)
+    : _num_taps(std::clamp<size_t>(
+              size_t(sample_rate) * tail_ms / 1000, 1, AEC_MAX_TAPS
+      )),
+      _weights(_num_taps, 0.0f),
+      _history(_num_taps - 1 + sample_rate * BLOCK_MS / 1000, 0.0f),
+      _near(sample_rate * BLOCK_MS / 1000, 0.0f) {}
+
+void DailyEchoCanceller::process(
+        int16_t* frames,
+        size_t num_frames,
+        uint32_t num_channels,
+        const int16_t* reference
+) {
+    if (num_channels != 1 || num_frames != _near.size()) {
+        return;
+    }
+
+    // Keep the last `_num_taps - 1` samples and append the new block.
+    size_t keep = _num_taps - 1;
+    std::memmove(
+            _history.data(), _history.data() + num_frames, keep * sizeof(float)
+    );
+
+    float ref_peak = 0.0f;
+    for (size_t i = 0; i < num_frames; ++i) {
+        _history[keep + i] = reference[i] / 32768.0f;
+    }
+    for (float sample : _history) {
+        ref_peak = std::max(ref_peak, std::abs(sample));
+    }
+
+    if (ref_peak < AEC_SILENCE_PEAK) {
+        return;
+    }
+
+    float near_peak = 0.0f;
+    for (size_t i = 0; i < num_frames; ++i) {
+        _near[i] = frames[i] / 32768.0f;
+        near_peak = std::max(near_peak, std::abs(_near[i]));
+    }
+
+    bool adapt = near_peak <= AEC_DOUBLE_TALK_RATIO * ref_peak;
+
+    // Energy of the reference window of the first sample, updated as the
+    // window slides.
+    float energy = dot(_history.data(), _history.data(), _num_taps);
+    float regularization = AEC_REGULARIZATION * _num_taps;
+
+    for (size_t i = 0; i < num_frames; ++i) {
+        const float* x = _history.data() + i;
+
+        float error = _near[i] - dot(_weights.data(), x, _num_taps);
+
+        if (adapt) {
+            float mu = AEC_STEP * error / (energy + regularization);
+            for (size_t j = 0; j < _num_taps; ++j) {
+                _weights[j] += mu * x[j];
+            }
+        }
+
+        frames[i] = saturate(error * 32768.0f);
+
+        if (i + 1 < num_frames) {
+            energy += x[_num_taps] * x[_num_taps] - x[0] * x[0];
+            energy = std::max(energy, 0.0f);
+        }
+    }
+}
+
+//
+// DailyNoiseSuppressor
+//
+
+DailyNoiseSuppressor::DailyNoiseSuppressor(float max_attenuation_db)
+    : _min_gain(std::pow(10.0f, -max_attenuation_db / 20.0f)),
+      _noise_floor(0.0f),
+      _gain(1.0f) {}
+
+void DailyNoiseSuppressor::process(
+        int16_t* frames,
+        size_t num_frames,
+        uint32_t num_channels,
+        const int16_t* reference
+) {
+    float level = rms(frames, num_frames * num_channels);
+
+    if (_noise_floor == 0.0f || level < _noise_floor) {
+        _noise_floor += (level - _noise_floor) * NS_FLOOR_FALL;
+    } else {
+        _noise_floor *= NS_FLOOR_RISE;
+    }
+    _noise_floor = std::max(_noise_floor, NS_FLOOR_MIN);
+
+    float snr = level / _noise_floor;
+
+    float target;
+    if (snr >= NS_SNR_HIGH) {
+        target = 1.0f;
+    } else if (snr <= NS_SNR_LOW) {
+        target = _min_gain;
+    } else {
+        float t = (snr - NS_SNR_LOW) / (NS_SNR_HIGH - NS_SNR_LOW);
+        target = _min_gain + (1.0f - _min_gain) * t;
+    }
+
+    float gain = target;
+    if (target < _gain) {
+        gain = _gain + (target - _gain) * NS_RELEASE;
+    }
+
+    apply_gain_ramp(frames, num_frames, num_channels, _gain, gain);
+
+    _gain = gain;
+}
+
+//
+// DailyGainControl
+//
+
+DailyGainControl::DailyGainControl(float target_dbfs, float max_gain_db)
+    : _target_rms(32768.0f * std::pow(10.0f, target_dbfs / 20.0f)),
+      _max_gain(std::pow(10.0f, max_gain_db / 20.0f)),
+      _gain(1.0f) {}
+
+void DailyGainControl::process(
+        int16_t* frames,
+        size_t num_frames,
+        uint32_t num_channels,
+        const int16_t* reference
+) {
+    float level = rms(frames, num_frames * num_channels);
+
+    float gain = _gain;
+
+    if (level >= AGC_GATE_RMS) {
+        float desired =
+                std::clamp(_target_rms / level, AGC_MIN_GAIN, _max_gain);
+        if (desired < _gain) {
+            gain = _gain + (desired - _gain) * AGC_DECAY;
+        } else {
+            gain = std::min(desired, _gain * AGC_RISE);
+        }
+    }
+
+    apply_gain_ramp(frames, num_frames, num_channels, _gain, gain);
+
+    _gain = gain;
+}
+
+//
+// DailyAudioProcessor
+//
+
+DailyAudioProcessor::DailyAudioProcessor(
+        uint32_t sample_rate,
+        uint32_t num_channels
+)
+    : _sample_rate(sample_rate),
+      _num_channels(num_channels),
+      _block_frames(sample_rate * BLOCK_MS / 1000),
+      _pending(_block_frames * num_channels),
+      _pending_frames(0),
+      _max_reference_backlog(0),
+      _reference(sample_rate * REFERENCE_SECONDS, 1),
+      _reference_block(_block_frames),
+      _reference_mono(_block_frames) {}
+
+std::unique_ptr<DailyAudioProcessor> DailyAudioProcessor::create_default(
+        uint32_t sample_rate,
+        uint32_t num_channels
+) {
+    auto processor =
+            std::make_unique<DailyAudioProcessor>(sample_rate, num_channels);
+    processor->add_stage(std::make_unique<DailyEchoCanceller>(sample_rate));
+    processor->add_stage(std::make_unique<DailyNoiseSuppressor>());
+    processor->add_stage(std::make_unique<DailyGainControl>());
+    return processor;
+}
+
+void DailyAudioProcessor::add_stage(std::unique_ptr<DailyAudioStage> stage) {
+    // The reference read for a block is older than the newest bot audio by
+    // the backlog, which leaves the rest of the stage history for the echo
+    // path. Half of it absorbs bot audio read in large chunks.
+    _max_reference_backlog =
+            std::max(_max_reference_backlog, stage->reference_frames() / 2);
+
+    auto slot = std::make_unique<Slot>();
+    slot->stage = std::move(stage);
+    slot->enabled = true;
+    slot->blocks = 0;
+    slot->total_ns = 0;
+    slot->max_ns = 0;
+    _slots.push_back(std::move(slot));
+}
+
+std::vector<std::string> DailyAudioProcessor::stage_names() const {
+    std::vector<std::string> names;
+    for (const auto& slot : _slots) {
+        names.push_back(slot->stage->name());
+    }
+    return names;
+}
+
+bool DailyAudioProcessor::set_stage_enabled(
+        const std::string& name,
+        bool enabled
+) {
+    Slot* slot = find_slot(name);
+    if (!slot) {
+        return false;
+    }
+    slot->enabled = enabled;
+    return true;
+}
+
+DailyAudioStageStats
+DailyAudioProcessor::stage_stats(const std::string& name) const {
+    const Slot* slot = find_slot(name);
+    if (!slot) {
+        return DailyAudioStageStats {};
+    }
+    return DailyAudioStageStats {
+            .blocks = slot->blocks,
+            .total_ns = slot->total_ns,
+            .max_ns = slot->max_ns
+    };
+}
+
+size_t DailyAudioProcessor::process(
+        const int16_t* frames,
+        size_t num_frames,
+        int16_t* output
+) {
+    size_t frame_size = _num_channels * sizeof(int16_t);
+
+    size_t total_frames = _pending_frames + num_frames;
+    size_t output_frames = total_frames - total_frames % _block_frames;
+
+    if (output_frames == 0) {
+        std::memcpy(
+                _pending.data() + _pending_frames * _num_channels,
+                frames,
+                num_frames * frame_size
+        );
+        _pending_frames = total_frames;
+        return 0;
+    }
+
+    // Bot audio read while no user audio was sent (e.g. before the user
+    // started talking or while muted) is too old to be echoed now.
+    size_t max_reference = output_frames + _max_reference_backlog;
+    size_t num_reference = _reference.available();
+    if (num_reference > max_reference) {
+        _reference.skip(num_reference - max_reference);
+    }
+
+    // Pending frames go first, then as many new frames as fill whole blocks.
+    // The rest are kept for the next call.
+    size_t consumed = output_frames - _pending_frames;
+
+    std::memcpy(output, _pending.data(), _pending_frames * frame_size);
+    std::memcpy(
+            output + _pending_frames * _num_channels,
+            frames,
+            consumed * frame_size
+    );
+
+    _pending_frames = num_frames - consumed;
+    std::memcpy(
+            _pending.data(),
+            frames + consumed * _num_channels,
+            _pending_frames * frame_size
+    );
+
+    for (size_t i = 0; i < output_frames; i += _block_frames) {
+        process_block(output + i * _num_channels);
+    }
+
+    return output_frames;
+}
+
+void DailyAudioProcessor::add_reference(
+        const int16_t* frames,
+        size_t num_frames,
+        uint32_t sample_rate,
+        uint32_t num_channels
+) {
+    if (sample_rate != _sample_rate) {
+        return;
+    }
+
+    if (num_channels == 1) {
+        _reference.write(frames, num_frames);
+        return;
+    }
+
+    if (num_channels != 2) {
+        return;
+    }
+
+    while (num_frames > 0) {
+        size_t count = std::min(num_frames, _reference_mono.size());
+        audio_stereo_to_mono(frames, _reference_mono.data(), count);
+        _reference.write(_reference_mono.data(), count);
+        frames += count * 2;
+        num_frames -= count;
+    }
+}
+
+// Private
+
+DailyAudioProcessor::Slot*
+DailyAudioProcessor::find_slot(const std::string& name) const {
+    for (const auto& slot : _slots) {
+        if (name == slot->stage->name()) {
+            return slot.get();
+        }
+    }
+    return nullptr;
+}
+
+void DailyAudioProcessor::process_block(int16_t* frames) {
+    // Without enough reference (e.g. the bot audio is not being read) we
+    // assume the bot is silent.
+    int32_t num_reference =
+            _reference.read(_reference_block.data(), _block_frames);
+    std::fill(
+            _reference_block.begin() + std::max(num_reference, 0),
+            _reference_block.end(),
+            0
+    );
+
+    for (auto& slot : _slots) {
+        if (!slot->enabled) {
+            continue;
+        }
+
+        auto start = std::chrono::steady_clock::now();
+
+        slot->stage->process(
+                frames, _block_frames, _num_channels, _reference_block.data()
+        );
+
+        uint64_t elapsed_ns =
+                std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        std::chrono::steady_clock::now() - start
+                )
+                        .count();
+
+        slot->blocks++;
+        slot->total_ns += elapsed_ns;
+        if (elapsed_ns > slot->max_ns) {
+            slot->max_ns = elapsed_ns;
+        }
+    }
+}
@@ -0,0 +1,384 @@
+//
+// Copyright (c) 2024, Daily
+//
+
+#include "daily_audio_recorder.h"
+
+#include "daily_audio.h"
+
+#include <algorithm>
+#include <chrono>
+
+using namespace rtvi;
+
+// Audio is encoded and written in batches every 100ms. The ring buffers hold
+// 2 seconds, so we can survive slow disks without blocking the audio paths.
+static const uint32_t RECORD_INTERVAL_MS = 100;
+static const uint32_t RING_SECONDS = 2;
+
+// 256-byte IMA ADPCM blocks: a 4-byte header (with the first sample) followed
+// by 504 4-bit samples.
+static const size_t ADPCM_BLOCK_SIZE = 256;
+static const size_t ADPCM_BLOCK_SAMPLES = (ADPCM_BLOCK_SIZE - 4) * 2 + 1;
+
+static const size_t WAV_HEADER_SIZE = 60;
+
+static const int32_t ADPCM_INDEX_TABLE[16] = {
+        -1, -1, -1, -1, 2, 4, 6, 8, -1, -1, -1, -1, 2, 4, 6, 8
+};
+
+static const int32_t ADPCM_STEP_TABLE[89] = {
+        7,     8,     9,     10,    11,    12,    13,    14,    16,    17,
+        19,    21,    23,    25,    28,    31,    34,    37,    41,    45,
+        50,    55,    60,    66,    73,    80,    88,    97,    107,   118,
+        130,   143,   157,   173,   190,   209,   230,   253,   279,   307,
+        337,   371,   408,   449,   494,   544,   598,   658,   724,   796,
+        876,   963,   1060,  1166,  1282,  1411,  1552,  1707,  1878,  2066,
+        2272,  2499,  2749,  3024,  3327,  3660,  4026,  4428,  4871,  5358,
+        5894,  6484,  7132,  7845,  8630,  9493,  10442, 11487, 12635, 13899,
+        15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767
+};
+
+static uint8_t
+adpcm_encode(int16_t sample, int32_t& predictor, int32_t& index) {
+    int32_t step = ADPCM_STEP_TABLE[index];
+    int32_t diff = sample - predictor;
+
+    uint8_t nibble = 0;
+    if (diff < 0) {
+        nibble = 8;
+        diff = -diff;
+    }
+
+    int32_t delta = step >> 3;
+    if (diff >= step) {
+        nibble |= 4;
+        diff -= step;
+        delta += step;
+    }
+    step >>= 1;
+    if (diff >= step) {
+        nibble |= 2;
+        diff -= step;
+        delta += step;
+    }
+    step >>= 1;
+    if (diff >= step) {
+        nibble |= 1;
+        delta += step;
+    }
+
+    predictor += (nibble & 8) ? -delta : delta;
+    predictor = std::clamp(predictor, -32768, 32767);
+
+    index = std::clamp(index + ADPCM_INDEX_TABLE[nibble], 0, 88);
+
+    return nibble;
+}
+
+// Averages the channels of each frame.
+static void downmix(
+        const int16_t* src,
+        int16_t* dst,
+        size_t num_frames,
+        uint32_t num_channels
+) {
+    for (size_t i = 0; i < num_frames; ++i) {
+        int32_t sum = 0;
+        for (uint32_t c = 0; c < num_channels; ++c) {
+            sum += *src++;
+        }
+        dst[i] = static_cast<int16_t>(sum / int32_t(num_channels));
+    }
+}
+
+static uint8_t* put_u16(uint8_t* dst, uint16_t value) {
+    dst[0] = value & 0xff;
+    dst[1] = value >> 8;
+    return dst + 2;
+}
+
+static uint8_t* put_u32(uint8_t* dst, uint32_t value) {
+    dst = put_u16(dst, value & 0xffff);
+    return put_u16(dst, value >> 16);
+}
+
+static uint8_t* put_tag(uint8_t* dst, const char* tag) {
+    std::copy(tag, tag + 4, dst);
+    return dst + 4;
+}
+
+static void write_wav_header(
+        std::FILE* file,
+        uint32_t sample_rate,
+        uint32_t num_samples,
+        uint32_t data_size
+) {
+    uint8_t header[WAV_HEADER_SIZE];
+    uint8_t* p = header;
+
+    p = put_tag(p, "RIFF");
+    p = put_u32(p, WAV_HEADER_SIZE - 8 + data_size);
+    p = put_tag(p, "WAVE");
+
+    p = put_tag(p, "fmt ");
+    p = put_u32(p, 20);
+    p = put_u16(p, 0x0011);  // IMA ADPCM
+    p = put_u16(p, 1);
+    p = put_u32(p, sample_rate);
+    p = put_u32(p, sample_rate * ADPCM_BLOCK_SIZE / ADPCM_BLOCK_SAMPLES);
+    p = put_u16(p, ADPCM_BLOCK_SIZE);
+    p = put_u16(p, 4);
+    p = put_u16(p, 2);
+    p = put_u16(p, ADPCM_BLOCK_SAMPLES);
+
+    p = put_tag(p, "fact");
+    p = put_u32(p, 4);
+    p = put_u32(p, num_samples);
+
+    p = put_tag(p, "data");
+    p = put_u32(p, data_size);
+
+    std::fseek(file, 0, SEEK_SET);
+    std::fwrite(header, 1, WAV_HEADER_SIZE, file);
+}
+
+DailyAudioRecorder::DailyAudioRecorder(
+        const Track& user,
+        const Track& bot,
+        const DailyThreadConfig& thread_config
+)
+    : _user(user), _bot(bot), _thread_config(thread_config), _running(false) {
+    uint32_t max_samples =
+            std::max(user.sample_rate * user.num_channels,
+                     bot.sample_rate * bot.num_channels) *
+            RECORD_INTERVAL_MS / 1000;
+    _frames.resize(max_samples);
+    _mono.resize(max_samples);
+}
+
+DailyAudioRecorder::~DailyAudioRecorder() {
+    stop();
+}
+
+bool DailyAudioRecorder::start() {
+    if (_running) {
+        return true;
+    }
+
+    if (!_user.open()) {
+        return false;
+    }
+    if (!_bot.open()) {
+        _user.close();
+        return false;
+    }
+
+    // Discard audio captured while we were not recording.
+    for (TrackWriter* writer : {&_user, &_bot}) {
+        if (!writer->used()) {
+            continue;
+        }
+        size_t max_frames = _frames.size() / writer->track.num_channels;
+        while (writer->ring.read(_frames.data(), max_frames) > 0) {
+        }
+    }
+
+    _running = true;
+    _thread = std::thread(&DailyAudioRecorder::record_thread, this);
+
+    return true;
+}
+
+void DailyAudioRecorder::stop() {
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (!_running) {
+            return;
+        }
+        _running = false;
+    }
+    _cv.notify_one();
+
+    _thread.join();
+
+    _user.close();
+    _bot.close();
+}
+
+void DailyAudioRecorder::record_user_audio(
+        const int16_t* frames,
+        size_t num_frames
+) {
+    if (_user.used()) {
+        _user.ring.write(frames, num_frames);
+    }
+}
+
+void DailyAudioRecorder::record_bot_audio(
+        const int16_t* frames,
+        size_t num_frames
+) {
+    if (_bot.used()) {
+        _bot.ring.write(frames, num_frames);
+    }
+}
+
+DailyRecordingStats DailyAudioRecorder::stats() const {
+    return DailyRecordingStats {
+            .frames_recorded = _user.num_samples + _bot.num_samples,
+            .dropped_frames =
+                    _user.ring.dropped_frames() + _bot.ring.dropped_frames(),
+            .bytes_written = _user.bytes_written + _bot.bytes_written
+    };
+}
+
+// Private
+
+void DailyAudioRecorder::drain(TrackWriter& writer) {
+    if (!writer.file) {
+        return;
+    }
+
+    uint32_t num_channels = writer.track.num_channels;
+    size_t max_frames = _frames.size() / num_channels;
+
+    int32_t num_frames;
+    while ((num_frames = writer.ring.read(_frames.data(), max_frames)) > 0) {
+        if (num_channels == 1) {
+            writer.write(_frames.data(), num_frames);
+            continue;
+        }
+
+        if (num_channels == 2) {
+            audio_stereo_to_mono(_frames.data(), _mono.data(), num_frames);
+        } else {
+            downmix(_frames.data(), _mono.data(), num_frames, num_channels);
+        }
+        writer.write(_mono.data(), num_frames);
+    }
+}
+
+void DailyAudioRecorder::record_thread() {
+    daily_configure_thread("daily-recorder", _thread_config);
+
+    std::unique_lock<std::mutex> lock(_mutex);
+
+    // Record whatever is left after being stopped.
+    bool running = true;
+    while (running) {
+        _cv.wait_for(
+                lock,
+                std::chrono::milliseconds(RECORD_INTERVAL_MS),
+                [this] { return !_running; }
+        );
+        running = _running;
+
+        lock.unlock();
+        drain(_user);
+        drain(_bot);
+        lock.lock();
+    }
+}
+
+DailyAudioRecorder::TrackWriter::TrackWriter(const Track& track)
+    : track(track),
+      ring(size_t(track.sample_rate) * RING_SECONDS, track.num_channels),
+      file(nullptr),
+      block(ADPCM_BLOCK_SIZE),
+      step_index(0),
+      num_samples(0),
+      bytes_written(0) {
+    pending.reserve(ADPCM_BLOCK_SAMPLES);
+
+    // There is nothing to record without channels.
+    if (track.num_channels == 0) {
+        this->track.path.clear();
+    }
+}
+
+bool DailyAudioRecorder::TrackWriter::open() {
+    if (!used()) {
+        return true;
+    }
+
+    std::FILE* f = std::fopen(track.path.c_str(), "wb");
+    if (!f) {
+        return false;
+    }
+
+    // Batch disk writes.
+    std::setvbuf(f, nullptr, _IOFBF, 64 * 1024);
+
+    pending.clear();
+    step_index = 0;
+    num_samples = 0;
+    bytes_written = WAV_HEADER_SIZE;
+
+    // Sizes are filled in when the file is closed.
+    write_wav_header(f, track.sample_rate, 0, 0);
+
+    file = f;
+
+    return true;
+}
+
+void DailyAudioRecorder::TrackWriter::write(
+        const int16_t* samples,
+        size_t count
+) {
+    while (count > 0) {
+        size_t n = std::min(count, ADPCM_BLOCK_SAMPLES - pending.size());
+        pending.insert(pending.end(), samples, samples + n);
+        samples += n;
+        count -= n;
+
+        if (pending.size() == ADPCM_BLOCK_SAMPLES) {
+            encode_block(ADPCM_BLOCK_SAMPLES);
+        }
+    }
+}
+
+void DailyAudioRecorder::TrackWriter::close() {
+    if (!file) {
+        return;
+    }
+
+    // The last block is padded with silence, the real number of samples is
+    // in the header.
+    if (!pending.empty()) {
+        size_t count = pending.size();
+        pending.resize(ADPCM_BLOCK_SAMPLES, 0);
+        encode_block(count);
+    }
+
+    write_wav_header(
+            file,
+            track.sample_rate,
+            num_samples,
+            bytes_written - WAV_HEADER_SIZE
+    );
+
+    std::fclose(file);
+    file = nullptr;
+}
+
+void DailyAudioRecorder::TrackWriter::encode_block(size_t count) {
+    int32_t predictor = pending[0];
+
+    uint8_t* p = put_u16(block.data(), static_cast<uint16_t>(predictor));
+    *p++ = static_cast<uint8_t>(step_index);
+    *p++ = 0;
+
+    for (size_t i = 1; i < ADPCM_BLOCK_SAMPLES; i += 2) {
+        uint8_t low = adpcm_encode(pending[i], predictor, step_index);
+        uint8_t high = adpcm_encode(pending[i + 1], predictor, step_index);
+        *p++ = low | (high << 4);
+    }
+
+    std::fwrite(block.data(), 1, block.size(), file);
+
+    pending.clear();
+    num_samples += count;
+    bytes_written += block.size();
+}
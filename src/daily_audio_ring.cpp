@@ -0,0 +1,101 @@
+//
+// Copyright (c) 2024, Daily
+//
+
+#include "daily_audio_ring.h"
+
+#include <algorithm>
+#include <cstring>
+
+using namespace rtvi;
+
+DailyAudioRing::DailyAudioRing(size_t capacity_frames, uint32_t num_channels)
+    : _num_channels(num_channels),
+      _capacity(capacity_frames * num_channels),
+      _buffer(new int16_t[_capacity]),
+      _write_pos(0),
+      _read_pos(0),
+      _dropped_frames(0) {}
+
+int32_t DailyAudioRing::read(int16_t* frames, size_t num_frames) {
+    if (_num_channels == 0) {
+        return 0;
+    }
+
+    uint64_t read_pos = _read_pos.load(std::memory_order_relaxed);
+    uint64_t write_pos = _write_pos.load(std::memory_order_acquire);
+
+    size_t available = (write_pos - read_pos) / _num_channels;
+    size_t count = std::min(available, num_frames) * _num_channels;
+    if (count == 0) {
+        return 0;
+    }
+
+    // Copy in (at most) two segments if we wrap around.
+    size_t offset = read_pos % _capacity;
+    size_t first = std::min(count, _capacity - offset);
+    std::memcpy(frames, _buffer.get() + offset, first * sizeof(int16_t));
+    std::memcpy(
+            frames + first, _buffer.get(), (count - first) * sizeof(int16_t)
+    );
+
+    _read_pos.store(read_pos + count, std::memory_order_release);
+
+    return static_cast<int32_t>(count / _num_channels);
+}
+
+size_t DailyAudioRing::write(const int16_t* frames, size_t num_frames) {
+    if (_num_channels == 0) {
+        return 0;
+    }
+
+    uint64_t write_pos = _write_pos.load(std::memory_order_relaxed);
+    uint64_t read_pos = _read_pos.load(std::memory_order_acquire);
+
+    size_t space = (_capacity - (write_pos - read_pos)) / _num_channels;
+    size_t written_frames = std::min(space, num_frames);
+    size_t count = written_frames * _num_channels;
+
+    _dropped_frames += num_frames - written_frames;
+
+    if (count == 0) {
+        return 0;
+    }
+
+    size_t offset = write_pos % _capacity;
+    size_t first = std::min(count, _capacity - offset);
+    std::memcpy(_buffer.get() + offset, frames, first * sizeof(int16_t));
+    std::memcpy(
+            _buffer.get(), frames + first, (count - first) * sizeof(int16_t)
+    );
+
+    _write_pos.store(write_pos + count, std::memory_order_release);
+
+    return written_frames;
+}
+
+size_t DailyAudioRing::available() const {
+    if (_num_channels == 0) {
+        return 0;
+    }
+
+    uint64_t read_pos = _read_pos.load(std::memory_order_relaxed);
+    uint64_t write_pos = _write_pos.load(std::memory_order_acquire);
+    return (write_pos - read_pos) / _num_channels;
+}
+
+size_t DailyAudioRing::skip(size_t num_frames) {
+    if (_num_channels == 0) {
+        return 0;
+    }
+
+    uint64_t read_pos = _read_pos.load(std::memory_order_relaxed);
+    uint64_t write_pos = _write_pos.load(std::memory_order_acquire);
+
+    size_t count = std::min((write_pos - read_pos) / _num_channels, num_frames);
+    _read_pos.store(
+            read_pos + count * _num_channels, std::memory_order_release
+    );
+
+    return count;
+}
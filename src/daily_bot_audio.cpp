@@ -0,0 +1,268 @@
+//
+// Copyright (c) 2024, Daily
+//
+
+#include "daily_bot_audio.h"
+
+#include "daily_audio.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+using namespace rtvi;
+
+static const size_t LOWPASS_TAPS = 63;
+
+static const double PI = 3.14159265358979323846;
+
+// Blackman-windowed sinc low-pass that stops (by ~74 dB) above the Nyquist
+// frequency of `output_rate`, in cycles per input sample.
+static std::vector<float>
+design_lowpass(uint32_t input_rate, uint32_t output_rate) {
+    double nyquist = 0.5 * output_rate / input_rate;
+    double transition = 5.5 / LOWPASS_TAPS;
+    double cutoff = std::max(nyquist - transition / 2, nyquist / 2);
+
+    std::vector<float> taps(LOWPASS_TAPS);
+    double sum = 0;
+    for (size_t n = 0; n < LOWPASS_TAPS; ++n) {
+        double m = static_cast<double>(n) - (LOWPASS_TAPS - 1) / 2.0;
+        double sinc = m == 0 ? 2 * cutoff
+                             : std::sin(2 * PI * cutoff * m) / (PI * m);
+        double phase = 2 * PI * n / (LOWPASS_TAPS - 1);
+        double window =
+                0.42 - 0.5 * std::cos(phase) + 0.08 * std::cos(2 * phase);
+        taps[n] = static_cast<float>(sinc * window);
+        sum += taps[n];
+    }
+
+    // Unity gain for DC.
+    for (float& tap : taps) {
+        tap = static_cast<float>(tap / sum);
+    }
+    return taps;
+}
+
+DailyBotAudioStream::DailyBotAudioStream(
+        uint32_t sample_rate,
+        uint32_t num_channels,
+        size_t capacity_frames
+)
+    : _sample_rate(sample_rate),
+      _num_channels(num_channels),
+      _open(true),
+      _buffer(capacity_frames * num_channels),
+      _capacity(capacity_frames),
+      _read_frame(0),
+      _num_buffered(0),
+      _dropped_frames(0),
+      _input_sample_rate(0),
+      _last_frame(num_channels, 0),
+      _position(0) {}
+
+int32_t DailyBotAudioStream::read(int16_t* frames, size_t num_frames) {
+    auto duration = std::chrono::microseconds(
+            num_frames * 1000000 / std::max<uint32_t>(_sample_rate, 1)
+    );
+
+    std::unique_lock<std::mutex> lock(_mutex);
+    _cv.wait_for(lock, duration, [this, num_frames] {
+        return !_open || _num_buffered >= num_frames;
+    });
+
+    if (!_open) {
+        return 0;
+    }
+
+    size_t count = std::min(_num_buffered, num_frames);
+
+    // Copy in (at most) two segments if we wrap around.
+    size_t first = std::min(count, _capacity - _read_frame);
+    std::memcpy(
+            frames,
+            _buffer.data() + _read_frame * _num_channels,
+            first * _num_channels * sizeof(int16_t)
+    );
+    std::memcpy(
+            frames + first * _num_channels,
+            _buffer.data(),
+            (count - first) * _num_channels * sizeof(int16_t)
+    );
+
+    _read_frame = (_read_frame + count) % _capacity;
+    _num_buffered -= count;
+
+    std::memset(
+            frames + count * _num_channels,
+            0,
+            (num_frames - count) * _num_channels * sizeof(int16_t)
+    );
+
+    return static_cast<int32_t>(num_frames);
+}
+
+void DailyBotAudioStream::write(
+        const int16_t* frames,
+        size_t num_frames,
+        uint32_t sample_rate,
+        uint32_t num_channels
+) {
+    if (sample_rate == 0 || num_channels == 0 || num_channels > 2) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+
+        if (!_open) {
+            return;
+        }
+
+        // Convert channels first, so we resample as little as possible.
+        const int16_t* input = frames;
+        if (num_channels != _num_channels) {
+            _converted.resize(num_frames * _num_channels);
+            if (num_channels == 2) {
+                audio_stereo_to_mono(frames, _converted.data(), num_frames);
+            } else {
+                audio_mono_to_stereo(frames, _converted.data(), num_frames);
+            }
+            input = _converted.data();
+        }
+
+        if (sample_rate == _sample_rate) {
+            for (size_t i = 0; i < num_frames; ++i) {
+                push_frame(input + i * _num_channels);
+            }
+        } else {
+            if (sample_rate != _input_sample_rate) {
+                _input_sample_rate = sample_rate;
+                std::fill(_last_frame.begin(), _last_frame.end(), 0);
+                _position = 0;
+
+                _lowpass.clear();
+                if (sample_rate > _sample_rate) {
+                    _lowpass = design_lowpass(sample_rate, _sample_rate);
+                    _lowpass_input.assign(
+                            (_lowpass.size() - 1) * _num_channels, 0.0f
+                    );
+                }
+            }
+
+            if (!_lowpass.empty()) {
+                input = lowpass(input, num_frames);
+            }
+
+            // Interpolate between the last frame (at -1) and the input
+            // frames. Good enough for speech, which is what bots send.
+            double step = static_cast<double>(sample_rate) / _sample_rate;
+            double end = static_cast<double>(num_frames) - 1;
+            int16_t frame[2];
+            for (; _position < end; _position += step) {
+                double base = std::floor(_position);
+                double fraction = _position - base;
+                int64_t index = static_cast<int64_t>(base);
+                const int16_t* a = index < 0 ? _last_frame.data()
+                                             : input + index * _num_channels;
+                const int16_t* b = input + (index + 1) * _num_channels;
+                for (uint32_t c = 0; c < _num_channels; ++c) {
+                    frame[c] = static_cast<int16_t>(
+                            a[c] + (b[c] - a[c]) * fraction
+                    );
+                }
+                push_frame(frame);
+            }
+            _position -= static_cast<double>(num_frames);
+
+            if (num_frames > 0) {
+                std::memcpy(
+                        _last_frame.data(),
+                        input + (num_frames - 1) * _num_channels,
+                        _num_channels * sizeof(int16_t)
+                );
+            }
+        }
+    }
+    _cv.notify_one();
+}
+
+void DailyBotAudioStream::open() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _open = true;
+    _read_frame = 0;
+    _num_buffered = 0;
+    _input_sample_rate = 0;
+}
+
+void DailyBotAudioStream::close() {
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _open = false;
+    }
+    _cv.notify_all();
+}
+
+uint64_t DailyBotAudioStream::dropped_frames() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _dropped_frames;
+}
+
+size_t DailyBotAudioStream::memory_bytes() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return sizeof(*this) +
+           (_buffer.capacity() + _last_frame.capacity() +
+            _converted.capacity() + _filtered.capacity()) *
+                   sizeof(int16_t) +
+           (_lowpass.capacity() + _lowpass_input.capacity()) * sizeof(float);
+}
+
+// Private
+
+const int16_t*
+DailyBotAudioStream::lowpass(const int16_t* frames, size_t num_frames) {
+    size_t num_samples = num_frames * _num_channels;
+    size_t history = (_lowpass.size() - 1) * _num_channels;
+
+    _lowpass_input.resize(history + num_samples);
+    std::copy(frames, frames + num_samples, _lowpass_input.begin() + history);
+
+    _filtered.resize(num_samples);
+    for (size_t i = 0; i < num_samples; ++i) {
+        // The oldest sample of the same channel that is still needed.
+        const float* window = _lowpass_input.data() + i;
+        float sum = 0;
+        for (size_t k = 0; k < _lowpass.size(); ++k) {
+            sum += _lowpass[k] * window[k * _num_channels];
+        }
+        _filtered[i] = static_cast<int16_t>(
+                std::clamp(std::lrint(sum), -32768L, 32767L)
+        );
+    }
+
+    std::copy(
+            _lowpass_input.end() - history,
+            _lowpass_input.end(),
+            _lowpass_input.begin()
+    );
+    _lowpass_input.resize(history);
+
+    return _filtered.data();
+}
+
+void DailyBotAudioStream::push_frame(const int16_t* frame) {
+    // Drop the oldest frame, the reader is late anyway.
+    if (_num_buffered == _capacity) {
+        _read_frame = (_read_frame + 1) % _capacity;
+        _num_buffered--;
+        _dropped_frames++;
+    }
+
+    size_t write_frame = (_read_frame + _num_buffered) % _capacity;
+    std::memcpy(
+            _buffer.data() + write_frame * _num_channels,
+            frame,
+            _num_channels * sizeof(int16_t)
+    );
+    _num_buffered++;
+}
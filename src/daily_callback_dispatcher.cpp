@@ -0,0 +1,166 @@
+//
+// Copyright (c) 2024, Daily
+//
+
+#include "daily_callback_dispatcher.h"
+
+using namespace rtvi;
+
+DailyCallbackDispatcher::DailyCallbackDispatcher(
+        Executor executor,
+        const DailyThreadConfig& thread_config
+)
+    : _executor(std::move(executor)),
+      _thread_config(thread_config),
+      _running(false),
+      _sleeping(false),
+      _posted(0),
+      _delivered(0),
+      _last_lag_us(0),
+      _max_lag_us(0),
+      _total_lag_us(0) {
+    Node* stub = new Node();
+    stub->next = nullptr;
+    _head = stub;
+    _tail = stub;
+}
+
+DailyCallbackDispatcher::~DailyCallbackDispatcher() {
+    stop();
+
+    // Callbacks posted after stopping are not delivered.
+    while (Node* node = pop()) {
+        delete node;
+    }
+
+    // Only the stub is left.
+    delete _tail;
+}
+
+void DailyCallbackDispatcher::start() {
+    if (_executor || _running) {
+        return;
+    }
+
+    _running = true;
+    _thread = std::thread(&DailyCallbackDispatcher::dispatch_thread, this);
+}
+
+void DailyCallbackDispatcher::stop() {
+    if (!_running) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _running = false;
+    }
+    _cv.notify_one();
+
+    _thread.join();
+}
+
+void DailyCallbackDispatcher::post(Callback callback) {
+    auto posted_at = std::chrono::steady_clock::now();
+
+    _posted++;
+
+    if (_executor) {
+        _executor([this, callback = std::move(callback), posted_at]() {
+            Node node;
+            node.posted_at = posted_at;
+            node.callback = std::move(callback);
+            deliver(&node);
+        });
+        return;
+    }
+
+    Node* node = new Node();
+    node->callback = std::move(callback);
+    node->posted_at = posted_at;
+    node->next.store(nullptr, std::memory_order_relaxed);
+
+    Node* prev = _head.exchange(node, std::memory_order_acq_rel);
+    prev->next.store(node);
+
+    // Only wake up the dispatcher if it's (about to be) waiting. This and the
+    // store above need to be sequentially consistent so they are not
+    // reordered.
+    if (_sleeping.load()) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _cv.notify_one();
+    }
+}
+
+DailyCallbackStats DailyCallbackDispatcher::stats() const {
+    uint64_t delivered = _delivered;
+    return DailyCallbackStats {
+            .delivered = delivered,
+            .pending = _posted - delivered,
+            .last_lag_us = _last_lag_us,
+            .max_lag_us = _max_lag_us,
+            .total_lag_us = _total_lag_us
+    };
+}
+
+// Private
+
+DailyCallbackDispatcher::Node* DailyCallbackDispatcher::pop() {
+    Node* next = _tail->next.load(std::memory_order_acquire);
+    if (next == nullptr) {
+        return nullptr;
+    }
+
+    // The next node becomes the new stub, so we hand out its callback in the
+    // old one.
+    Node* node = _tail;
+    node->callback = std::move(next->callback);
+    node->posted_at = next->posted_at;
+    _tail = next;
+
+    return node;
+}
+
+void DailyCallbackDispatcher::deliver(Node* node) {
+    auto lag = std::chrono::steady_clock::now() - node->posted_at;
+    uint64_t lag_us =
+            std::chrono::duration_cast<std::chrono::microseconds>(lag).count();
+
+    _last_lag_us = lag_us;
+    _total_lag_us += lag_us;
+    uint64_t max_lag_us = _max_lag_us;
+    while (lag_us > max_lag_us &&
+           !_max_lag_us.compare_exchange_weak(max_lag_us, lag_us)) {
+    }
+
+    node->callback();
+
+    _delivered++;
+}
+
+void DailyCallbackDispatcher::dispatch_thread() {
+    daily_configure_thread("daily-callbacks", _thread_config);
+
+    for (;;) {
+        Node* node = pop();
+        if (node) {
+            deliver(node);
+            delete node;
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(_mutex);
+
+        // Producers check this flag after pushing, so either we see their node
+        // or they see us sleeping and notify.
+        _sleeping = true;
+        _cv.wait(lock, [this] {
+            return !_running || _tail->next.load() != nullptr;
+        });
+        _sleeping = false;
+
+        if (!_running && _tail->next.load() == nullptr) {
+            break;
+        }
+    }
+}
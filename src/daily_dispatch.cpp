@@ -0,0 +1,96 @@
+//
+// Copyright (c) 2024, Daily
+//
+
+#include "daily_dispatch.h"
+
+using namespace rtvi;
+
+static bool is_json_space(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+// Scans the string starting at the opening quote `json[*pos]`. On success
+// `*pos` points past the closing quote.
+static bool scan_string(
+        std::string_view json,
+        size_t* pos,
+        std::string_view* value,
+        bool* escaped
+) {
+    size_t start = *pos + 1;
+    size_t i = start;
+
+    *escaped = false;
+    while (i < json.size() && json[i] != '"') {
+        if (json[i] == '\\') {
+            *escaped = true;
+            i += 2;
+        } else {
+            i++;
+        }
+    }
+
+    if (i >= json.size()) {
+        return false;
+    }
+
+    *value = json.substr(start, i - start);
+    *pos = i + 1;
+
+    return true;
+}
+
+std::optional<std::string_view>
+rtvi::daily_json_peek_string(std::string_view json, std::string_view key) {
+    size_t depth = 0;
+    size_t i = 0;
+
+    while (i < json.size()) {
+        char c = json[i];
+
+        if (c == '{' || c == '[') {
+            depth++;
+            i++;
+        } else if (c == '}' || c == ']') {
+            if (depth-- <= 1) {
+                return std::nullopt;
+            }
+            i++;
+        } else if (c == '"') {
+            std::string_view token;
+            bool escaped;
+            if (!scan_string(json, &i, &token, &escaped)) {
+                return std::nullopt;
+            }
+
+            // Only keys of the top-level object are followed by a colon.
+            if (depth != 1 || escaped || token != key) {
+                continue;
+            }
+
+            while (i < json.size() && is_json_space(json[i])) {
+                i++;
+            }
+            if (i >= json.size() || json[i] != ':') {
+                continue;
+            }
+            i++;
+            while (i < json.size() && is_json_space(json[i])) {
+                i++;
+            }
+
+            std::string_view value;
+            if (i >= json.size() || json[i] != '"' ||
+                !scan_string(json, &i, &value, &escaped) || escaped) {
+                return std::nullopt;
+            }
+
+            return value;
+        } else {
+            i++;
+        }
+    }
+
+    return std::nullopt;
+}
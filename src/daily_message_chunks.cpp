@@ -0,0 +1,249 @@
+//
+// Copyright (c) 2024, Daily
+//
+
+#include "daily_message_chunks.h"
+
+#include <nlohmann/json.hpp>
+
+#include <algorithm>
+
+using namespace rtvi;
+
+// Chunk counts above this are considered malformed, so a bogus `total` can't
+// make us allocate an arbitrary amount of memory.
+static const uint32_t MAX_CHUNKS = 65536;
+
+// Returns a non-negative integer field, or nothing if it's missing or not
+// one.
+static std::optional<uint64_t>
+chunk_field(const nlohmann::json& chunk, const char* name) {
+    auto it = chunk.find(name);
+    if (it == chunk.end() || !it->is_number_integer()) {
+        return std::nullopt;
+    }
+    if (it->is_number_unsigned()) {
+        return it->get<uint64_t>();
+    }
+    int64_t value = it->get<int64_t>();
+    if (value < 0) {
+        return std::nullopt;
+    }
+    return value;
+}
+
+static bool is_utf8_continuation(char c) {
+    return (static_cast<uint8_t>(c) & 0xC0) == 0x80;
+}
+
+// Size of a byte once escaped in a JSON string, as `json::dump()` does it.
+static size_t escaped_size(char c) {
+    switch (c) {
+    case '"':
+    case '\\':
+    case '\b':
+    case '\f':
+    case '\n':
+    case '\r':
+    case '\t':
+        return 2;
+    default:
+        return static_cast<uint8_t>(c) < 0x20 ? 6 : 1;
+    }
+}
+
+std::vector<std::string> rtvi::daily_split_message(
+        const std::string& message,
+        uint64_t id,
+        size_t chunk_size
+) {
+    std::vector<std::pair<size_t, size_t>> ranges;
+
+    // Quotes in the serialized message are escaped again in `data`, which
+    // can double its size, so chunks are measured by their escaped size.
+    size_t start = 0;
+    while (start < message.size()) {
+        size_t end = start;
+        size_t size = 0;
+        while (end < message.size()) {
+            // Don't cut a UTF-8 sequence in half, the chunk data would not
+            // be valid JSON. Continuation bytes are never escaped.
+            size_t next = end + 1;
+            while (next < message.size() &&
+                   is_utf8_continuation(message[next])) {
+                next++;
+            }
+            size_t char_size = escaped_size(message[end]) + next - end - 1;
+            // Always take at least one character.
+            if (size + char_size > chunk_size && end > start) {
+                break;
+            }
+            end = next;
+            size += char_size;
+        }
+
+        ranges.emplace_back(start, end - start);
+        start = end;
+    }
+
+    std::vector<std::string> chunks;
+    chunks.reserve(ranges.size());
+
+    nlohmann::json chunk = {
+            {"label", DAILY_MESSAGE_CHUNK_LABEL},
+            {"id", id},
+            {"seq", 0},
+            {"total", ranges.size()},
+            {"data", ""}
+    };
+
+    for (size_t i = 0; i < ranges.size(); i++) {
+        chunk["seq"] = i;
+        chunk["data"] = message.substr(ranges[i].first, ranges[i].second);
+        chunks.push_back(chunk.dump());
+    }
+
+    return chunks;
+}
+
+DailyMessageAssembler::DailyMessageAssembler(
+        size_t max_pending,
+        size_t max_bytes
+)
+    : _max_pending(max_pending), _max_bytes(max_bytes), _discarded(0) {}
+
+std::optional<std::string> DailyMessageAssembler::add_chunk(
+        const std::string& sender,
+        const nlohmann::json& chunk
+) {
+    std::optional<uint64_t> id = chunk_field(chunk, "id");
+    std::optional<uint64_t> seq = chunk_field(chunk, "seq");
+    std::optional<uint64_t> total = chunk_field(chunk, "total");
+    auto data = chunk.find("data");
+
+    if (!id || !seq || !total || data == chunk.end() || !data->is_string()) {
+        return std::nullopt;
+    }
+
+    // Out of range values would be truncated.
+    if (*seq >= MAX_CHUNKS || *total > MAX_CHUNKS) {
+        return std::nullopt;
+    }
+
+    return add_chunk(
+            sender,
+            *id,
+            static_cast<uint32_t>(*seq),
+            static_cast<uint32_t>(*total),
+            data->get<std::string>()
+    );
+}
+
+std::optional<std::string> DailyMessageAssembler::add_chunk(
+        const std::string& sender,
+        uint64_t id,
+        uint32_t seq,
+        uint32_t total,
+        std::string data
+) {
+    if (total == 0 || total > MAX_CHUNKS || seq >= total || data.empty()) {
+        return std::nullopt;
+    }
+
+    // Single chunk messages don't need to be buffered.
+    if (total == 1) {
+        return data;
+    }
+
+    auto it = _pending.begin();
+    for (; it != _pending.end(); ++it) {
+        if (it->id == id && it->sender == sender) {
+            break;
+        }
+    }
+
+    if (it == _pending.end()) {
+        if (_pending.size() >= _max_pending) {
+            discard(_pending.begin());
+        }
+
+        // The chunk list is allocated upfront, so it's budgeted first. This
+        // is what keeps a bogus `total` from using lots of memory.
+        size_t bytes = sizeof(Pending) + total * sizeof(std::string);
+        if (!make_room(bytes, nullptr)) {
+            _discarded++;
+            return std::nullopt;
+        }
+
+        it = _pending.insert(
+                _pending.end(),
+                Pending {
+                        .sender = sender,
+                        .id = id,
+                        .chunks = std::vector<std::string>(total),
+                        .received = 0,
+                        .size = 0
+                }
+        );
+        _memory.add(pending_bytes(*it));
+    }
+
+    Pending& pending = *it;
+
+    // Chunks can be received again if they were resent while reconnecting.
+    if (pending.chunks.size() != total || !pending.chunks[seq].empty()) {
+        return std::nullopt;
+    }
+
+    // The message doesn't fit even on its own.
+    if (!make_room(data.size(), &pending)) {
+        discard(it);
+        return std::nullopt;
+    }
+
+    pending.size += data.size();
+    _memory.add(data.size());
+    pending.chunks[seq] = std::move(data);
+
+    if (++pending.received < total) {
+        return std::nullopt;
+    }
+
+    std::string message;
+    message.reserve(pending.size);
+    for (const std::string& chunk : pending.chunks) {
+        message.append(chunk);
+    }
+
+    _memory.remove(pending_bytes(pending));
+    _pending.erase(it);
+
+    return message;
+}
+
+void DailyMessageAssembler::clear() {
+    for (const Pending& pending : _pending) {
+        _memory.remove(pending_bytes(pending));
+    }
+    _pending.clear();
+}
+
+// Private
+
+bool DailyMessageAssembler::make_room(size_t bytes, const Pending* keep) {
+    auto it = _pending.begin();
+    while (_memory.bytes() + bytes > _max_bytes && it != _pending.end()) {
+        if (&*it == keep) {
+            ++it;
+        } else {
+            discard(it++);
+        }
+    }
+    return _memory.bytes() + bytes <= _max_bytes;
+}
+
+void DailyMessageAssembler::discard(std::list<Pending>::iterator it) {
+    _memory.remove(pending_bytes(*it));
+    _pending.erase(it);
+    _discarded++;
+}
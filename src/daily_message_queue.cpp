@@ -0,0 +1,146 @@
+//
+// Copyright (c) 2024, Daily
+//
+
+#include "daily_message_queue.h"
+
+#include <algorithm>
+
+using namespace rtvi;
+
+DailyMessageQueue::DailyMessageQueue(size_t max_bytes)
+    : _max_bytes(max_bytes), _lanes(), _stopped(false) {}
+
+bool DailyMessageQueue::push(
+        std::string message,
+        DailyMessagePriority priority
+) {
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+
+        if (_max_bytes > 0 &&
+            _memory.bytes() + entry_bytes(message) > _max_bytes) {
+            _lanes[lane_index(priority)].stats.dropped++;
+            return false;
+        }
+
+        push_locked(std::move(message), priority);
+    }
+    _cv.notify_one();
+
+    return true;
+}
+
+bool DailyMessageQueue::push(
+        std::vector<std::string> messages,
+        DailyMessagePriority priority
+) {
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+
+        if (_max_bytes > 0) {
+            size_t bytes = _memory.bytes();
+            for (const std::string& message : messages) {
+                bytes += entry_bytes(message);
+            }
+            if (bytes > _max_bytes) {
+                _lanes[lane_index(priority)].stats.dropped +=
+                        messages.size();
+                return false;
+            }
+        }
+
+        for (std::string& message : messages) {
+            push_locked(std::move(message), priority);
+        }
+    }
+    _cv.notify_all();
+
+    return true;
+}
+
+std::optional<std::string> DailyMessageQueue::blocking_pop() {
+    std::unique_lock<std::mutex> lock(_mutex);
+
+    for (;;) {
+        if (_stopped) {
+            return std::nullopt;
+        }
+
+        for (Lane& lane : _lanes) {
+            if (lane.entries.empty()) {
+                continue;
+            }
+
+            Entry entry = std::move(lane.entries.front());
+            lane.entries.pop_front();
+            _memory.remove(entry_bytes(entry.message));
+
+            auto wait = std::chrono::steady_clock::now() - entry.pushed_at;
+            uint64_t wait_us =
+                    std::chrono::duration_cast<std::chrono::microseconds>(wait)
+                            .count();
+
+            lane.stats.popped++;
+            lane.stats.pending--;
+            lane.stats.total_wait_us += wait_us;
+            lane.stats.max_wait_us = std::max(lane.stats.max_wait_us, wait_us);
+
+            return std::move(entry.message);
+        }
+
+        _cv.wait(lock);
+    }
+}
+
+void DailyMessageQueue::stop() {
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stopped = true;
+    }
+    _cv.notify_all();
+}
+
+void DailyMessageQueue::restart() {
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    for (Lane& lane : _lanes) {
+        for (const Entry& entry : lane.entries) {
+            _memory.remove(entry_bytes(entry.message));
+        }
+        lane.entries.clear();
+        lane.stats.pending = 0;
+    }
+
+    _stopped = false;
+}
+
+DailyMessageLaneStats DailyMessageQueue::stats(DailyMessagePriority priority) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _lanes[lane_index(priority)].stats;
+}
+
+// Private
+
+size_t DailyMessageQueue::lane_index(DailyMessagePriority priority) {
+    size_t index = static_cast<size_t>(priority);
+    if (index >= DAILY_MESSAGE_PRIORITIES) {
+        return static_cast<size_t>(DailyMessagePriority::Normal);
+    }
+    return index;
+}
+
+void DailyMessageQueue::push_locked(
+        std::string message,
+        DailyMessagePriority priority
+) {
+    _memory.add(entry_bytes(message));
+
+    Lane& lane = _lanes[lane_index(priority)];
+    lane.entries.push_back(
+            {.message = std::move(message),
+             .pushed_at = std::chrono::steady_clock::now()}
+    );
+    lane.stats.pushed++;
+    lane.stats.pending++;
+}
@@ -0,0 +1,115 @@
+//
+// Copyright (c) 2024, Daily
+//
+
+#include "daily_message_template.h"
+
+#include "rtvi.h"
+
+#include <algorithm>
+#include <cctype>
+#include <optional>
+#include <string_view>
+
+using namespace rtvi;
+
+// Returns the name of the placeholder if the JSON string token
+// `token` (including quotes) is one.
+static std::optional<std::string> placeholder_name(std::string_view token) {
+    if (token.size() < 6 || token.substr(0, 3) != "\"{{" ||
+        token.substr(token.size() - 3) != "}}\"") {
+        return std::nullopt;
+    }
+
+    std::string_view name = token.substr(3, token.size() - 6);
+    for (char c : name) {
+        if (!std::isalnum(static_cast<unsigned char>(c)) && c != '_') {
+            return std::nullopt;
+        }
+    }
+
+    return std::string(name);
+}
+
+DailyMessageTemplate::DailyMessageTemplate(const nlohmann::json& message)
+    : _serialized(message.dump()) {
+    size_t literal_start = 0;
+    size_t i = 0;
+
+    // Look for placeholder string tokens. Since placeholders don't need to be
+    // escaped, they are serialized verbatim.
+    while (i < _serialized.size()) {
+        if (_serialized[i] != '"') {
+            i++;
+            continue;
+        }
+
+        size_t token_start = i++;
+        while (i < _serialized.size() && _serialized[i] != '"') {
+            i += _serialized[i] == '\\' ? 2 : 1;
+        }
+        size_t token_end = ++i;
+
+        // Object keys are never placeholders.
+        if (token_end < _serialized.size() && _serialized[token_end] == ':') {
+            continue;
+        }
+
+        std::optional<std::string> name = placeholder_name(
+                std::string_view(_serialized)
+                        .substr(token_start, token_end - token_start)
+        );
+        if (!name) {
+            continue;
+        }
+
+        auto it = std::find(_placeholders.begin(), _placeholders.end(), *name);
+        if (it == _placeholders.end()) {
+            it = _placeholders.insert(it, *name);
+        }
+
+        _segments.push_back(
+                {.offset = literal_start,
+                 .length = token_start - literal_start,
+                 .placeholder =
+                         static_cast<int32_t>(it - _placeholders.begin())}
+        );
+        literal_start = token_end;
+    }
+
+    _segments.push_back(
+            {.offset = literal_start,
+             .length = _serialized.size() - literal_start,
+             .placeholder = -1}
+    );
+}
+
+std::string
+DailyMessageTemplate::render(const std::vector<std::string>& values) const {
+    if (values.size() != _placeholders.size()) {
+        throw RTVIException("invalid number of message template values");
+    }
+
+    size_t size = 0;
+    for (const Segment& segment : _segments) {
+        size += segment.length;
+        if (segment.placeholder >= 0) {
+            size += values[segment.placeholder].size();
+        }
+    }
+
+    std::string message;
+    message.reserve(size);
+    for (const Segment& segment : _segments) {
+        message.append(_serialized, segment.offset, segment.length);
+        if (segment.placeholder >= 0) {
+            message.append(values[segment.placeholder]);
+        }
+    }
+
+    return message;
+}
+
+std::string DailyMessageTemplate::quote(const std::string& value) {
+    return nlohmann::json(value).dump();
+}
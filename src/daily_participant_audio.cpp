@@ -0,0 +1,118 @@
+//
+// Copyright (c) 2024, Daily
+//
+
+#include "daily_participant_audio.h"
+
+#include <algorithm>
+
+using namespace rtvi;
+
+DailyParticipantAudioStream::DailyParticipantAudioStream(
+        const std::string& participant_id,
+        size_t capacity_samples
+)
+    : _participant_id(participant_id),
+      _capacity(capacity_samples),
+      _current(nullptr),
+      _reading(nullptr),
+      _dropped_frames(0),
+      _buffer_bytes(0) {}
+
+uint32_t DailyParticipantAudioStream::sample_rate() {
+    Buffer* buffer = reader_buffer();
+    return buffer ? buffer->sample_rate : 0;
+}
+
+uint32_t DailyParticipantAudioStream::num_channels() {
+    Buffer* buffer = reader_buffer();
+    return buffer ? buffer->ring.num_channels() : 0;
+}
+
+int32_t DailyParticipantAudioStream::read(int16_t* frames, size_t num_frames) {
+    Buffer* reading = _reading.load(std::memory_order_relaxed);
+
+    // The caller doesn't know about the new format yet.
+    Buffer* buffer = reader_buffer();
+    if (!buffer || buffer != reading) {
+        return 0;
+    }
+
+    return buffer->ring.read(frames, num_frames);
+}
+
+void DailyParticipantAudioStream::write(
+        const int16_t* frames,
+        size_t num_frames,
+        uint32_t sample_rate,
+        uint32_t num_channels
+) {
+    // Not audio we can do anything with (and we would divide by zero).
+    if (num_channels == 0) {
+        return;
+    }
+
+    Buffer* buffer = writer_buffer(sample_rate, num_channels);
+
+    size_t written = buffer->ring.write(frames, num_frames);
+
+    _dropped_frames += num_frames - written;
+}
+
+// Private
+
+DailyParticipantAudioStream::Buffer*
+DailyParticipantAudioStream::reader_buffer() {
+    Buffer* reading = _reading.load(std::memory_order_relaxed);
+    Buffer* current = _current.load();
+
+    // Once `_reading` is set, the writer won't free the buffer. It might have
+    // done it just before though, so check it is still the current one.
+    while (current != reading) {
+        _reading.store(current);
+        reading = current;
+        current = _current.load();
+    }
+
+    return reading;
+}
+
+DailyParticipantAudioStream::Buffer* DailyParticipantAudioStream::writer_buffer(
+        uint32_t sample_rate,
+        uint32_t num_channels
+) {
+    Buffer* current = _current.load(std::memory_order_relaxed);
+    if (current && current->sample_rate == sample_rate &&
+        current->ring.num_channels() == num_channels) {
+        return current;
+    }
+
+    // The format changed (which is rare), audio queued in the previous format
+    // is dropped with its buffer.
+    _buffers.push_back(
+            std::make_unique<Buffer>(_capacity, sample_rate, num_channels)
+    );
+    current = _buffers.back().get();
+    _current.store(current);
+
+    Buffer* reading = _reading.load();
+    _buffers.erase(
+            std::remove_if(
+                    _buffers.begin(),
+                    _buffers.end(),
+                    [&](const std::unique_ptr<Buffer>& buffer) {
+                        return buffer.get() != current &&
+                               buffer.get() != reading;
+                    }
+            ),
+            _buffers.end()
+    );
+
+    size_t buffer_bytes = 0;
+    for (const auto& buffer : _buffers) {
+        buffer_bytes += buffer->ring.memory_bytes();
+    }
+    _buffer_bytes = buffer_bytes;
+
+    return current;
+}
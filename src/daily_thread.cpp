@@ -0,0 +1,122 @@
+//
+// Copyright (c) 2024, Daily
+//
+
+#include "daily_thread.h"
+
+#include "daily_tracer.h"
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <sched.h>
+#include <sys/resource.h>
+#endif
+
+#if defined(__linux__)
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+using namespace rtvi;
+
+#if defined(_WIN32)
+
+static void set_thread_name(const std::string& name) {
+    std::wstring wide_name(name.begin(), name.end());
+    SetThreadDescription(GetCurrentThread(), wide_name.c_str());
+}
+
+static bool set_thread_cpus(const std::vector<uint32_t>& cpus) {
+    DWORD_PTR mask = 0;
+    for (uint32_t cpu : cpus) {
+        if (cpu >= sizeof(mask) * 8) {
+            return false;
+        }
+        mask |= DWORD_PTR(1) << cpu;
+    }
+    return SetThreadAffinityMask(GetCurrentThread(), mask) != 0;
+}
+
+static bool set_thread_priority(int32_t realtime_priority, int32_t nice) {
+    int priority = THREAD_PRIORITY_NORMAL;
+    if (realtime_priority > 0) {
+        priority = THREAD_PRIORITY_TIME_CRITICAL;
+    } else if (nice <= -10) {
+        priority = THREAD_PRIORITY_HIGHEST;
+    } else if (nice < 0) {
+        priority = THREAD_PRIORITY_ABOVE_NORMAL;
+    } else if (nice >= 10) {
+        priority = THREAD_PRIORITY_LOWEST;
+    } else if (nice > 0) {
+        priority = THREAD_PRIORITY_BELOW_NORMAL;
+    }
+    return SetThreadPriority(GetCurrentThread(), priority) != 0;
+}
+
+#else
+
+static void set_thread_name(const std::string& name) {
+#if defined(__APPLE__)
+    pthread_setname_np(name.c_str());
+#else
+    // Linux thread names can't be longer than 15 characters.
+    pthread_setname_np(pthread_self(), name.substr(0, 15).c_str());
+#endif
+}
+
+static bool set_thread_cpus(const std::vector<uint32_t>& cpus) {
+#if defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (uint32_t cpu : cpus) {
+        if (cpu >= CPU_SETSIZE) {
+            return false;
+        }
+        CPU_SET(cpu, &set);
+    }
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+    return false;
+#endif
+}
+
+static bool set_thread_priority(int32_t realtime_priority, int32_t nice) {
+    if (realtime_priority > 0) {
+        sched_param param = {};
+        param.sched_priority = realtime_priority;
+        return pthread_setschedparam(pthread_self(), SCHED_FIFO, &param) == 0;
+    }
+
+#if defined(__linux__)
+    // On Linux the nice value is per thread.
+    pid_t tid = static_cast<pid_t>(syscall(SYS_gettid));
+    return setpriority(PRIO_PROCESS, tid, nice) == 0;
+#else
+    return false;
+#endif
+}
+
+#endif
+
+bool rtvi::daily_configure_thread(
+        const std::string& name,
+        const DailyThreadConfig& config
+) {
+    bool applied = true;
+
+    set_thread_name(name);
+    DailyTracer::instance().set_thread_name(name);
+
+    if (!config.cpus.empty() && !set_thread_cpus(config.cpus)) {
+        applied = false;
+    }
+
+    if ((config.realtime_priority > 0 || config.nice != 0) &&
+        !set_thread_priority(config.realtime_priority, config.nice)) {
+        applied = false;
+    }
+
+    return applied;
+}
@@ -0,0 +1,271 @@
+//
+// Copyright (c) 2024, Daily
+//
+
+#include "daily_tracer.h"
+
+#include <nlohmann/json.hpp>
+
+#include <algorithm>
+#include <cstdio>
+#include <set>
+#include <utility>
+
+using namespace rtvi;
+
+static const size_t DEFAULT_EVENTS_PER_THREAD = 16384;
+
+struct DailyTracer::ThreadState {
+    uint32_t tid = 0;
+    ThreadBuffer* buffer = nullptr;
+
+    ~ThreadState() {
+        if (tid) {
+            DailyTracer::instance().thread_exited(*this);
+        }
+    }
+};
+
+DailyTracer& DailyTracer::instance() {
+    static DailyTracer tracer;
+    return tracer;
+}
+
+DailyTracer::DailyTracer()
+    : _start(std::chrono::steady_clock::now()),
+      _enabled(false),
+      _generation(0),
+      _events_per_thread(DEFAULT_EVENTS_PER_THREAD),
+      _session_counter(0),
+      _thread_counter(0) {}
+
+void DailyTracer::start(size_t events_per_thread) {
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+
+        // The events of exited threads are discarded anyway.
+        auto it = std::remove_if(
+                _buffers.begin(),
+                _buffers.end(),
+                [this](const std::unique_ptr<ThreadBuffer>& buffer) {
+                    if (!buffer->exited) {
+                        return false;
+                    }
+                    _thread_names.erase(buffer->tid);
+                    return true;
+                }
+        );
+        _buffers.erase(it, _buffers.end());
+    }
+
+    _events_per_thread = std::max<size_t>(events_per_thread, 1);
+    // Threads reset their buffer the next time they record.
+    _generation++;
+    _enabled = true;
+}
+
+void DailyTracer::stop() {
+    _enabled = false;
+}
+
+uint64_t DailyTracer::now() const {
+    auto elapsed = std::chrono::steady_clock::now() - _start;
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed)
+            .count();
+}
+
+void DailyTracer::record(
+        uint32_t session,
+        const char* name,
+        uint64_t start_ns,
+        uint64_t end_ns,
+        uint64_t arg
+) {
+    if (!enabled()) {
+        return;
+    }
+
+    ThreadState& state = thread_state();
+    if (!state.buffer) {
+        state.buffer = create_thread_buffer(state.tid);
+    }
+    ThreadBuffer* buffer = state.buffer;
+
+    // First event since `start()`, start over. This only happens once per
+    // recording, so it can take the lock that exporting holds.
+    uint64_t generation = _generation.load(std::memory_order_relaxed);
+    if (buffer->generation.load(std::memory_order_relaxed) != generation) {
+        std::lock_guard<std::mutex> lock(_mutex);
+
+        size_t capacity = _events_per_thread.load(std::memory_order_relaxed);
+        if (buffer->capacity != capacity) {
+            buffer->events = std::make_unique<Event[]>(capacity);
+            buffer->capacity = capacity;
+        }
+
+        buffer->head.store(0, std::memory_order_relaxed);
+        buffer->generation.store(generation, std::memory_order_relaxed);
+    }
+
+    uint64_t head = buffer->head.load(std::memory_order_relaxed);
+
+    Event& event = buffer->events[head % buffer->capacity];
+    event.name.store(name, std::memory_order_relaxed);
+    event.start_ns.store(start_ns, std::memory_order_relaxed);
+    event.duration_ns.store(end_ns - start_ns, std::memory_order_relaxed);
+    event.arg.store(arg, std::memory_order_relaxed);
+    event.session.store(session, std::memory_order_relaxed);
+
+    buffer->head.store(head + 1, std::memory_order_release);
+}
+
+void DailyTracer::set_thread_name(const std::string& name) {
+    uint32_t tid = thread_state().tid;
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    _thread_names[tid] = name;
+}
+
+uint32_t DailyTracer::new_session() {
+    return ++_session_counter;
+}
+
+std::string DailyTracer::chrome_trace() {
+    nlohmann::json events = nlohmann::json::array();
+
+    uint64_t generation = _generation.load(std::memory_order_relaxed);
+
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    for (const std::unique_ptr<ThreadBuffer>& buffer : _buffers) {
+        if (buffer->generation.load(std::memory_order_acquire) != generation) {
+            continue;
+        }
+
+        uint64_t head = buffer->head.load(std::memory_order_acquire);
+        uint64_t first = head > buffer->capacity ? head - buffer->capacity : 0;
+
+        std::vector<nlohmann::json> thread_events;
+        std::set<uint32_t> sessions;
+
+        for (uint64_t i = first; i < head; i++) {
+            const Event& event = buffer->events[i % buffer->capacity];
+
+            uint32_t session = event.session.load(std::memory_order_relaxed);
+            sessions.insert(session);
+
+            thread_events.push_back(
+                    {{"name", event.name.load(std::memory_order_relaxed)},
+                     {"cat", "daily"},
+                     {"ph", "X"},
+                     {"ts",
+                      event.start_ns.load(std::memory_order_relaxed) / 1000.0},
+                     {"dur",
+                      event.duration_ns.load(std::memory_order_relaxed) /
+                              1000.0},
+                     {"pid", session},
+                     {"tid", buffer->tid},
+                     {"args",
+                      {{"arg", event.arg.load(std::memory_order_relaxed)}}}}
+            );
+        }
+
+        // The thread kept recording while we were reading, so the oldest
+        // events we read might have been overwritten.
+        uint64_t new_head = buffer->head.load(std::memory_order_acquire);
+        uint64_t overwritten = new_head > buffer->capacity + first
+                                       ? new_head - buffer->capacity - first
+                                       : 0;
+        overwritten = std::min<uint64_t>(overwritten, thread_events.size());
+
+        for (size_t i = overwritten; i < thread_events.size(); i++) {
+            events.push_back(std::move(thread_events[i]));
+        }
+
+        // Threads are shared by sessions (e.g. daily-core's events thread),
+        // so name them in every session they appear in.
+        auto name_it = _thread_names.find(buffer->tid);
+        std::string name = name_it == _thread_names.end()
+                                   ? "thread-" + std::to_string(buffer->tid)
+                                   : name_it->second;
+        for (uint32_t session : sessions) {
+            events.push_back(
+                    {{"name", "thread_name"},
+                     {"ph", "M"},
+                     {"pid", session},
+                     {"tid", buffer->tid},
+                     {"args", {{"name", name}}}}
+            );
+        }
+    }
+
+    nlohmann::json trace = {
+            {"traceEvents", std::move(events)}, {"displayTimeUnit", "ms"}
+    };
+
+    return trace.dump();
+}
+
+bool DailyTracer::write_chrome_trace(const std::string& path) {
+    std::string trace = chrome_trace();
+
+    std::FILE* file = std::fopen(path.c_str(), "wb");
+    if (!file) {
+        return false;
+    }
+
+    bool written = std::fwrite(trace.data(), 1, trace.size(), file) ==
+                   trace.size();
+
+    return std::fclose(file) == 0 && written;
+}
+
+size_t DailyTracer::memory_bytes() {
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    size_t bytes = 0;
+    for (const std::unique_ptr<ThreadBuffer>& buffer : _buffers) {
+        bytes += sizeof(ThreadBuffer) + buffer->capacity * sizeof(Event);
+    }
+    return bytes;
+}
+
+// Private
+
+DailyTracer::ThreadState& DailyTracer::thread_state() {
+    thread_local ThreadState state;
+
+    if (!state.tid) {
+        state.tid = ++_thread_counter;
+    }
+
+    return state;
+}
+
+DailyTracer::ThreadBuffer* DailyTracer::create_thread_buffer(uint32_t tid) {
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    size_t capacity = _events_per_thread.load();
+
+    auto buffer = std::make_unique<ThreadBuffer>();
+    buffer->tid = tid;
+    buffer->exited = false;
+    buffer->generation = _generation.load();
+    buffer->head = 0;
+    buffer->events = std::make_unique<Event[]>(capacity);
+    buffer->capacity = capacity;
+
+    _buffers.push_back(std::move(buffer));
+    return _buffers.back().get();
+}
+
+void DailyTracer::thread_exited(const ThreadState& state) {
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    // Keep the events of the thread until the next recording.
+    if (state.buffer) {
+        state.buffer->exited = true;
+    } else {
+        _thread_names.erase(state.tid);
+    }
+}
@@ -4,6 +4,10 @@
 
 #include "daily_transport.h"
 
+#include "daily_audio.h"
+
+#include <algorithm>
+
 using namespace rtvi;
 
 // NOTE: Do not modify. This is a way for the server to recognize a known
@@ -20,13 +24,145 @@ static DailyTransportParams DEFAULT_TRANSPORT_PARAMS = {
         .bot_audio_channels = 1,
 };
 
+// Transports created without params share the default ones.
+static std::shared_ptr<const DailyTransportParams> default_transport_params() {
+    static auto params = std::make_shared<const DailyTransportParams>(
+            DEFAULT_TRANSPORT_PARAMS
+    );
+    return params;
+}
+
+// Subscriptions profiles and client settings are constant, so we pass them to
+// daily-core as is instead of building (and dumping) a JSON tree on every
+// connection. The microphone device id is filled in once per transport.
+static const char* SUBSCRIPTION_PROFILES = R"({
+  "base": {
+    "camera": "unsubscribed",
+    "microphone": "subscribed"
+  }
+})";
+
+// Used with `subscribe_bot_only`. Subscriptions to the bot are then updated
+// when it joins or leaves.
+static const char* BOT_ONLY_SUBSCRIPTION_PROFILES = R"({
+  "base": {
+    "camera": "unsubscribed",
+    "microphone": "unsubscribed"
+  }
+})";
+
+static const char* CLIENT_SETTINGS = R"({
+  "inputs": {
+    "camera": false,
+    "microphone": {
+      "isEnabled": true,
+      "settings": {
+        "deviceId": "mic",
+        "customConstraints": {
+          "echoCancellation": { "exact": true }
+        }
+      }
+    }
+  }
+})";
+
+// daily-core context and device manager are process-wide, so they are shared
+// by all transports and only created once (see `DailyTransport::warm_up()`).
+static std::once_flag CONTEXT_ONCE;
+static NativeDeviceManager* DEVICE_MANAGER = nullptr;
+
+// daily-core only plays the selected speaker, which is global. A single
+// speaker is shared by all transports, which receive the bot audio through
+// audio renderers instead. It's non-blocking, so it keeps playing (and the
+// renderers receiving audio) even though nobody reads it.
+static DailyVirtualSpeakerDevice* SPEAKER = nullptr;
+
+// Virtual devices live as long as the daily-core context. Microphones are
+// given back to this pool when a transport is destroyed and reused by the
+// next one with the same format, so they are never more than the transports
+// alive at the same time.
+struct PooledMicrophone {
+    DailyVirtualMicrophoneDevice* device;
+    std::string name;
+    uint32_t sample_rate;
+    uint32_t num_channels;
+};
+
+static std::mutex MICROPHONES_MUTEX;
+static std::vector<PooledMicrophone> MICROPHONES;
+
+// Per-participant audio buffers hold up to 1 second of 48 kHz stereo audio.
+static const size_t PARTICIPANT_AUDIO_CAPACITY = 48000 * 2;
+
+// Used to give each microphone its own name.
+static std::atomic<uint64_t> DEVICE_COUNTER {0};
+
+// daily-core events handled by the transport.
+enum EventAction : int32_t {
+    PARTICIPANT_JOINED,
+    PARTICIPANT_UPDATED,
+    PARTICIPANT_LEFT,
+    APP_MESSAGE,
+    CALL_STATE_UPDATED,
+    NETWORK_CONNECTION,
+    REQUEST_COMPLETED,
+    NUM_EVENT_ACTIONS
+};
+
+static constexpr DailyPerfectHash<NUM_EVENT_ACTIONS> EVENT_ACTIONS({
+        "participant-joined",
+        "participant-updated",
+        "participant-left",
+        "app-message",
+        "call-state-updated",
+        "network-connection",
+        "request-completed",
+});
+static_assert(EVENT_ACTIONS.valid(), "no perfect hash for event actions");
+
+// App message labels handled by the transport.
+enum MessageLabel : int32_t {
+    RTVI_MESSAGE,
+    RTVI_MESSAGE_CHUNK,
+    NUM_MESSAGE_LABELS
+};
+
+static constexpr DailyPerfectHash<NUM_MESSAGE_LABELS> MESSAGE_LABELS({
+        "rtvi-ai",
+        DAILY_MESSAGE_CHUNK_LABEL,
+});
+static_assert(MESSAGE_LABELS.valid(), "no perfect hash for message labels");
+
+// Lane for messages sent without a priority, with `prioritize_messages`.
+static DailyMessagePriority message_priority(const nlohmann::json& message) {
+    if (!message.is_object() || !message.contains("type")) {
+        return DailyMessagePriority::Normal;
+    }
+
+    const nlohmann::json& type = message["type"];
+
+    if (type == "llm-function-call-result") {
+        return DailyMessagePriority::Control;
+    }
+
+    if (type == "action" && message.contains("data") &&
+        message["data"].contains("action")) {
+        const nlohmann::json& action = message["data"]["action"];
+        if (action == "append_to_messages" || action == "set_context") {
+            return DailyMessagePriority::Bulk;
+        }
+    }
+
+    return DailyMessagePriority::Normal;
+}
+
 static WebrtcAudioDeviceModule* create_audio_device_module_cb(
         DailyRawWebRtcContextDelegate* delegate,
         WebrtcTaskQueueFactory* task_queue_factory
 ) {
-    auto transport = static_cast<DailyTransport*>(delegate);
-
-    return transport->create_audio_device_module(task_queue_factory);
+    return daily_core_context_create_audio_device_module(
+            DEVICE_MANAGER, task_queue_factory
+    );
 }
 
 static void* get_user_media_cb(
@@ -37,9 +173,8 @@ static void* get_user_media_cb(
         WebrtcThread* webrtc_network_thread,
         const char* constraints
 ) {
-    auto transport = static_cast<DailyTransport*>(delegate);
-
-    return transport->get_user_media(
+    return daily_core_context_device_manager_get_user_media(
+            DEVICE_MANAGER,
             peer_connection_factory,
             webrtc_signaling_thread,
             webrtc_worker_thread,
@@ -49,9 +184,8 @@ static void* get_user_media_cb(
 }
 
 static char* enumerate_devices_cb(DailyRawWebRtcContextDelegate* delegate) {
-    auto transport = static_cast<DailyTransport*>(delegate);
-
-    return transport->enumerate_devices();
+    return daily_core_context_device_manager_enumerated_devices(DEVICE_MANAGER
+    );
 }
 
 static const char* get_audio_device_cb(DailyRawWebRtcContextDelegate* delegate
@@ -69,79 +203,200 @@ static void on_event_cb(
         const char* event_json,
         intptr_t json_len
 ) {
-    nlohmann::json event = nlohmann::json::parse(event_json);
     auto transport = static_cast<DailyTransport*>(delegate);
 
-    transport->on_event(event);
+    transport->on_event(std::string_view(event_json, json_len));
+}
+
+static void on_audio_data_cb(
+        DailyRawCallClientDelegate* delegate,
+        uint64_t renderer_id,
+        const char* peer_id,
+        const NativeAudioData* audio_data
+) {
+    auto transport = static_cast<DailyTransport*>(delegate);
+
+    transport->on_audio_data(renderer_id, audio_data);
 }
 
 DailyTransport::DailyTransport(
         const RTVIClientOptions& options,
         RTVITransportMessageObserver* message_observer
 )
-    : DailyTransport(options, DEFAULT_TRANSPORT_PARAMS, message_observer) {}
+    : DailyTransport(options, default_transport_params(), message_observer) {}
 
 DailyTransport::DailyTransport(
         const RTVIClientOptions& options,
         const DailyTransportParams& params,
         RTVITransportMessageObserver* message_observer
+)
+    : DailyTransport(
+              options,
+              std::make_shared<const DailyTransportParams>(params),
+              message_observer
+      ) {}
+
+DailyTransport::DailyTransport(
+        const RTVIClientOptions& options,
+        std::shared_ptr<const DailyTransportParams> params,
+        RTVITransportMessageObserver* message_observer
 )
     : _initialized(false),
       _connected(false),
-      _options(options),
-      _params(params),
+      _joined(false),
+      _leaving(false),
+      _callbacks(options.callbacks),
+      _params(std::move(params)),
       _message_observer(message_observer),
       _client(nullptr),
-      _request_id(0) {}
+      _client_active(false),
+      _client_callbacks(0),
+      _microphone(nullptr),
+      _request_id(0),
+      _completions(CompletionMap::allocator_type(&_completions_memory)),
+      _msg_queue(_params->max_queued_message_bytes),
+      _chunked_message_id(0),
+      _reconnecting(false),
+      _network_interrupted(false),
+      _left_since_join(false),
+      _bot_silence_frames(0),
+      _user_audio_buffer(AudioBuffer::allocator_type(&_audio_buffers_memory)),
+      _bot_audio_buffer(AudioBuffer::allocator_type(&_audio_buffers_memory)),
+      _processed_audio_buffer(
+              AudioBuffer::allocator_type(&_audio_buffers_memory)
+      ),
+      _next_levels_ns(0),
+      _renderer_id(1),
+      _bot_audio(
+              _params->bot_audio_sample_rate,
+              _params->bot_audio_channels,
+              _params->bot_audio_sample_rate
+      ),
+      _bot_renderer_id(0),
+      _client_ready_message(RTVIMessage::client_ready().dump()),
+      _trace_session(DailyTracer::instance().new_session()) {
+    if (_params->dispatch_callbacks || _params->callback_executor) {
+        _dispatcher = std::make_unique<DailyCallbackDispatcher>(
+                _params->callback_executor, _params->thread_config
+        );
+    }
+
+    if (_params->paced_user_audio) {
+        if (_params->user_audio_speed <= 0) {
+            throw RTVIException("invalid user audio speed");
+        }
+
+        _user_audio_pacer = std::make_unique<DailyAudioPacer>(
+                _params->user_audio_sample_rate,
+                _params->user_audio_channels,
+                [this](const int16_t* frames, size_t num_frames) {
+                    return send_user_audio(frames, num_frames);
+                },
+                _params->audio_thread_config
+        );
+    }
+
+    if (_params->audio_levels) {
+        // Levels are measured in 10ms blocks.
+        if (_params->user_audio_sample_rate < 100 ||
+            _params->user_audio_channels == 0 ||
+            _params->bot_audio_sample_rate < 100 ||
+            _params->bot_audio_channels == 0) {
+            throw RTVIException("invalid audio format for audio levels");
+        }
+
+        _user_audio_meter = std::make_unique<DailyAudioMeter>(
+                _params->user_audio_sample_rate,
+                _params->user_audio_channels,
+                _params->speaking_threshold_dbfs,
+                _params->speaking_hangover_ms
+        );
+        _bot_audio_meter = std::make_unique<DailyAudioMeter>(
+                _params->bot_audio_sample_rate,
+                _params->bot_audio_channels,
+                _params->speaking_threshold_dbfs,
+                _params->speaking_hangover_ms
+        );
+    }
+
+    if (_params->user_audio_processing) {
+        _user_audio_processor = DailyAudioProcessor::create_default(
+                _params->user_audio_sample_rate, _params->user_audio_channels
+        );
+    }
+
+    if (!_params->user_audio_recording_path.empty() ||
+        !_params->bot_audio_recording_path.empty()) {
+        _recorder = std::make_unique<DailyAudioRecorder>(
+                DailyAudioRecorder::Track {
+                        .path = _params->user_audio_recording_path,
+                        .sample_rate = _params->user_audio_sample_rate,
+                        .num_channels = _params->user_audio_channels
+                },
+                DailyAudioRecorder::Track {
+                        .path = _params->bot_audio_recording_path,
+                        .sample_rate = _params->bot_audio_sample_rate,
+                        .num_channels = _params->bot_audio_channels
+                },
+                _params->thread_config
+        );
+    }
+}
 
 DailyTransport::~DailyTransport() {
     disconnect();
-}
 
-void DailyTransport::initialize() {
-    if (_initialized) {
-        return;
-    }
+    release_devices();
 
-    daily_core_set_log_level(DailyLogLevel_Off);
+    discard_completions();
+    DailyWatchdog::instance().synchronize();
+}
 
-    _device_manager = daily_core_context_create_device_manager();
+void DailyTransport::warm_up() {
+    std::call_once(CONTEXT_ONCE, [] {
+        daily_core_set_log_level(DailyLogLevel_Off);
 
-    DailyContextDelegatePtr* ptr = nullptr;
-    DailyContextDelegate driver = {.ptr = ptr};
+        DEVICE_MANAGER = daily_core_context_create_device_manager();
 
-    DailyWebRtcContextDelegate webrtc = {
-            .ptr = (DailyWebRtcContextDelegatePtr*)this,
-            .fns = {.get_user_media = get_user_media_cb,
-                    .get_enumerated_devices = enumerate_devices_cb,
-                    .create_audio_device_module = create_audio_device_module_cb,
-                    .get_audio_device = get_audio_device_cb,
-                    .set_audio_device = set_audio_device_cb}
-    };
+        // daily-core needs a selected speaker to play remote audio, but it's
+        // only a sink: bot audio is read from the bot's audio renderer, in
+        // the format of each transport's params, not from this device.
+        SPEAKER = daily_core_context_create_virtual_speaker_device(
+                DEVICE_MANAGER, "speaker", 16000, 1, true
+        );
+        daily_core_context_select_speaker_device(DEVICE_MANAGER, "speaker");
+
+        DailyContextDelegatePtr* ptr = nullptr;
+        DailyContextDelegate driver = {.ptr = ptr};
+
+        DailyWebRtcContextDelegate webrtc = {
+                .ptr = nullptr,
+                .fns = {.get_user_media = get_user_media_cb,
+                        .get_enumerated_devices = enumerate_devices_cb,
+                        .create_audio_device_module =
+                                create_audio_device_module_cb,
+                        .get_audio_device = get_audio_device_cb,
+                        .set_audio_device = set_audio_device_cb}
+        };
+
+        daily_core_context_create(driver, webrtc, ABOUT_CLIENT);
+    });
+}
 
-    daily_core_context_create(driver, webrtc, ABOUT_CLIENT);
+void DailyTransport::initialize() {
+    if (_initialized) {
+        return;
+    }
 
-    _speaker = daily_core_context_create_virtual_speaker_device(
-            _device_manager,
-            "speaker",
-            _params.bot_audio_sample_rate,
-            _params.bot_audio_channels,
-            false
-    );
-    daily_core_context_select_speaker_device(_device_manager, "speaker");
-
-    _microphone = daily_core_context_create_virtual_microphone_device(
-            _device_manager,
-            "mic",
-            _params.user_audio_sample_rate,
-            _params.user_audio_channels,
-            true
-    );
+    // Virtual devices are created on the first connection.
+    warm_up();
 
     _initialized = true;
 }
 
 void DailyTransport::connect(const nlohmann::json& info) {
+    std::lock_guard<std::mutex> connection_lock(_connection_mutex);
+
     if (!_initialized) {
         throw RTVIException("transport is not initialized");
     }
@@ -159,276 +414,1302 @@ void DailyTransport::connect(const nlohmann::json& info) {
         );
     }
 
+    DailyTraceSpan span(_trace_session, "connect");
+
+    if (!_microphone) {
+        create_devices();
+    }
+
     // Cleanup bot participant.
-    _bot_participant = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(_bot_participant_mutex);
+        _bot_participant_id.clear();
+    }
+    _bot_renderer_id = 0;
+    _bot_audio.open();
+
+    if (_recorder && !_recorder->start()) {
+        throw RTVIException("unable to create audio recording files");
+    }
 
-    std::string room_url = info["room_url"].get<std::string>();
-    std::string token = info["token"].get<std::string>();
+    if (_dispatcher) {
+        _dispatcher->start();
+    }
+
+    _room_url = info["room_url"].get<std::string>();
+    _token = info["token"].get<std::string>();
 
     _client = daily_core_call_client_create();
+    _client_active = true;
 
     DailyCallClientDelegate delegate = {
-            .ptr = this, .fns = {.on_event = on_event_cb}
+            .ptr = this,
+            .fns = {.on_event = on_event_cb, .on_audio_data = on_audio_data_cb}
     };
 
     daily_core_call_client_set_delegate(_client, delegate);
 
-    // Subscriptions profiles
-    nlohmann::json profiles = nlohmann::json::parse(R"({
-      "base": {
-        "camera": "unsubscribed",
-        "microphone": "subscribed"
-      }
-    })");
-    std::string profiles_str = profiles.dump();
-
-    std::promise<void> update_promise;
-    std::future<void> update_future = update_promise.get_future();
-    uint64_t request_id = add_completion(std::move(update_promise));
-    daily_core_call_client_update_subscription_profiles(
-            _client, request_id, profiles_str.c_str()
-    );
-    update_future.get();
-
-    // Client settings
-    nlohmann::json settings = nlohmann::json::parse(R"({
-      "inputs": {
-        "camera": false,
-        "microphone": {
-          "isEnabled": true,
-          "settings": {
-            "deviceId": "mic",
-            "customConstraints": {
-              "echoCancellation": { "exact": true }
-            }
-          }
+    _leaving = false;
+    _network_interrupted = false;
+
+    try {
+        // Subscriptions profiles
+        {
+            DailyTraceSpan profiles_span(
+                    _trace_session, "update-subscription-profiles"
+            );
+            std::promise<void> update_promise;
+            std::future<void> update_future = update_promise.get_future();
+            uint64_t request_id = add_completion(
+                    std::move(update_promise), "update-subscription-profiles"
+            );
+            daily_core_call_client_update_subscription_profiles(
+                    _client,
+                    request_id,
+                    _params->subscribe_bot_only
+                            ? BOT_ONLY_SUBSCRIPTION_PROFILES
+                            : SUBSCRIPTION_PROFILES
+            );
+            update_future.get();
         }
-      }
-    })");
-    std::string settings_str = settings.dump();
 
-    std::promise<void> join_promise;
-    std::future<void> join_future = join_promise.get_future();
-    request_id = add_completion(std::move(join_promise));
-    daily_core_call_client_join(
-            _client,
-            request_id,
-            room_url.c_str(),
-            token.c_str(),
-            settings_str.c_str()
-    );
-    join_future.get();
+        join();
+    } catch (const RTVIException& ex) {
+        close_client_callbacks();
+        daily_core_call_client_destroy(_client);
+        _client = nullptr;
+        discard_completions();
+        if (_dispatcher) {
+            _dispatcher->stop();
+        }
+        if (_recorder) {
+            _recorder->stop();
+        }
+        throw;
+    }
+
+    // The room URL and token are only needed again to rejoin.
+    if (!_params->auto_reconnect) {
+        std::string().swap(_room_url);
+        std::string().swap(_token);
+    }
 
     // Start send message thread.
+    _msg_queue.restart();
     _msg_thread = std::thread(&DailyTransport::send_message_thread, this);
 
-    _connected = true;
+    {
+        std::lock_guard<std::mutex> lock(_reconnect_mutex);
+        _connected = true;
+
+        // The call might have dropped since we joined.
+        if (!_joined) {
+            start_reconnecting();
+        }
+    }
+
+    if (_user_audio_pacer) {
+        _user_audio_pacer->start(_params->user_audio_speed);
+    }
 
-    if (_options.callbacks) {
-        _options.callbacks->on_connected();
+    if (_callbacks) {
+        _callbacks->on_connected();
     }
 }
 
 void DailyTransport::disconnect() {
+    std::lock_guard<std::mutex> connection_lock(_connection_mutex);
+
     if (!_connected) {
         return;
     }
 
+    DailyTraceSpan span(_trace_session, "disconnect");
+
+    // Interrupt any ongoing reconnection and unblock the send message thread
+    // if it's waiting for us to rejoin.
+    {
+        std::lock_guard<std::mutex> lock(_reconnect_mutex);
+        _leaving = true;
+    }
+    _reconnect_cv.notify_all();
+
+    if (_reconnect_thread.joinable()) {
+        _reconnect_thread.join();
+    }
+
     // Stop and wait for send message thread to finish.
     _msg_queue.stop();
     _msg_thread.join();
 
-    std::promise<void> leave_promise;
-    std::future<void> leave_future = leave_promise.get_future();
-    uint64_t request_id = add_completion(std::move(leave_promise));
-    daily_core_call_client_leave(_client, request_id);
-    leave_future.get();
+    if (_user_audio_pacer) {
+        _user_audio_pacer->stop();
+    }
+
+    // Unblock bot audio readers.
+    _bot_audio.close();
+
+    {
+        DailyTraceSpan leave_span(_trace_session, "leave");
+        std::promise<void> leave_promise;
+        std::future<void> leave_future = leave_promise.get_future();
+        uint64_t request_id =
+                add_completion(std::move(leave_promise), "leave");
+        daily_core_call_client_leave(_client, request_id);
+        try {
+            leave_future.get();
+        } catch (const RTVIException& ex) {
+            // We are tearing down the call client anyway.
+        }
+    }
 
+    // Events arriving from now on (e.g. the participants leaving) are
+    // dropped, so they can't run concurrently with (or after) the teardown.
+    close_client_callbacks();
     daily_core_call_client_destroy(_client);
+    _client = nullptr;
+
+    // Requests nobody waits for (e.g. subscription updates) can't complete
+    // anymore, so they would otherwise time out.
+    discard_completions();
+
+    if (_recorder) {
+        _recorder->stop();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(_participant_audio_mutex);
+        _participant_audio.clear();
+    }
+
+    // Deliver pending callbacks before we notify the disconnection.
+    if (_dispatcher) {
+        _dispatcher->stop();
+    }
 
+    _joined = false;
     _connected = false;
 
-    if (_options.callbacks) {
-        _options.callbacks->on_disconnected();
+    if (_callbacks) {
+        _callbacks->on_disconnected();
     }
 }
 
 void DailyTransport::send_message(const nlohmann::json& message) {
+    send_message(
+            message,
+            _params->prioritize_messages ? message_priority(message)
+                                         : DailyMessagePriority::Normal
+    );
+}
+
+void DailyTransport::send_message(
+        const nlohmann::json& message,
+        DailyMessagePriority priority
+) {
     if (!_connected) {
         return;
     }
 
-    _msg_queue.push(message);
+    // Serialize on the caller thread. Queueing the encoded message is much
+    // cheaper than copying the whole JSON tree.
+    send_raw_message(message.dump(), priority);
 }
 
-int32_t
-DailyTransport::send_user_audio(const int16_t* frames, size_t num_frames) {
+void DailyTransport::send_raw_message(
+        std::string data,
+        DailyMessagePriority priority
+) {
     if (!_connected) {
-        return 0;
+        return;
     }
 
-    return daily_core_context_virtual_microphone_device_write_frames(
-            _microphone, frames, num_frames, _request_id++, nullptr, nullptr
-    );
-}
+    if (_params->message_chunk_size == 0 ||
+        data.size() <= _params->message_chunk_size) {
+        _msg_queue.push(std::move(data), priority);
+        return;
+    }
 
-int32_t DailyTransport::read_bot_audio(int16_t* frames, size_t num_frames) {
-    if (!_connected) {
-        return 0;
+    // Each chunk is queued on its own, so when prioritizing messages of
+    // higher priority lanes are sent in between.
+    if (_params->prioritize_messages &&
+        priority != DailyMessagePriority::Control) {
+        priority = DailyMessagePriority::Bulk;
     }
 
-    return daily_core_context_virtual_speaker_device_read_frames(
-            _speaker, frames, num_frames, _request_id++, nullptr, nullptr
+    std::vector<std::string> chunks = daily_split_message(
+            data, _chunked_message_id++, _params->message_chunk_size
     );
-}
 
-// Public but internal
+    // Partially queued messages could never be reassembled, so chunks are
+    // queued (or dropped) together.
+    _msg_queue.push(std::move(chunks), priority);
+}
 
-WebrtcAudioDeviceModule* DailyTransport::create_audio_device_module(
-        WebrtcTaskQueueFactory* task_queue_factory
+void DailyTransport::set_event_handler(
+        const std::string& action,
+        Handler handler
 ) {
-    return daily_core_context_create_audio_device_module(
-            _device_manager, task_queue_factory
-    );
+    _event_handlers[action] = std::move(handler);
 }
 
-char* DailyTransport::enumerate_devices() {
-    return daily_core_context_device_manager_enumerated_devices(_device_manager
-    );
+void DailyTransport::set_message_handler(
+        const std::string& type,
+        Handler handler
+) {
+    _message_handlers[type] = std::move(handler);
 }
 
-void* DailyTransport::get_user_media(
-        WebrtcPeerConnectionFactory* peer_connection_factory,
-        WebrtcThread* webrtc_signaling_thread,
-        WebrtcThread* webrtc_worker_thread,
-        WebrtcThread* webrtc_network_thread,
-        const char* constraints
-) {
-    return daily_core_context_device_manager_get_user_media(
-            _device_manager,
-            peer_connection_factory,
-            webrtc_signaling_thread,
-            webrtc_worker_thread,
-            webrtc_network_thread,
-            constraints
-    );
+DailyMessageLaneStats
+DailyTransport::message_lane_stats(DailyMessagePriority priority) {
+    return _msg_queue.stats(priority);
 }
 
-void DailyTransport::on_event(const nlohmann::json& event) {
-    auto action = event["action"].get<std::string>();
+int32_t
+DailyTransport::send_user_audio(const int16_t* frames, size_t num_frames) {
+    if (!_connected) {
+        return 0;
+    }
 
-    switch (hash(action.c_str())) {
-    case hash("participant-joined"):
-        on_participant_joined(event["participant"]);
-        break;
-    case hash("participant-updated"):
-        on_participant_updated(event["participant"]);
-        break;
-    case hash("participant-left"):
-        on_participant_left(
-                event["participant"], event["leftReason"].get<std::string>()
-        );
-        break;
-    case hash("app-message"): {
-        if (event.contains("msgData") && event["msgData"].contains("label")) {
-            auto label = event["msgData"]["label"].get<std::string>();
-            if (label == "rtvi-ai" && _message_observer) {
-                _message_observer->on_transport_message(event["msgData"]);
-            }
-        }
+    DailyTraceSpan span(_trace_session, "send_user_audio", num_frames);
 
-        break;
+    if (!_user_audio_processor) {
+        return write_user_audio(frames, num_frames);
     }
-    case hash("error"):
-        break;
-    case hash("request-completed"): {
-        auto request_id = event["requestId"]["id"].get<uint64_t>();
-        resolve_completion(request_id);
-        break;
+
+    size_t capacity = (num_frames + _user_audio_processor->block_frames()) *
+                      _params->user_audio_channels;
+    if (_processed_audio_buffer.size() < capacity) {
+        _processed_audio_buffer.resize(capacity);
     }
-    default:
-        break;
+
+    int16_t* processed = _processed_audio_buffer.data();
+
+    // The processor keeps frames that don't fill a 10ms block until the next
+    // call, so we report all the frames as sent.
+    size_t num_processed =
+            _user_audio_processor->process(frames, num_frames, processed);
+    if (num_processed > 0) {
+        int32_t written = write_user_audio(processed, num_processed);
+        if (written < 0) {
+            return written;
+        }
     }
+
+    return num_frames;
 }
 
-// Private
+int32_t DailyTransport::read_bot_audio(int16_t* frames, size_t num_frames) {
+    if (!_connected) {
+        return 0;
+    }
 
-uint64_t DailyTransport::add_completion(std::promise<void> completion) {
-    std::lock_guard<std::mutex> lock(_completions_mutex);
+    DailyTraceSpan span(_trace_session, "read_bot_audio", num_frames);
 
-    uint64_t request_id = _request_id++;
-    _completions[request_id] = std::move(completion);
+    int32_t read = _bot_audio.read(frames, num_frames);
 
-    return request_id;
+    if (_recorder && read > 0) {
+        _recorder->record_bot_audio(frames, read);
+    }
+
+    if (_bot_audio_meter && read > 0) {
+        _bot_audio_meter->process(frames, read);
+        report_audio_levels();
+    }
+
+    if (_user_audio_processor && read > 0) {
+        _user_audio_processor->add_reference(
+                frames,
+                read,
+                _params->bot_audio_sample_rate,
+                _params->bot_audio_channels
+        );
+    }
+
+    return read;
 }
 
-void DailyTransport::resolve_completion(uint64_t request_id) {
-    std::lock_guard<std::mutex> lock(_completions_mutex);
-    _completions[request_id].set_value();
-    _completions.erase(request_id);
+DailyCallbackStats DailyTransport::callback_stats() const {
+    return _dispatcher ? _dispatcher->stats() : DailyCallbackStats {};
 }
 
-void DailyTransport::send_message_thread() {
-    bool running = true;
-    while (running) {
-        std::optional<nlohmann::json> message = _msg_queue.blocking_pop();
-        if (message.has_value()) {
-            std::string data = (*message).dump();
-
-            std::promise<void> msg_promise;
-            std::future<void> msg_future = msg_promise.get_future();
-            uint64_t request_id = add_completion(std::move(msg_promise));
-            daily_core_call_client_send_app_message(
-                    _client, request_id, data.c_str(), nullptr
-            );
-            msg_future.get();
-        } else {
-            running = false;
+std::shared_ptr<DailyParticipantAudioStream>
+DailyTransport::participant_audio(const std::string& participant_id) {
+    std::lock_guard<std::mutex> lock(_participant_audio_mutex);
+
+    for (auto& [renderer_id, stream] : _participant_audio) {
+        if (stream->participant_id() == participant_id) {
+            return stream;
         }
     }
+
+    return nullptr;
 }
 
-void DailyTransport::on_participant_joined(const nlohmann::json& participant) {
-    std::string participant_id = participant["id"].get<std::string>();
+std::vector<std::string> DailyTransport::participant_audio_ids() {
+    std::lock_guard<std::mutex> lock(_participant_audio_mutex);
 
-    // We assume the first remote participant is a bot.
-    if (_bot_participant.is_null()) {
-        _bot_participant = participant;
+    std::vector<std::string> ids;
+    for (auto& [renderer_id, stream] : _participant_audio) {
+        ids.push_back(stream->participant_id());
+    }
 
-        if (_options.callbacks) {
-            _options.callbacks->on_bot_connected(participant);
-        }
+    return ids;
+}
+
+int32_t
+DailyTransport::send_user_audio(const DailyAudioSpan<const float>& audio) {
+    if (!_connected) {
+        return 0;
+    }
+
+    if (audio.num_channels != _params->user_audio_channels) {
+        throw RTVIException("invalid user audio: wrong number of channels");
+    }
+
+    if (_user_audio_buffer.size() < audio.num_samples()) {
+        _user_audio_buffer.resize(audio.num_samples());
+    }
+
+    int16_t* frames = _user_audio_buffer.data();
+
+    if (audio.layout == DailyAudioLayout::Interleaved ||
+        audio.num_channels == 1) {
+        audio_float_to_int16(audio.data, frames, audio.num_samples());
+    } else {
+        audio_planar_float_to_int16(
+                audio.data,
+                frames,
+                audio.num_frames,
+                audio.num_channels,
+                audio.num_frames
+        );
     }
+
+    return send_user_audio(frames, audio.num_frames);
 }
 
-void DailyTransport::on_participant_updated(const nlohmann::json& participant) {
-    std::string participant_id = participant["id"].get<std::string>();
-    bool is_local = participant["info"]["isLocal"].get<bool>();
+int32_t DailyTransport::read_bot_audio(const DailyAudioSpan<float>& audio) {
+    if (!_connected) {
+        return 0;
+    }
 
-    // We don't care about local updates, at least for now. Also, make sure we
-    // have a bot participant (we should if hte update is non-local).
-    if (is_local || _bot_participant.is_null()) {
-        return;
+    if (audio.num_channels != _params->bot_audio_channels) {
+        throw RTVIException("invalid bot audio: wrong number of channels");
     }
 
-    std::string bot_participant_id = _bot_participant["id"].get<std::string>();
+    if (_bot_audio_buffer.size() < audio.num_samples()) {
+        _bot_audio_buffer.resize(audio.num_samples());
+    }
 
-    // Let's make sure the updated participant is the bot one.
-    if (participant_id == bot_participant_id) {
-        std::string mic_state =
-                participant["media"]["microphone"]["state"].get<std::string>();
+    int16_t* frames = _bot_audio_buffer.data();
 
-        if (mic_state == "playable") {
-            send_message(RTVIMessage::client_ready());
-        }
+    int32_t num_frames = read_bot_audio(frames, audio.num_frames);
+    if (num_frames <= 0) {
+        return num_frames;
+    }
+
+    // For planar layouts planes are `audio.num_frames` long, even if we read
+    // fewer frames.
+    if (audio.layout == DailyAudioLayout::Interleaved ||
+        audio.num_channels == 1) {
+        size_t num_samples = num_frames * audio.num_channels;
+        audio_int16_to_float(frames, audio.data, num_samples);
+    } else {
+        audio_int16_to_planar_float(
+                frames,
+                audio.data,
+                num_frames,
+                audio.num_channels,
+                audio.num_frames
+        );
     }
+
+    return num_frames;
 }
 
-void DailyTransport::on_participant_left(
+void DailyTransport::queue_user_audio(const int16_t* data, size_t num_frames) {
+    if (!_user_audio_pacer) {
+        throw RTVIException("paced user audio is not enabled");
+    }
+
+    _user_audio_pacer->push(data, num_frames);
+}
+
+void DailyTransport::clear_user_audio() {
+    if (_user_audio_pacer) {
+        _user_audio_pacer->clear();
+    }
+}
+
+DailyAudioPacerStats DailyTransport::user_audio_stats() const {
+    return _user_audio_pacer ? _user_audio_pacer->stats()
+                             : DailyAudioPacerStats {};
+}
+
+DailyRecordingStats DailyTransport::recording_stats() const {
+    return _recorder ? _recorder->stats() : DailyRecordingStats {};
+}
+
+DailyAudioLevels DailyTransport::user_audio_levels() const {
+    return _user_audio_meter ? _user_audio_meter->levels()
+                             : DailyAudioLevels {};
+}
+
+DailyAudioLevels DailyTransport::bot_audio_levels() const {
+    return _bot_audio_meter ? _bot_audio_meter->levels() : DailyAudioLevels {};
+}
+
+DailyMemoryReport DailyTransport::memory_report() {
+    size_t audio_buffers =
+            _audio_buffers_memory.bytes() + _bot_audio.memory_bytes();
+    if (_user_audio_pacer) {
+        audio_buffers += _user_audio_pacer->memory_bytes();
+    }
+
+    size_t participant_audio = 0;
+    {
+        std::lock_guard<std::mutex> lock(_participant_audio_mutex);
+        for (const auto& [renderer_id, stream] : _participant_audio) {
+            participant_audio += stream->memory_bytes();
+        }
+    }
+
+    return DailyMemoryReport {
+            .transport = sizeof(*this),
+            .message_queue = _msg_queue.memory().bytes(),
+            .completions = _completions_memory.bytes(),
+            .message_assembler = _message_assembler.memory().bytes(),
+            .audio_buffers = audio_buffers,
+            .participant_audio = participant_audio
+    };
+}
+
+DailyBotAudioChunk
+DailyTransport::read_bot_audio_chunk(int16_t* frames, size_t num_frames) {
+    DailyBotAudioChunk chunk = {
+            .num_frames = read_bot_audio(frames, num_frames),
+            .silence = false,
+            .silence_frames = 0
+    };
+
+    if (chunk.num_frames <= 0) {
+        return chunk;
+    }
+
+    size_t num_samples = chunk.num_frames * _params->bot_audio_channels;
+    if (audio_peak(frames, num_samples) <
+        _params->bot_audio_silence_threshold) {
+        _bot_silence_frames += chunk.num_frames;
+    } else {
+        _bot_silence_frames = 0;
+    }
+
+    // Short pauses (e.g. between words) are not reported as silence.
+    uint64_t min_silence_frames =
+            uint64_t(_params->bot_audio_sample_rate) *
+            _params->bot_audio_silence_min_ms / 1000;
+
+    if (_bot_silence_frames > 0 && _bot_silence_frames >= min_silence_frames) {
+        chunk.silence = true;
+        chunk.silence_frames = _bot_silence_frames;
+    }
+
+    return chunk;
+}
+
+// Public but internal
+
+void DailyTransport::on_event(std::string_view event_json) {
+    ClientCallbackScope scope(this);
+    if (!scope.active()) {
+        return;
+    }
+
+    DailyTraceSpan span(_trace_session, "on_event");
+
+    nlohmann::json event;
+    std::string parsed_action;
+
+    // Peek at the action so events nobody handles (e.g. network stats) are
+    // never parsed.
+    std::optional<std::string_view> action =
+            daily_json_peek_string(event_json, "action");
+    if (!action) {
+        event = nlohmann::json::parse(event_json);
+        parsed_action = event.value("action", "");
+        action = parsed_action;
+    }
+
+    int32_t index = EVENT_ACTIONS.find(*action);
+    auto handler = _event_handlers.find(*action);
+    if (index < 0 && handler == _event_handlers.end()) {
+        return;
+    }
+
+    if (event.is_null()) {
+        event = nlohmann::json::parse(event_json);
+    }
+
+    switch (index) {
+    case PARTICIPANT_JOINED:
+        on_participant_joined(event["participant"]);
+        break;
+    case PARTICIPANT_UPDATED:
+        on_participant_updated(event["participant"]);
+        break;
+    case PARTICIPANT_LEFT:
+        on_participant_left(
+                event["participant"], event["leftReason"].get<std::string>()
+        );
+        break;
+    case APP_MESSAGE:
+        on_app_message(event);
+        break;
+    case CALL_STATE_UPDATED:
+        on_call_state_updated(event["state"].get<std::string>());
+        break;
+    case NETWORK_CONNECTION:
+        on_network_connection(event.value("event", ""));
+        break;
+    case REQUEST_COMPLETED: {
+        auto request_id = event["requestId"]["id"].get<uint64_t>();
+        resolve_completion(
+                request_id, event.value("result", nlohmann::json())
+        );
+        break;
+    }
+    default:
+        break;
+    }
+
+    if (index >= 0) {
+        span.set_name(EVENT_ACTIONS.key(index).data());
+    }
+
+    if (handler != _event_handlers.end()) {
+        deliver(handler->second, std::move(event));
+    }
+}
+
+void DailyTransport::on_audio_data(
+        uint64_t renderer_id,
+        const NativeAudioData* audio_data
+) {
+    ClientCallbackScope scope(this);
+    if (!scope.active()) {
+        return;
+    }
+
+    if (audio_data->bits_per_sample != 16) {
+        return;
+    }
+
+    const int16_t* frames =
+            reinterpret_cast<const int16_t*>(audio_data->audio_frames);
+
+    if (renderer_id == _bot_renderer_id) {
+        _bot_audio.write(
+                frames,
+                audio_data->num_audio_frames,
+                audio_data->sample_rate,
+                audio_data->num_channels
+        );
+    }
+
+    std::shared_ptr<DailyParticipantAudioStream> stream;
+    {
+        std::lock_guard<std::mutex> lock(_participant_audio_mutex);
+        auto it = _participant_audio.find(renderer_id);
+        if (it == _participant_audio.end()) {
+            return;
+        }
+        stream = it->second;
+    }
+
+    // Written straight from daily-core's buffer into the stream.
+    stream->write(
+            frames,
+            audio_data->num_audio_frames,
+            audio_data->sample_rate,
+            audio_data->num_channels
+    );
+}
+
+// Private
+
+DailyTransport::ClientCallbackScope::ClientCallbackScope(
+        DailyTransport* transport
+)
+    : _transport(transport), _active(true) {
+    // Both need to be sequentially consistent, so either the callback sees
+    // the client closed or `close_client_callbacks()` sees the callback.
+    _transport->_client_callbacks++;
+    if (!_transport->_client_active) {
+        _transport->_client_callbacks--;
+        _active = false;
+    }
+}
+
+DailyTransport::ClientCallbackScope::~ClientCallbackScope() {
+    if (_active) {
+        _transport->_client_callbacks--;
+    }
+}
+
+void DailyTransport::close_client_callbacks() {
+    _client_active = false;
+
+    // Callbacks are short (slow application callbacks should be dispatched),
+    // so we just spin.
+    while (_client_callbacks > 0) {
+        std::this_thread::yield();
+    }
+}
+
+void DailyTransport::create_devices() {
+    DailyTraceSpan span(_trace_session, "create_devices");
+
+    uint32_t sample_rate = _params->user_audio_sample_rate;
+    uint32_t num_channels = _params->user_audio_channels;
+
+    {
+        std::lock_guard<std::mutex> lock(MICROPHONES_MUTEX);
+        auto it = std::find_if(
+                MICROPHONES.begin(),
+                MICROPHONES.end(),
+                [&](const PooledMicrophone& microphone) {
+                    return microphone.sample_rate == sample_rate &&
+                           microphone.num_channels == num_channels;
+                }
+        );
+        if (it != MICROPHONES.end()) {
+            _microphone = it->device;
+            _microphone_name = std::move(it->name);
+            MICROPHONES.erase(it);
+        }
+    }
+
+    if (!_microphone) {
+        _microphone_name = "mic-" + std::to_string(DEVICE_COUNTER++);
+        _microphone = daily_core_context_create_virtual_microphone_device(
+                DEVICE_MANAGER,
+                _microphone_name.c_str(),
+                sample_rate,
+                num_channels,
+                true
+        );
+    }
+
+    nlohmann::json settings = nlohmann::json::parse(CLIENT_SETTINGS);
+    settings["inputs"]["microphone"]["settings"]["deviceId"] =
+            _microphone_name;
+    settings["inputs"]["microphone"]["settings"]["customConstraints"]
+            ["echoCancellation"]["exact"] = _params->webrtc_echo_cancellation;
+    _client_settings = settings.dump();
+}
+
+void DailyTransport::release_devices() {
+    if (!_microphone) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(MICROPHONES_MUTEX);
+    MICROPHONES.push_back(
+            PooledMicrophone {
+                    .device = _microphone,
+                    .name = std::move(_microphone_name),
+                    .sample_rate = _params->user_audio_sample_rate,
+                    .num_channels = _params->user_audio_channels
+            }
+    );
+    _microphone = nullptr;
+}
+
+uint64_t DailyTransport::add_completion(
+        std::promise<void> completion,
+        const char* request
+) {
+    std::lock_guard<std::mutex> lock(_completions_mutex);
+
+    uint64_t request_id = _request_id++;
+
+    Completion& entry = _completions.try_emplace(request_id).first->second;
+    entry.promise = std::move(completion);
+    entry.request = request;
+
+    if (_params->request_timeout_ms > 0) {
+        DailyWatchdog::instance().arm(
+                &entry.timer, this, request_id, _params->request_timeout_ms
+        );
+    }
+
+    return request_id;
+}
+
+void DailyTransport::discard_completions() {
+    std::lock_guard<std::mutex> lock(_completions_mutex);
+
+    // Timers that already fired find nothing to fail.
+    for (auto& [request_id, completion] : _completions) {
+        DailyWatchdog::instance().cancel(&completion.timer);
+    }
+    _completions.clear();
+}
+
+void DailyTransport::resolve_completion(
+        uint64_t request_id,
+        const nlohmann::json& result
+) {
+    std::lock_guard<std::mutex> lock(_completions_mutex);
+
+    auto it = _completions.find(request_id);
+    if (it == _completions.end()) {
+        return;
+    }
+
+    DailyWatchdog::instance().cancel(&it->second.timer);
+
+    // daily-core serializes request results as `{"Ok": ...}` or
+    // `{"Err": ...}`.
+    if (result.is_object() && result.contains("Err")) {
+        it->second.promise.set_exception(std::make_exception_ptr(
+                RTVIException("request failed: " + result["Err"].dump())
+        ));
+    } else {
+        it->second.promise.set_value();
+    }
+
+    _completions.erase(it);
+}
+
+void DailyTransport::on_timer_expired(uint64_t request_id) {
+    std::string request;
+    {
+        std::lock_guard<std::mutex> lock(_completions_mutex);
+
+        auto it = _completions.find(request_id);
+        if (it == _completions.end()) {
+            return;
+        }
+
+        request = it->second.request;
+
+        it->second.promise.set_exception(std::make_exception_ptr(
+                RTVIException("request timed out: " + request)
+        ));
+
+        _completions.erase(it);
+    }
+
+    if (_params->callbacks) {
+        _params->callbacks->on_request_timeout(request);
+    }
+}
+
+void DailyTransport::join() {
+    DailyTraceSpan span(_trace_session, "join");
+
+    std::promise<void> join_promise;
+    std::future<void> join_future = join_promise.get_future();
+    uint64_t request_id = add_completion(std::move(join_promise), "join");
+    {
+        std::lock_guard<std::mutex> lock(_reconnect_mutex);
+        _left_since_join = false;
+    }
+    daily_core_call_client_join(
+            _client,
+            request_id,
+            _room_url.c_str(),
+            _token.c_str(),
+            _client_settings.c_str()
+    );
+    join_future.get();
+
+    // The events thread might have seen us leave (e.g. the network dropping
+    // again) before we got here.
+    std::lock_guard<std::mutex> lock(_reconnect_mutex);
+    _joined = !_left_since_join;
+}
+
+int32_t
+DailyTransport::write_user_audio(const int16_t* frames, size_t num_frames) {
+    int32_t written = daily_core_context_virtual_microphone_device_write_frames(
+            _microphone, frames, num_frames, _request_id++, nullptr, nullptr
+    );
+
+    if (_recorder && written > 0) {
+        _recorder->record_user_audio(frames, written);
+    }
+
+    if (_user_audio_meter && written > 0) {
+        DailyTransportCallbacks* callbacks = _params->callbacks;
+        if (_user_audio_meter->process(frames, written) && callbacks) {
+            bool speaking = _user_audio_meter->speaking();
+            post_callback([callbacks, speaking]() {
+                callbacks->on_user_speaking_changed(speaking);
+            });
+        }
+        report_audio_levels();
+    }
+
+    return written;
+}
+
+// Called from both audio paths, whichever gets past the next report time
+// first reports the levels of both.
+void DailyTransport::report_audio_levels() {
+    DailyTransportCallbacks* callbacks = _params->callbacks;
+    if (!callbacks || _params->audio_levels_interval_ms == 0) {
+        return;
+    }
+
+    auto elapsed = std::chrono::steady_clock::now().time_since_epoch();
+    uint64_t now =
+            std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed)
+                    .count();
+    uint64_t interval = _params->audio_levels_interval_ms * 1000000ull;
+
+    uint64_t next = _next_levels_ns.load(std::memory_order_relaxed);
+    if (now < next ||
+        !_next_levels_ns.compare_exchange_strong(next, now + interval)) {
+        return;
+    }
+
+    DailyAudioLevels user = _user_audio_meter->levels();
+    DailyAudioLevels bot = _bot_audio_meter->levels();
+    post_callback([callbacks, user, bot]() {
+        callbacks->on_audio_levels(user, bot);
+    });
+}
+
+void DailyTransport::post_callback(DailyCallbackDispatcher::Callback callback) {
+    if (_dispatcher) {
+        _dispatcher->post(std::move(callback));
+    } else {
+        callback();
+    }
+}
+
+void DailyTransport::on_call_state_updated(const std::string& state) {
+    if (state != "left") {
+        return;
+    }
+
+    // Everything happens with the lock held: senders waiting in
+    // `wait_until_joined()` either see we are still joined or that we are
+    // already reconnecting, and `disconnect()` either joins the reconnection
+    // thread or prevents it from starting.
+    {
+        std::lock_guard<std::mutex> lock(_reconnect_mutex);
+        _joined = false;
+        _left_since_join = true;
+
+        // While connecting, this is handled once connected.
+        if (_connected) {
+            start_reconnecting();
+        }
+    }
+    _reconnect_cv.notify_all();
+}
+
+void DailyTransport::start_reconnecting() {
+    // We only reconnect if we didn't ask to leave and the network was
+    // interrupted. Being ejected or the meeting ending also make us leave but
+    // rejoining would be wrong. An ongoing reconnection keeps trying until
+    // we are joined.
+    bool interrupted = _network_interrupted.exchange(false);
+
+    if (_params->auto_reconnect && interrupted && !_leaving &&
+        !_reconnecting) {
+        // The previous reconnection (if any) is already finished and doesn't
+        // need the lock anymore.
+        if (_reconnect_thread.joinable()) {
+            _reconnect_thread.join();
+        }
+
+        _reconnecting = true;
+        _reconnect_thread =
+                std::thread(&DailyTransport::reconnect_thread, this);
+    }
+}
+
+void DailyTransport::on_network_connection(const std::string& event) {
+    if (event == "interrupted") {
+        _network_interrupted = true;
+    } else if (event == "connected") {
+        _network_interrupted = false;
+    }
+}
+
+void DailyTransport::reconnect_thread() {
+    daily_configure_thread("daily-reconnect", _params->thread_config);
+
+    DailyTransportCallbacks* callbacks = _params->callbacks;
+
+    uint32_t backoff_ms = _params->reconnect_initial_backoff_ms;
+    bool joined = false;
+
+    for (uint32_t attempt = 1; attempt <= _params->reconnect_max_attempts;
+         ++attempt) {
+        if (_leaving) {
+            break;
+        }
+
+        if (callbacks) {
+            callbacks->on_reconnecting(attempt);
+        }
+
+        // We reuse the same call client, so subscription profiles and devices
+        // are still in place and a single join is all we need.
+        try {
+            join();
+        } catch (const RTVIException& ex) {
+        }
+
+        std::unique_lock<std::mutex> lock(_reconnect_mutex);
+
+        // We stop reconnecting with the lock held, so a drop right after
+        // rejoining either makes this attempt fail or starts a new
+        // reconnection.
+        if (_joined) {
+            joined = true;
+            _reconnecting = false;
+            break;
+        }
+
+        _reconnect_cv.wait_for(
+                lock, std::chrono::milliseconds(backoff_ms), [this] {
+                    return _leaving.load();
+                }
+        );
+
+        backoff_ms =
+                std::min(backoff_ms * 2, _params->reconnect_max_backoff_ms);
+    }
+
+    if (!joined) {
+        std::lock_guard<std::mutex> lock(_reconnect_mutex);
+        _reconnecting = false;
+    }
+    _reconnect_cv.notify_all();
+
+    if (callbacks && !_leaving) {
+        if (joined) {
+            callbacks->on_reconnected();
+        } else {
+            callbacks->on_reconnect_failed();
+        }
+    }
+}
+
+bool DailyTransport::wait_until_joined() {
+    std::unique_lock<std::mutex> lock(_reconnect_mutex);
+    _reconnect_cv.wait(lock, [this] {
+        return _joined || _leaving || !_reconnecting;
+    });
+    return _joined && !_leaving;
+}
+
+bool DailyTransport::wait_until_left() {
+    std::unique_lock<std::mutex> lock(_reconnect_mutex);
+    _reconnect_cv.wait_for(
+            lock,
+            std::chrono::milliseconds(_params->reconnect_initial_backoff_ms),
+            [this] { return !_joined || _leaving; }
+    );
+    return !_joined && !_leaving;
+}
+
+void DailyTransport::send_message_thread() {
+    daily_configure_thread("daily-messages", _params->thread_config);
+
+    bool running = true;
+    while (running) {
+        std::optional<std::string> data = _msg_queue.blocking_pop();
+        if (data.has_value()) {
+            // Keep (re)sending the message until it's acknowledged. If the
+            // call drops while the message is in flight it will be sent again
+            // once we rejoin.
+            bool sent = false;
+            while (!sent && wait_until_joined()) {
+                // From the message being sent until it's acknowledged.
+                DailyTraceSpan span(
+                        _trace_session, "send-app-message", data->size()
+                );
+                std::promise<void> msg_promise;
+                std::future<void> msg_future = msg_promise.get_future();
+                uint64_t request_id = add_completion(
+                        std::move(msg_promise), "send-app-message"
+                );
+                daily_core_call_client_send_app_message(
+                        _client, request_id, data->c_str(), nullptr
+                );
+                try {
+                    msg_future.get();
+                    sent = true;
+                } catch (const RTVIException& ex) {
+                    // Only retry if the failure was caused by the call
+                    // dropping, otherwise the message is discarded.
+                    if (!_params->auto_reconnect || !wait_until_left()) {
+                        break;
+                    }
+                }
+            }
+        } else {
+            running = false;
+        }
+    }
+}
+
+void DailyTransport::on_app_message(const nlohmann::json& event) {
+    if (!event.contains("msgData") || !event["msgData"].contains("label")) {
+        return;
+    }
+
+    const nlohmann::json& data = event["msgData"];
+    if (!data["label"].is_string()) {
+        return;
+    }
+
+    switch (MESSAGE_LABELS.find(data["label"].get_ref<const std::string&>())) {
+    case RTVI_MESSAGE:
+        deliver_message(data);
+        break;
+    case RTVI_MESSAGE_CHUNK: {
+        // Chunks are only expected by transports that send them.
+        if (_params->message_chunk_size == 0) {
+            break;
+        }
+
+        auto from = event.find("from");
+        std::optional<std::string> message = _message_assembler.add_chunk(
+                from != event.end() && from->is_string()
+                        ? from->get_ref<const std::string&>()
+                        : std::string(),
+                data
+        );
+        if (!message) {
+            break;
+        }
+
+        nlohmann::json parsed = nlohmann::json::parse(*message, nullptr, false);
+        if (!parsed.is_discarded() && parsed.is_object() &&
+            parsed.value("label", "") == "rtvi-ai") {
+            deliver_message(parsed);
+        }
+        break;
+    }
+    default:
+        break;
+    }
+}
+
+void DailyTransport::deliver_message(const nlohmann::json& message) {
+    if (_message_observer) {
+        if (_dispatcher) {
+            _dispatcher->post([this, message]() {
+                _message_observer->on_transport_message(message);
+            });
+        } else {
+            _message_observer->on_transport_message(message);
+        }
+    }
+
+    if (_message_handlers.empty() || !message.contains("type") ||
+        !message["type"].is_string()) {
+        return;
+    }
+
+    auto handler = _message_handlers.find(
+            message["type"].get_ref<const std::string&>()
+    );
+    if (handler != _message_handlers.end()) {
+        deliver(handler->second, message);
+    }
+}
+
+void DailyTransport::deliver(const Handler& handler, nlohmann::json data) {
+    if (_dispatcher) {
+        _dispatcher->post([&handler, data = std::move(data)]() {
+            handler(data);
+        });
+    } else {
+        handler(data);
+    }
+}
+
+void DailyTransport::update_bot_subscription(
+        const std::string& participant_id,
+        bool subscribed
+) {
+    nlohmann::json settings = {
+            {participant_id,
+             {{"media",
+               {{"microphone", subscribed ? "subscribed" : "unsubscribed"}}}}}
+    };
+    std::string settings_str = settings.dump();
+
+    // We are called from the events thread, which is also where completions
+    // are resolved, so we can't wait for this one.
+    uint64_t request_id =
+            add_completion(std::promise<void>(), "update-subscriptions");
+    daily_core_call_client_update_subscriptions(
+            _client, request_id, settings_str.c_str(), nullptr
+    );
+}
+
+uint64_t DailyTransport::add_audio_renderer(const std::string& participant_id) {
+    uint64_t renderer_id = _renderer_id++;
+
+    // We can't wait for the completion from the events thread.
+    uint64_t request_id = add_completion(
+            std::promise<void>(), "set-participant-audio-renderer"
+    );
+    daily_core_call_client_set_participant_audio_renderer(
+            _client,
+            request_id,
+            renderer_id,
+            participant_id.c_str(),
+            "microphone"
+    );
+
+    return renderer_id;
+}
+
+uint64_t
+DailyTransport::add_participant_audio(const std::string& participant_id) {
+    // The stream needs to be there before the renderer delivers any audio.
+    uint64_t renderer_id = _renderer_id;
+
+    {
+        std::lock_guard<std::mutex> lock(_participant_audio_mutex);
+        _participant_audio[renderer_id] =
+                std::make_shared<DailyParticipantAudioStream>(
+                        participant_id, PARTICIPANT_AUDIO_CAPACITY
+                );
+    }
+
+    return add_audio_renderer(participant_id);
+}
+
+void DailyTransport::remove_participant_audio(
+        const std::string& participant_id
+) {
+    std::lock_guard<std::mutex> lock(_participant_audio_mutex);
+
+    for (auto it = _participant_audio.begin(); it != _participant_audio.end();
+         ++it) {
+        if (it->second->participant_id() == participant_id) {
+            _participant_audio.erase(it);
+            break;
+        }
+    }
+}
+
+void DailyTransport::on_participant_joined(const nlohmann::json& participant) {
+    std::string participant_id = participant["id"].get<std::string>();
+
+    uint64_t renderer_id = 0;
+    if (_params->participant_audio_streams) {
+        renderer_id = add_participant_audio(participant_id);
+    }
+
+    // We assume the first remote participant is a bot.
+    {
+        std::lock_guard<std::mutex> lock(_bot_participant_mutex);
+        if (!_bot_participant_id.empty()) {
+            return;
+        }
+        _bot_participant_id = participant_id;
+    }
+
+    // The bot audio shares the participant stream renderer, if any.
+    if (renderer_id == 0) {
+        renderer_id = add_audio_renderer(participant_id);
+    }
+    _bot_renderer_id = renderer_id;
+
+    if (_params->subscribe_bot_only) {
+        update_bot_subscription(participant_id, true);
+    }
+
+    if (_callbacks) {
+        if (_dispatcher) {
+            _dispatcher->post([this, participant]() {
+                _callbacks->on_bot_connected(participant);
+            });
+        } else {
+            _callbacks->on_bot_connected(participant);
+        }
+    }
+}
+
+void DailyTransport::on_participant_updated(const nlohmann::json& participant) {
+    std::string participant_id = participant["id"].get<std::string>();
+    bool is_local = participant["info"]["isLocal"].get<bool>();
+
+    // We don't care about local updates, at least for now.
+    if (is_local) {
+        return;
+    }
+
+    // Let's make sure the updated participant is the bot one (we should have
+    // one if the update is non-local).
+    bool is_bot;
+    {
+        std::lock_guard<std::mutex> lock(_bot_participant_mutex);
+        is_bot = participant_id == _bot_participant_id;
+    }
+
+    if (is_bot) {
+        std::string mic_state =
+                participant["media"]["microphone"]["state"].get<std::string>();
+
+        if (mic_state == "playable") {
+            send_raw_message(
+                    _client_ready_message, DailyMessagePriority::Normal
+            );
+        }
+    }
+}
+
+void DailyTransport::on_participant_left(
         const nlohmann::json& participant,
         const std::string& reason
 ) {
-    if (_options.callbacks) {
-        _options.callbacks->on_bot_disconnected(participant, reason);
+    std::string participant_id = participant["id"].get<std::string>();
+
+    if (_params->participant_audio_streams) {
+        remove_participant_audio(participant_id);
+    }
+
+    bool was_bot;
+    {
+        std::lock_guard<std::mutex> lock(_bot_participant_mutex);
+        was_bot = participant_id == _bot_participant_id;
+        // When only subscribed to the bot, the next remote participant to
+        // join becomes the bot so we subscribe to it.
+        if (was_bot && _params->subscribe_bot_only) {
+            _bot_participant_id.clear();
+        }
+    }
+
+    if (was_bot) {
+        _bot_renderer_id = 0;
+
+        if (_params->subscribe_bot_only) {
+            update_bot_subscription(participant_id, false);
+        }
+    }
+
+    if (_callbacks) {
+        if (_dispatcher) {
+            _dispatcher->post([this, participant, reason]() {
+                _callbacks->on_bot_disconnected(participant, reason);
+            });
+        } else {
+            _callbacks->on_bot_disconnected(participant, reason);
+        }
     }
 }
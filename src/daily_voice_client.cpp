@@ -7,15 +7,28 @@
 using namespace rtvi;
 
 DailyVoiceClient::DailyVoiceClient(const RTVIClientOptions& options)
-    : RTVIClient(options, std::make_unique<DailyTransport>(options, this)) {}
+    : DailyVoiceClient(options, new DailyTransport(options, this)) {}
 
 DailyVoiceClient::DailyVoiceClient(
         const RTVIClientOptions& options,
         const DailyTransportParams& params
 )
-    : RTVIClient(
+    : DailyVoiceClient(options, new DailyTransport(options, params, this)) {}
+
+DailyVoiceClient::DailyVoiceClient(
+        const RTVIClientOptions& options,
+        std::shared_ptr<const DailyTransportParams> params
+)
+    : DailyVoiceClient(
               options,
-              std::make_unique<DailyTransport>(options, params, this)
+              new DailyTransport(options, std::move(params), this)
       ) {}
 
+DailyVoiceClient::DailyVoiceClient(
+        const RTVIClientOptions& options,
+        DailyTransport* transport
+)
+    : RTVIClient(options, std::unique_ptr<DailyTransport>(transport)),
+      _transport(transport) {}
+
 DailyVoiceClient::~DailyVoiceClient() {}
@@ -0,0 +1,165 @@
+//
+// Copyright (c) 2024, Daily
+//
+
+#include "daily_watchdog.h"
+
+#include "daily_thread.h"
+
+#include <utility>
+
+using namespace rtvi;
+
+static const uint32_t TICK_MS = 100;
+
+// Timers further than the wheel span (~25s) stay in their slot for more than
+// one turn.
+static const size_t WHEEL_SLOTS = 256;
+
+DailyWatchdog& DailyWatchdog::instance() {
+    static DailyWatchdog watchdog;
+    return watchdog;
+}
+
+DailyWatchdog::DailyWatchdog()
+    : _start(std::chrono::steady_clock::now()),
+      _slots(WHEEL_SLOTS),
+      _tick(0),
+      _num_armed(0),
+      _running(true),
+      _expiring(false) {
+    for (Timer& slot : _slots) {
+        slot.prev = &slot;
+        slot.next = &slot;
+    }
+
+    _thread = std::thread(&DailyWatchdog::watchdog_thread, this);
+}
+
+DailyWatchdog::~DailyWatchdog() {
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _running = false;
+    }
+    _cv.notify_one();
+
+    _thread.join();
+}
+
+void DailyWatchdog::arm(
+        Timer* timer,
+        Listener* listener,
+        uint64_t id,
+        uint32_t timeout_ms
+) {
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    if (timer->next) {
+        unlink(timer);
+    }
+
+    // Round up, so timers never expire early.
+    uint64_t ticks = (timeout_ms + TICK_MS - 1) / TICK_MS + 1;
+
+    timer->listener = listener;
+    timer->id = id;
+    timer->expires_tick = current_tick() + ticks;
+
+    Timer& slot = _slots[timer->expires_tick % WHEEL_SLOTS];
+    timer->prev = slot.prev;
+    timer->next = &slot;
+    slot.prev->next = timer;
+    slot.prev = timer;
+
+    // Wake up the watchdog thread if it was idle.
+    if (_num_armed++ == 0) {
+        _cv.notify_one();
+    }
+}
+
+void DailyWatchdog::cancel(Timer* timer) {
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    if (timer->next) {
+        unlink(timer);
+    }
+}
+
+void DailyWatchdog::synchronize() {
+    std::unique_lock<std::mutex> lock(_mutex);
+    _expire_cv.wait(lock, [this] { return !_expiring; });
+}
+
+// Private
+
+uint64_t DailyWatchdog::current_tick() const {
+    auto elapsed = std::chrono::steady_clock::now() - _start;
+    return std::chrono::duration_cast<std::chrono::milliseconds>(elapsed)
+                   .count() /
+           TICK_MS;
+}
+
+void DailyWatchdog::unlink(Timer* timer) {
+    timer->prev->next = timer->next;
+    timer->next->prev = timer->prev;
+    timer->prev = nullptr;
+    timer->next = nullptr;
+    _num_armed--;
+}
+
+void DailyWatchdog::watchdog_thread() {
+    daily_configure_thread("daily-watchdog", DailyThreadConfig());
+
+    std::vector<std::pair<Listener*, uint64_t>> expired;
+
+    std::unique_lock<std::mutex> lock(_mutex);
+
+    while (_running) {
+        if (_num_armed == 0) {
+            _cv.wait(lock, [this] { return _num_armed > 0 || !_running; });
+            // Nothing was armed in the ticks we slept through.
+            _tick = current_tick();
+            continue;
+        }
+
+        auto next_tick = _start + std::chrono::milliseconds(TICK_MS) *
+                                          static_cast<int64_t>(_tick + 1);
+        if (_cv.wait_until(lock, next_tick, [this] { return !_running; })) {
+            break;
+        }
+
+        uint64_t now = current_tick();
+
+        // Catch up with any ticks we missed.
+        for (; _tick < now; ++_tick) {
+            Timer& slot = _slots[(_tick + 1) % WHEEL_SLOTS];
+            Timer* timer = slot.next;
+            while (timer != &slot) {
+                Timer* next = timer->next;
+                if (timer->expires_tick <= _tick + 1) {
+                    expired.emplace_back(timer->listener, timer->id);
+                    unlink(timer);
+                }
+                timer = next;
+            }
+        }
+
+        if (expired.empty()) {
+            continue;
+        }
+
+        // Listeners can't be destroyed until we are done with them (see
+        // `synchronize()`).
+        _expiring = true;
+
+        lock.unlock();
+        for (auto& [listener, id] : expired) {
+            listener->on_timer_expired(id);
+        }
+        expired.clear();
+        lock.lock();
+
+        _expiring = false;
+        _expire_cv.notify_all();
+    }
+}
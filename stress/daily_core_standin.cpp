@@ -0,0 +1,603 @@
+//
+// Copyright (c) 2024, Daily
+//
+
+#include "daily_core_standin.h"
+
+extern "C" {
+#include "daily_core.h"
+}
+
+#include <nlohmann/json.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+// Participant audio is delivered in 10ms blocks, like decoded Opus.
+static const uint32_t AUDIO_SAMPLE_RATE = 48000;
+static const size_t AUDIO_BLOCK_FRAMES = AUDIO_SAMPLE_RATE / 100;
+static const auto AUDIO_BLOCK = std::chrono::milliseconds(10);
+
+static const double PI = 3.14159265358979323846;
+
+static const char* BOT_ID = "bot";
+
+static std::mutex CONFIG_MUTEX;
+static DailyCoreStandinConfig CONFIG;
+
+static std::atomic<uint64_t> JOINS {0};
+static std::atomic<uint64_t> NETWORK_DROPS {0};
+static std::atomic<uint64_t> APP_MESSAGES {0};
+static std::atomic<uint64_t> RECEIVED_FRAMES {0};
+static std::atomic<uint64_t> RENDERED_FRAMES {0};
+
+namespace {
+
+// A virtual microphone or speaker. daily-core has no API to destroy them, so
+// they live as long as the process.
+struct VirtualDevice {
+    std::string name;
+    uint32_t sample_rate;
+    uint32_t num_channels;
+};
+
+class CallClient {
+   public:
+    CallClient();
+    ~CallClient();
+
+    void set_delegate(DailyCallClientDelegate delegate);
+
+    void update_subscription_profiles(uint64_t request_id, const char* json);
+    void update_subscriptions(uint64_t request_id, const char* json);
+    void set_audio_renderer(
+            uint64_t request_id,
+            uint64_t renderer_id,
+            const char* participant_id
+    );
+
+    void join(uint64_t request_id);
+    void leave(uint64_t request_id);
+    void send_app_message(uint64_t request_id);
+
+    // Events are still delivered for a while after this.
+    void destroy();
+
+    bool finished() const { return _finished; }
+
+   private:
+    // The methods below need `_mutex` to be held.
+    void post(std::string event);
+    void complete(uint64_t request_id, const char* error = nullptr);
+    void post_participant(const char* action, const std::string& id);
+    void tick(std::unique_lock<std::mutex>& lock);
+
+    void run();
+
+    const DailyCoreStandinConfig _config;
+
+    DailyCallClientDelegate _delegate;
+    std::thread _thread;
+    std::atomic<bool> _finished;
+
+    std::mutex _mutex;
+    std::condition_variable _cv;
+    std::deque<std::string> _events;
+    bool _destroyed;
+    Clock::time_point _destroyed_at;
+
+    bool _joined;
+    bool _interrupted;
+    std::vector<std::string> _participants;
+    bool _subscribe_all;
+    std::set<std::string> _subscribed;
+    // Renderer ids by participant.
+    std::multimap<std::string, uint64_t> _renderers;
+
+    std::mt19937 _random;
+    std::vector<int16_t> _tone;
+};
+
+}  // namespace
+
+static std::mutex DEVICES_MUTEX;
+static std::vector<std::unique_ptr<VirtualDevice>> DEVICES;
+
+// Call clients that have been destroyed, until their thread finishes.
+static std::mutex DESTROYED_MUTEX;
+static std::vector<std::unique_ptr<CallClient>> DESTROYED;
+
+static void reap_destroyed(bool wait) {
+    std::vector<std::unique_ptr<CallClient>> finished;
+    {
+        std::lock_guard<std::mutex> lock(DESTROYED_MUTEX);
+        auto it = DESTROYED.begin();
+        while (it != DESTROYED.end()) {
+            if (wait || (*it)->finished()) {
+                finished.push_back(std::move(*it));
+                it = DESTROYED.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+    // Joins their threads.
+    finished.clear();
+}
+
+static VirtualDevice* create_device(
+        const char* name,
+        uint32_t sample_rate,
+        uint32_t num_channels
+) {
+    std::lock_guard<std::mutex> lock(DEVICES_MUTEX);
+    DEVICES.push_back(std::make_unique<VirtualDevice>(
+            VirtualDevice {
+                    .name = name,
+                    .sample_rate = sample_rate,
+                    .num_channels = num_channels
+            }
+    ));
+    return DEVICES.back().get();
+}
+
+static CallClient* call_client(DailyRawCallClient* client) {
+    return reinterpret_cast<CallClient*>(client);
+}
+
+//
+// CallClient
+//
+
+CallClient::CallClient()
+    : _config([] {
+          std::lock_guard<std::mutex> lock(CONFIG_MUTEX);
+          return CONFIG;
+      }()),
+      _delegate(),
+      _finished(false),
+      _destroyed(false),
+      _joined(false),
+      _interrupted(false),
+      _subscribe_all(true),
+      _random(std::random_device {}()),
+      _tone(AUDIO_BLOCK_FRAMES) {
+    _participants.push_back(BOT_ID);
+    for (uint32_t i = 0; i < _config.participants; ++i) {
+        _participants.push_back("participant-" + std::to_string(i));
+    }
+
+    // A whole number of periods, so blocks can be repeated.
+    for (size_t i = 0; i < _tone.size(); ++i) {
+        double phase = 2.0 * PI * 400.0 * i / AUDIO_SAMPLE_RATE;
+        _tone[i] = static_cast<int16_t>(8000.0 * std::sin(phase));
+    }
+}
+
+CallClient::~CallClient() {
+    if (_thread.joinable()) {
+        _thread.join();
+    }
+}
+
+void CallClient::set_delegate(DailyCallClientDelegate delegate) {
+    _delegate = delegate;
+    _thread = std::thread(&CallClient::run, this);
+}
+
+void CallClient::update_subscription_profiles(
+        uint64_t request_id,
+        const char* json
+) {
+    nlohmann::json profiles = nlohmann::json::parse(json);
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    _subscribe_all =
+            profiles["base"].value("microphone", "subscribed") == "subscribed";
+    complete(request_id);
+}
+
+void CallClient::update_subscriptions(uint64_t request_id, const char* json) {
+    nlohmann::json participants = nlohmann::json::parse(json);
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    for (const auto& [id, settings] : participants.items()) {
+        std::string microphone = settings["media"].value("microphone", "");
+        if (microphone == "subscribed") {
+            _subscribed.insert(id);
+        } else if (microphone == "unsubscribed") {
+            _subscribed.erase(id);
+        }
+    }
+    complete(request_id);
+}
+
+void CallClient::set_audio_renderer(
+        uint64_t request_id,
+        uint64_t renderer_id,
+        const char* participant_id
+) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _renderers.emplace(participant_id, renderer_id);
+    complete(request_id);
+}
+
+void CallClient::join(uint64_t request_id) {
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    JOINS++;
+
+    if (_interrupted) {
+        _interrupted = false;
+        post(R"({"action":"network-connection","event":"connected"})");
+    }
+    post(R"({"action":"call-state-updated","state":"joined"})");
+    complete(request_id);
+
+    // Participants are already there after rejoining.
+    if (_joined) {
+        return;
+    }
+    _joined = true;
+
+    for (const std::string& id : _participants) {
+        post_participant("participant-joined", id);
+    }
+    // The bot is ready once its microphone is playable.
+    post_participant("participant-updated", BOT_ID);
+}
+
+void CallClient::leave(uint64_t request_id) {
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    post(R"({"action":"call-state-updated","state":"left"})");
+    complete(request_id);
+
+    if (_joined) {
+        for (const std::string& id : _participants) {
+            post_participant("participant-left", id);
+        }
+    }
+    _joined = false;
+    _interrupted = false;
+    _renderers.clear();
+}
+
+void CallClient::send_app_message(uint64_t request_id) {
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    if (_joined && !_interrupted) {
+        APP_MESSAGES++;
+        complete(request_id);
+    } else {
+        complete(request_id, "not joined");
+    }
+}
+
+void CallClient::destroy() {
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _destroyed = true;
+        _destroyed_at = Clock::now();
+    }
+    _cv.notify_one();
+}
+
+// Private
+
+void CallClient::post(std::string event) {
+    _events.push_back(std::move(event));
+    _cv.notify_one();
+}
+
+void CallClient::complete(uint64_t request_id, const char* error) {
+    nlohmann::json event = {
+            {"action", "request-completed"},
+            {"requestId", {{"id", request_id}}},
+            {"result", error ? nlohmann::json {{"Err", error}}
+                             : nlohmann::json {{"Ok", nullptr}}}
+    };
+    post(event.dump());
+}
+
+void CallClient::post_participant(const char* action, const std::string& id) {
+    nlohmann::json event = {
+            {"action", action},
+            {"participant",
+             {{"id", id},
+              {"info", {{"isLocal", false}, {"userName", id}}},
+              {"media", {{"microphone", {{"state", "playable"}}}}}}}
+    };
+    if (std::string(action) == "participant-left") {
+        event["leftReason"] = "leftCall";
+    }
+    post(event.dump());
+}
+
+// Runs every 10ms while joined: network drops, noise events and audio.
+void CallClient::tick(std::unique_lock<std::mutex>& lock) {
+    if (!_joined || _interrupted) {
+        return;
+    }
+
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+    double drop_probability = _config.network_drops_per_second / 100.0;
+    if (!_destroyed && uniform(_random) < drop_probability) {
+        NETWORK_DROPS++;
+        _interrupted = true;
+        post(R"({"action":"network-connection","event":"interrupted"})");
+        post(R"({"action":"call-state-updated","state":"left"})");
+        return;
+    }
+
+    // Participants are updated all the time (e.g. network quality).
+    if (_random() % 50 == 0) {
+        post_participant("participant-updated", BOT_ID);
+    }
+
+    std::vector<std::pair<uint64_t, std::string>> deliveries;
+    for (const std::string& id : _participants) {
+        if (!_subscribe_all && _subscribed.count(id) == 0) {
+            continue;
+        }
+        RECEIVED_FRAMES += AUDIO_BLOCK_FRAMES;
+        auto range = _renderers.equal_range(id);
+        for (auto it = range.first; it != range.second; ++it) {
+            deliveries.emplace_back(it->second, id);
+        }
+    }
+
+    NativeAudioData audio;
+    audio.bits_per_sample = 16;
+    audio.sample_rate = AUDIO_SAMPLE_RATE;
+    audio.num_channels = 1;
+    audio.num_audio_frames = AUDIO_BLOCK_FRAMES;
+    audio.audio_frames =
+            reinterpret_cast<decltype(audio.audio_frames)>(_tone.data());
+
+    lock.unlock();
+    for (const auto& [renderer_id, id] : deliveries) {
+        _delegate.fns.on_audio_data(
+                _delegate.ptr, renderer_id, id.c_str(), &audio
+        );
+        RENDERED_FRAMES += AUDIO_BLOCK_FRAMES;
+    }
+    lock.lock();
+}
+
+void CallClient::run() {
+    auto late_events = std::chrono::milliseconds(_config.late_events_ms);
+
+    std::unique_lock<std::mutex> lock(_mutex);
+
+    Clock::time_point next_tick = Clock::now() + AUDIO_BLOCK;
+    for (;;) {
+        Clock::time_point now = Clock::now();
+
+        Clock::time_point deadline = next_tick;
+        if (_destroyed) {
+            if (now >= _destroyed_at + late_events) {
+                break;
+            }
+            deadline = std::min(deadline, _destroyed_at + late_events);
+        }
+
+        if (!_events.empty()) {
+            std::string event = std::move(_events.front());
+            _events.pop_front();
+
+            uint32_t delay_us = _random() % (_config.max_event_delay_us + 1);
+
+            lock.unlock();
+            std::this_thread::sleep_for(std::chrono::microseconds(delay_us));
+            _delegate.fns.on_event(_delegate.ptr, event.c_str(), event.size());
+            lock.lock();
+        } else if (now >= next_tick) {
+            // Don't catch up after falling far behind.
+            next_tick = std::max(next_tick + AUDIO_BLOCK, now);
+            tick(lock);
+        } else {
+            _cv.wait_until(lock, deadline);
+        }
+    }
+
+    _finished = true;
+}
+
+//
+// daily-core API
+//
+
+void daily_core_set_log_level(DailyLogLevel level) {}
+
+NativeDeviceManager* daily_core_context_create_device_manager() {
+    static VirtualDevice device_manager;
+    return reinterpret_cast<NativeDeviceManager*>(&device_manager);
+}
+
+void* daily_core_context_create(
+        DailyContextDelegate driver,
+        DailyWebRtcContextDelegate webrtc,
+        DailyAboutClient about
+) {
+    return nullptr;
+}
+
+DailyVirtualSpeakerDevice* daily_core_context_create_virtual_speaker_device(
+        NativeDeviceManager* device_manager,
+        const char* name,
+        uint32_t sample_rate,
+        uint32_t num_channels,
+        bool non_blocking
+) {
+    return reinterpret_cast<DailyVirtualSpeakerDevice*>(
+            create_device(name, sample_rate, num_channels)
+    );
+}
+
+DailyVirtualMicrophoneDevice*
+daily_core_context_create_virtual_microphone_device(
+        NativeDeviceManager* device_manager,
+        const char* name,
+        uint32_t sample_rate,
+        uint32_t num_channels,
+        bool non_blocking
+) {
+    return reinterpret_cast<DailyVirtualMicrophoneDevice*>(
+            create_device(name, sample_rate, num_channels)
+    );
+}
+
+void daily_core_context_select_speaker_device(
+        NativeDeviceManager* device_manager,
+        const char* name
+) {}
+
+// Non-blocking, all the frames are taken.
+int32_t daily_core_context_virtual_microphone_device_write_frames(
+        DailyVirtualMicrophoneDevice* device,
+        const int16_t* frames,
+        size_t num_frames,
+        uint64_t request_id,
+        void* completion,
+        void* completion_data
+) {
+    return static_cast<int32_t>(num_frames);
+}
+
+// Only called by WebRTC, which the stand-in doesn't have.
+WebrtcAudioDeviceModule* daily_core_context_create_audio_device_module(
+        NativeDeviceManager* device_manager,
+        WebrtcTaskQueueFactory* task_queue_factory
+) {
+    return nullptr;
+}
+
+char* daily_core_context_device_manager_enumerated_devices(
+        NativeDeviceManager* device_manager
+) {
+    return nullptr;
+}
+
+void* daily_core_context_device_manager_get_user_media(
+        NativeDeviceManager* device_manager,
+        WebrtcPeerConnectionFactory* peer_connection_factory,
+        WebrtcThread* signaling_thread,
+        WebrtcThread* worker_thread,
+        WebrtcThread* network_thread,
+        const char* constraints
+) {
+    return nullptr;
+}
+
+DailyRawCallClient* daily_core_call_client_create() {
+    // Good time to release finished call clients.
+    reap_destroyed(false);
+    return reinterpret_cast<DailyRawCallClient*>(new CallClient());
+}
+
+void daily_core_call_client_set_delegate(
+        DailyRawCallClient* client,
+        DailyCallClientDelegate delegate
+) {
+    call_client(client)->set_delegate(delegate);
+}
+
+void daily_core_call_client_update_subscription_profiles(
+        DailyRawCallClient* client,
+        uint64_t request_id,
+        const char* profiles
+) {
+    call_client(client)->update_subscription_profiles(request_id, profiles);
+}
+
+void daily_core_call_client_update_subscriptions(
+        DailyRawCallClient* client,
+        uint64_t request_id,
+        const char* participants,
+        const char* profiles
+) {
+    call_client(client)->update_subscriptions(request_id, participants);
+}
+
+void daily_core_call_client_set_participant_audio_renderer(
+        DailyRawCallClient* client,
+        uint64_t request_id,
+        uint64_t renderer_id,
+        const char* participant_id,
+        const char* media
+) {
+    call_client(client)->set_audio_renderer(
+            request_id, renderer_id, participant_id
+    );
+}
+
+void daily_core_call_client_join(
+        DailyRawCallClient* client,
+        uint64_t request_id,
+        const char* url,
+        const char* token,
+        const char* settings
+) {
+    call_client(client)->join(request_id);
+}
+
+void daily_core_call_client_leave(
+        DailyRawCallClient* client,
+        uint64_t request_id
+) {
+    call_client(client)->leave(request_id);
+}
+
+void daily_core_call_client_send_app_message(
+        DailyRawCallClient* client,
+        uint64_t request_id,
+        const char* message,
+        const char* recipient
+) {
+    call_client(client)->send_app_message(request_id);
+}
+
+void daily_core_call_client_destroy(DailyRawCallClient* client) {
+    CallClient* call = call_client(client);
+    call->destroy();
+
+    std::lock_guard<std::mutex> lock(DESTROYED_MUTEX);
+    DESTROYED.emplace_back(call);
+}
+
+//
+// Stand-in API
+//
+
+void daily_core_standin_configure(const DailyCoreStandinConfig& config) {
+    std::lock_guard<std::mutex> lock(CONFIG_MUTEX);
+    CONFIG = config;
+}
+
+DailyCoreStandinStats daily_core_standin_stats() {
+    return DailyCoreStandinStats {
+            .joins = JOINS,
+            .network_drops = NETWORK_DROPS,
+            .app_messages = APP_MESSAGES,
+            .received_frames = RECEIVED_FRAMES,
+            .rendered_frames = RENDERED_FRAMES
+    };
+}
+
+void daily_core_standin_wait() {
+    reap_destroyed(true);
+}
@@ -0,0 +1,52 @@
+//
+// Copyright (c) 2024, Daily
+//
+
+#ifndef DAILY_CORE_STANDIN_H
+#define DAILY_CORE_STANDIN_H
+
+#include <cstdint>
+
+// In-process stand-in for the part of daily-core's C API used by the
+// transport, so the transport can be stressed (e.g. under ThreadSanitizer) and
+// measured without a Daily room.
+//
+// Like daily-core, every call client delivers events, request completions and
+// participant audio from its own thread, with random delays, and keeps
+// delivering them for a little while after being destroyed. Joining announces
+// a bot and the configured remote participants. Audio of subscribed
+// microphones is received every 10ms and delivered to their renderers.
+
+struct DailyCoreStandinConfig {
+    // Remote participants in the call besides the bot, which joins first.
+    uint32_t participants = 0;
+    // Average unexpected network drops per joined call client and second.
+    // The call is left and needs to be rejoined.
+    double network_drops_per_second = 0.0;
+    // Events and completions are delayed by up to this much.
+    uint32_t max_event_delay_us = 300;
+    // How long destroyed call clients keep delivering events.
+    uint32_t late_events_ms = 5;
+};
+
+struct DailyCoreStandinStats {
+    uint64_t joins;
+    uint64_t network_drops;
+    uint64_t app_messages;
+    // Frames of remote audio received from subscribed microphones, which
+    // daily-core would decode whether they are rendered or not.
+    uint64_t received_frames;
+    // Frames delivered to audio renderers.
+    uint64_t rendered_frames;
+};
+
+// Applies to call clients created afterwards.
+void daily_core_standin_configure(const DailyCoreStandinConfig& config);
+
+DailyCoreStandinStats daily_core_standin_stats();
+
+// Waits until destroyed call clients stop delivering events, so their
+// delegates (i.e. transports) can be destroyed.
+void daily_core_standin_wait();
+
+#endif
@@ -0,0 +1,426 @@
+//
+// Copyright (c) 2024, Daily
+//
+
+#include "daily_core_standin.h"
+#include "daily_rtvi.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <thread>
+#include <vector>
+
+// Storms of connections, disconnections, network drops, messages and audio
+// against the daily-core stand-in, so the transport's threads interleave in
+// as many ways as possible. Meant to be built with DAILY_PIPECAT_TSAN.
+
+using Clock = std::chrono::steady_clock;
+
+static const uint32_t SAMPLE_RATE = 16000;
+static const size_t BLOCK_FRAMES = SAMPLE_RATE / 100;
+
+struct StressOptions {
+    uint32_t num_transports;
+    uint32_t duration_s;
+    // Connections are held for up to this long.
+    uint32_t hold_ms;
+    // Network drops per connected transport and second.
+    double network_drops;
+    // Remote participants besides the bot when comparing subscriptions.
+    uint32_t participants;
+};
+
+struct StressStats {
+    std::atomic<uint64_t> connects {0};
+    std::atomic<uint64_t> connect_errors {0};
+    std::atomic<uint64_t> disconnects {0};
+    std::atomic<uint64_t> messages {0};
+    std::atomic<uint64_t> reconnecting {0};
+    std::atomic<uint64_t> reconnected {0};
+    std::atomic<uint64_t> reconnect_failed {0};
+    std::atomic<uint64_t> request_timeouts {0};
+    std::atomic<uint64_t> bot_audio_frames {0};
+};
+
+static double elapsed_us(Clock::time_point start) {
+    std::chrono::duration<double, std::micro> elapsed = Clock::now() - start;
+    return elapsed.count();
+}
+
+static double percentile(std::vector<double> values, double p) {
+    if (values.empty()) {
+        return 0;
+    }
+    std::sort(values.begin(), values.end());
+    return values[static_cast<size_t>(p * (values.size() - 1))];
+}
+
+class StressCallbacks : public rtvi::DailyTransportCallbacks {
+   public:
+    explicit StressCallbacks(StressStats& stats) : _stats(stats) {}
+
+    void on_reconnecting(uint32_t attempt) override { _stats.reconnecting++; }
+
+    void on_reconnected() override { _stats.reconnected++; }
+
+    void on_reconnect_failed() override { _stats.reconnect_failed++; }
+
+    void on_request_timeout(const std::string& request) override {
+        _stats.request_timeouts++;
+    }
+
+   private:
+    StressStats& _stats;
+};
+
+// Each transport gets a different mix of features, so all of their threads
+// take part.
+static rtvi::DailyTransportParams
+transport_params(uint32_t index, rtvi::DailyTransportCallbacks* callbacks) {
+    rtvi::DailyTransportParams params = {
+            .user_audio_sample_rate = SAMPLE_RATE,
+            .user_audio_channels = 1,
+            .bot_audio_sample_rate = SAMPLE_RATE,
+            .bot_audio_channels = 1,
+            .auto_reconnect = true,
+            .reconnect_max_attempts = 3,
+            .reconnect_initial_backoff_ms = 5,
+            .reconnect_max_backoff_ms = 20,
+    };
+    params.subscribe_bot_only = index % 2 == 1;
+    params.participant_audio_streams = index % 3 == 0;
+    params.paced_user_audio = index % 4 == 1;
+    params.user_audio_processing = index % 4 == 2;
+    params.audio_levels = true;
+    params.dispatch_callbacks = index % 2 == 0;
+    params.request_timeout_ms = 2000;
+    params.prioritize_messages = index % 2 == 1;
+    params.message_chunk_size = 256;
+    params.max_queued_message_bytes = 64 * 1024;
+    params.callbacks = callbacks;
+    return params;
+}
+
+static nlohmann::json connection_info() {
+    return {{"room_url", "https://standin.daily.co/stress"},
+            {"token", "token"}};
+}
+
+static std::unique_ptr<rtvi::DailyTransport>
+create_transport(const rtvi::DailyTransportParams& params) {
+    rtvi::RTVIClientOptions options {};
+    auto transport =
+            std::make_unique<rtvi::DailyTransport>(options, params, nullptr);
+    transport->initialize();
+    return transport;
+}
+
+// Time to initialize daily-core and to connect, without event delays, which
+// is the overhead of the transport itself.
+static void measure_startup() {
+    DailyCoreStandinConfig config;
+    config.max_event_delay_us = 0;
+    daily_core_standin_configure(config);
+
+    auto start = Clock::now();
+    rtvi::DailyTransport::warm_up();
+    double warm_up_us = elapsed_us(start);
+
+    rtvi::DailyTransportParams params = transport_params(0, nullptr);
+    params.auto_reconnect = false;
+    auto transport = create_transport(params);
+
+    std::vector<double> connect_us;
+    std::vector<double> disconnect_us;
+    for (int i = 0; i < 50; ++i) {
+        start = Clock::now();
+        transport->connect(connection_info());
+        connect_us.push_back(elapsed_us(start));
+
+        start = Clock::now();
+        transport->disconnect();
+        disconnect_us.push_back(elapsed_us(start));
+    }
+    daily_core_standin_wait();
+
+    std::cout << std::fixed << std::setprecision(0);
+    std::cout << "startup" << std::endl;
+    std::cout << "  warm_up         " << warm_up_us << " us" << std::endl;
+    std::cout << "  connect         p50 " << percentile(connect_us, 0.5)
+              << " us, max " << percentile(connect_us, 1.0) << " us"
+              << std::endl;
+    std::cout << "  disconnect      p50 " << percentile(disconnect_us, 0.5)
+              << " us, max " << percentile(disconnect_us, 1.0) << " us"
+              << std::endl;
+}
+
+// Remote audio received (i.e. decoded by daily-core) with and without
+// `subscribe_bot_only`, with other participants in the call.
+static void measure_subscriptions(uint32_t participants) {
+    DailyCoreStandinConfig config;
+    config.participants = participants;
+    daily_core_standin_configure(config);
+
+    std::cout << std::fixed << std::setprecision(0);
+    std::cout << "subscriptions (bot and " << participants
+              << " participants)" << std::endl;
+
+    for (bool bot_only : {false, true}) {
+        rtvi::DailyTransportParams params = transport_params(0, nullptr);
+        params.subscribe_bot_only = bot_only;
+        auto transport = create_transport(params);
+        transport->connect(connection_info());
+
+        // Subscriptions are updated once the bot joins.
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+        uint64_t received = daily_core_standin_stats().received_frames;
+        auto start = Clock::now();
+        std::this_thread::sleep_for(std::chrono::seconds(1));
+        received = daily_core_standin_stats().received_frames - received;
+        double seconds = elapsed_us(start) / 1e6;
+
+        transport->disconnect();
+        daily_core_standin_wait();
+
+        std::cout << (bot_only ? "  bot only        " : "  all             ")
+                  << received / seconds << " frames/s received" << std::endl;
+    }
+}
+
+static void connect_thread(
+        rtvi::DailyTransport* transport,
+        const StressOptions& options,
+        const std::atomic<bool>& running,
+        StressStats& stats,
+        uint32_t seed
+) {
+    std::mt19937 random(seed);
+    while (running) {
+        try {
+            transport->connect(connection_info());
+            stats.connects++;
+        } catch (const std::exception& ex) {
+            stats.connect_errors++;
+        }
+
+        std::this_thread::sleep_for(
+                std::chrono::microseconds(random() % (options.hold_ms * 1000))
+        );
+
+        transport->disconnect();
+        stats.disconnects++;
+    }
+}
+
+// Sends messages whether connected or not, some large enough to be chunked.
+static void message_thread(
+        rtvi::DailyTransport* transport,
+        const std::atomic<bool>& running,
+        StressStats& stats,
+        uint32_t seed
+) {
+    std::mt19937 random(seed);
+    while (running) {
+        nlohmann::json message = {
+                {"label", "rtvi-ai"},
+                {"type", "action"},
+                {"data", {{"text", std::string(random() % 1024, 'x')}}}
+        };
+        switch (random() % 3) {
+        case 0:
+            transport->send_message(message);
+            break;
+        case 1:
+            transport->send_message(
+                    message,
+                    rtvi::DailyMessagePriority(
+                            random() % rtvi::DAILY_MESSAGE_PRIORITIES
+                    )
+            );
+            break;
+        default:
+            transport->send_raw_message(
+                    message.dump(), rtvi::DailyMessagePriority::Normal
+            );
+            break;
+        }
+        stats.messages++;
+
+        transport->message_lane_stats(rtvi::DailyMessagePriority::Normal);
+        transport->memory_report();
+
+        std::this_thread::sleep_for(
+                std::chrono::microseconds(random() % 2000)
+        );
+    }
+}
+
+// Sends and reads audio every 10ms, whether connected or not.
+static void audio_thread(
+        rtvi::DailyTransport* transport,
+        const std::atomic<bool>& running,
+        StressStats& stats
+) {
+    const rtvi::DailyTransportParams& params = transport->params();
+
+    std::vector<int16_t> user(BLOCK_FRAMES, 1000);
+    std::vector<int16_t> bot(BLOCK_FRAMES);
+    while (running) {
+        if (params.paced_user_audio) {
+            transport->queue_user_audio(user.data(), BLOCK_FRAMES);
+        } else {
+            transport->send_user_audio(user.data(), BLOCK_FRAMES);
+        }
+
+        rtvi::DailyBotAudioChunk chunk =
+                transport->read_bot_audio_chunk(bot.data(), BLOCK_FRAMES);
+        if (chunk.num_frames > 0) {
+            stats.bot_audio_frames += chunk.num_frames;
+        } else {
+            // Not connected.
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+
+        for (const std::string& id : transport->participant_audio_ids()) {
+            if (auto stream = transport->participant_audio(id)) {
+                stream->read(bot.data(), BLOCK_FRAMES);
+            }
+        }
+
+        transport->user_audio_levels();
+        transport->bot_audio_levels();
+    }
+}
+
+static bool run_storm(const StressOptions& options) {
+    DailyCoreStandinConfig config;
+    config.participants = 2;
+    config.network_drops_per_second = options.network_drops;
+    daily_core_standin_configure(config);
+
+    StressStats stats;
+    StressCallbacks callbacks(stats);
+
+    std::vector<std::unique_ptr<rtvi::DailyTransport>> transports;
+    for (uint32_t i = 0; i < options.num_transports; ++i) {
+        transports.push_back(create_transport(transport_params(i, &callbacks))
+        );
+    }
+
+    std::atomic<bool> running {true};
+    std::vector<std::thread> threads;
+    for (uint32_t i = 0; i < options.num_transports; ++i) {
+        rtvi::DailyTransport* transport = transports[i].get();
+        // Connections race with each other too.
+        for (uint32_t k = 0; k < 2; ++k) {
+            threads.emplace_back(
+                    connect_thread,
+                    transport,
+                    std::cref(options),
+                    std::cref(running),
+                    std::ref(stats),
+                    i * 2 + k
+            );
+        }
+        threads.emplace_back(
+                message_thread, transport, std::cref(running), std::ref(stats),
+                i
+        );
+        threads.emplace_back(
+                audio_thread, transport, std::cref(running), std::ref(stats)
+        );
+    }
+
+    std::this_thread::sleep_for(std::chrono::seconds(options.duration_s));
+
+    running = false;
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    for (auto& transport : transports) {
+        transport->disconnect();
+    }
+
+    // Late events need to find their transport.
+    daily_core_standin_wait();
+    transports.clear();
+
+    DailyCoreStandinStats standin = daily_core_standin_stats();
+    double seconds = options.duration_s;
+
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << "storm (" << options.num_transports << " transports, "
+              << options.duration_s << " s)" << std::endl;
+    std::cout << "  connections     " << stats.connects / seconds << " /s ("
+              << stats.connect_errors << " failed)" << std::endl;
+    std::cout << "  network drops   " << standin.network_drops << " ("
+              << stats.reconnecting << " attempts, " << stats.reconnected
+              << " reconnected, " << stats.reconnect_failed << " failed)"
+              << std::endl;
+    std::cout << "  messages        " << stats.messages / seconds
+              << " /s queued, " << standin.app_messages / seconds
+              << " /s sent (chunks)" << std::endl;
+    std::cout << "  bot audio       " << stats.bot_audio_frames / seconds
+              << " frames/s" << std::endl;
+    std::cout << "  timeouts        " << stats.request_timeouts << std::endl;
+
+    // Every kind of storm needs to have happened.
+    bool ok = stats.connects > 0 && standin.app_messages > 0;
+    if (options.network_drops > 0) {
+        ok = ok && stats.reconnected > 0;
+    }
+    return ok;
+}
+
+static void usage() {
+    std::cout << "Usage: daily_pipecat_stress [OPTIONS]" << std::endl;
+    std::cout << "  -n    Number of transports (default: 4)" << std::endl;
+    std::cout << "  -d    Duration in seconds (default: 10)" << std::endl;
+    std::cout << "  -H    Hold connections up to N ms (default: 200)"
+              << std::endl;
+    std::cout << "  -D    Network drops per transport and second (default: 2)"
+              << std::endl;
+    std::cout << "  -p    Participants besides the bot when comparing "
+                 "subscriptions (default: 4)"
+              << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    StressOptions options = {
+            .num_transports = 4,
+            .duration_s = 10,
+            .hold_ms = 200,
+            .network_drops = 2.0,
+            .participants = 4
+    };
+
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+            options.num_transports = std::stoul(argv[++i]);
+        } else if (strcmp(argv[i], "-d") == 0 && i + 1 < argc) {
+            options.duration_s = std::stoul(argv[++i]);
+        } else if (strcmp(argv[i], "-H") == 0 && i + 1 < argc) {
+            options.hold_ms = std::max<uint32_t>(std::stoul(argv[++i]), 1);
+        } else if (strcmp(argv[i], "-D") == 0 && i + 1 < argc) {
+            options.network_drops = std::stod(argv[++i]);
+        } else if (strcmp(argv[i], "-p") == 0 && i + 1 < argc) {
+            options.participants = std::stoul(argv[++i]);
+        } else {
+            usage();
+            return EXIT_FAILURE;
+        }
+    }
+
+    measure_startup();
+
+    measure_subscriptions(options.participants);
+
+    return run_storm(options) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,36 @@
+//
+// Copyright (c) 2024, Daily
+//
+
+#ifndef DAILY_PIPECAT_TEST_H
+#define DAILY_PIPECAT_TEST_H
+
+#include <cstdio>
+#include <cstdlib>
+
+// Minimal checks, so tests don't need a test framework. Failed checks are
+// reported and the test keeps going; `TEST_RESULT()` is the exit code.
+
+namespace test {
+
+inline int& failures() {
+    static int count = 0;
+    return count;
+}
+
+}  // namespace test
+
+#define CHECK(condition)                                                      \
+    do {                                                                      \
+        if (!(condition)) {                                                   \
+            std::fprintf(                                                     \
+                    stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, \
+                    #condition                                                \
+            );                                                                \
+            test::failures()++;                                               \
+        }                                                                     \
+    } while (0)
+
+#define TEST_RESULT() (test::failures() == 0 ? EXIT_SUCCESS : EXIT_FAILURE)
+
+#endif
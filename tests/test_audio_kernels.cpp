@@ -0,0 +1,247 @@
+//
+// Copyright (c) 2024, Daily
+//
+
+#include "daily_audio.h"
+
+#include "test.h"
+
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <vector>
+
+using namespace rtvi;
+
+// Lengths around the SIMD widths, so the vector loops and the scalar tails
+// are both exercised.
+static std::vector<size_t> test_lengths() {
+    std::vector<size_t> lengths;
+    for (size_t i = 0; i < 68; ++i) {
+        lengths.push_back(i);
+    }
+    lengths.push_back(1000);
+    return lengths;
+}
+
+static std::vector<int16_t> random_samples(std::mt19937& rng, size_t n) {
+    std::uniform_int_distribution<int> dist(-32768, 32767);
+    std::vector<int16_t> samples(n);
+    for (auto& sample : samples) {
+        sample = static_cast<int16_t>(dist(rng));
+    }
+    // Include the extremes, which are the easiest to get wrong.
+    if (n > 2) {
+        samples[0] = -32768;
+        samples[n - 1] = 32767;
+    }
+    return samples;
+}
+
+static std::vector<float> random_floats(std::mt19937& rng, size_t n) {
+    std::uniform_real_distribution<float> dist(-2.0f, 2.0f);
+    std::vector<float> samples(n);
+    for (auto& sample : samples) {
+        sample = dist(rng);
+    }
+    const float specials[] = {
+            std::numeric_limits<float>::quiet_NaN(),
+            std::numeric_limits<float>::infinity(),
+            -std::numeric_limits<float>::infinity(),
+            1.0f,
+            -1.0f,
+            1e30f,
+            -1e30f,
+    };
+    for (size_t i = 0; i < n; i += 3) {
+        samples[i] = specials[(i / 3) % (sizeof(specials) / sizeof(float))];
+    }
+    return samples;
+}
+
+static bool same_floats(
+        const std::vector<float>& a,
+        const std::vector<float>& b
+) {
+    return a.size() == b.size() &&
+           std::memcmp(a.data(), b.data(), a.size() * sizeof(float)) == 0;
+}
+
+// Runs every kernel with `name` and with the scalar implementation on the
+// same input and checks that the results are identical.
+static void check_kernels(const char* name) {
+    std::mt19937 rng(1234);
+
+    const float gains[] = {
+            0.0f,
+            0.5f,
+            2.0f,
+            100000.0f,
+            -70000.0f,
+            std::numeric_limits<float>::infinity(),
+            std::numeric_limits<float>::quiet_NaN(),
+    };
+
+    for (size_t n : test_lengths()) {
+        std::vector<int16_t> a = random_samples(rng, n);
+        std::vector<int16_t> b = random_samples(rng, n);
+        std::vector<float> f = random_floats(rng, n);
+
+        audio_select_kernels("scalar");
+        uint32_t peak = audio_peak(a.data(), n);
+        uint64_t sum_squares = audio_sum_squares(a.data(), n);
+        audio_select_kernels(name);
+        CHECK(audio_peak(a.data(), n) == peak);
+        CHECK(audio_sum_squares(a.data(), n) == sum_squares);
+
+        for (float gain : gains) {
+            std::vector<int16_t> expected = a;
+            std::vector<int16_t> actual = a;
+            audio_select_kernels("scalar");
+            audio_gain(expected.data(), n, gain);
+            audio_select_kernels(name);
+            audio_gain(actual.data(), n, gain);
+            CHECK(actual == expected);
+        }
+
+        std::vector<int16_t> expected = a;
+        std::vector<int16_t> actual = a;
+        audio_select_kernels("scalar");
+        audio_mix(expected.data(), b.data(), n);
+        audio_select_kernels(name);
+        audio_mix(actual.data(), b.data(), n);
+        CHECK(actual == expected);
+
+        std::vector<int16_t> expected_int16(n);
+        std::vector<int16_t> actual_int16(n);
+        audio_select_kernels("scalar");
+        audio_float_to_int16(f.data(), expected_int16.data(), n);
+        audio_select_kernels(name);
+        audio_float_to_int16(f.data(), actual_int16.data(), n);
+        CHECK(actual_int16 == expected_int16);
+
+        std::vector<float> expected_float(n);
+        std::vector<float> actual_float(n);
+        audio_select_kernels("scalar");
+        audio_int16_to_float(a.data(), expected_float.data(), n);
+        audio_select_kernels(name);
+        audio_int16_to_float(a.data(), actual_float.data(), n);
+        CHECK(same_floats(actual_float, expected_float));
+
+        // `a` holds n / 2 stereo frames.
+        size_t frames = n / 2;
+        std::vector<int16_t> expected_mono(frames);
+        std::vector<int16_t> actual_mono(frames);
+        audio_select_kernels("scalar");
+        audio_stereo_to_mono(a.data(), expected_mono.data(), frames);
+        audio_select_kernels(name);
+        audio_stereo_to_mono(a.data(), actual_mono.data(), frames);
+        CHECK(actual_mono == expected_mono);
+
+        std::vector<int16_t> expected_stereo(n * 2);
+        std::vector<int16_t> actual_stereo(n * 2);
+        audio_select_kernels("scalar");
+        audio_mono_to_stereo(a.data(), expected_stereo.data(), n);
+        audio_select_kernels(name);
+        audio_mono_to_stereo(a.data(), actual_stereo.data(), n);
+        CHECK(actual_stereo == expected_stereo);
+
+        for (uint32_t channels = 1; channels <= 2; ++channels) {
+            size_t planar_frames = n / channels;
+            std::vector<int16_t> expected_frames(n);
+            std::vector<int16_t> actual_frames(n);
+            audio_select_kernels("scalar");
+            audio_planar_float_to_int16(
+                    f.data(),
+                    expected_frames.data(),
+                    planar_frames,
+                    channels,
+                    planar_frames
+            );
+            audio_select_kernels(name);
+            audio_planar_float_to_int16(
+                    f.data(),
+                    actual_frames.data(),
+                    planar_frames,
+                    channels,
+                    planar_frames
+            );
+            CHECK(actual_frames == expected_frames);
+
+            std::vector<float> expected_planes(n);
+            std::vector<float> actual_planes(n);
+            audio_select_kernels("scalar");
+            audio_int16_to_planar_float(
+                    a.data(),
+                    expected_planes.data(),
+                    planar_frames,
+                    channels,
+                    planar_frames
+            );
+            audio_select_kernels(name);
+            audio_int16_to_planar_float(
+                    a.data(),
+                    actual_planes.data(),
+                    planar_frames,
+                    channels,
+                    planar_frames
+            );
+            CHECK(same_floats(actual_planes, expected_planes));
+        }
+    }
+}
+
+// Checks the scalar implementation against known values, so the comparisons
+// above are against something correct.
+static void check_scalar() {
+    CHECK(audio_select_kernels("scalar"));
+    CHECK(std::strcmp(audio_kernels_name(), "scalar") == 0);
+
+    int16_t samples[] = {-32768, -1, 0, 1, 32767};
+    CHECK(audio_peak(samples, 5) == 32768);
+    CHECK(audio_peak(samples, 0) == 0);
+    CHECK(audio_sum_squares(samples + 1, 3) == 2);
+
+    int16_t loud[] = {1000, -1000, 0};
+    audio_gain(loud, 3, 100000.0f);
+    CHECK(loud[0] == 32767 && loud[1] == -32768 && loud[2] == 0);
+
+    int16_t nan[] = {1000, -1000};
+    audio_gain(nan, 2, std::numeric_limits<float>::quiet_NaN());
+    CHECK(nan[0] == 0 && nan[1] == 0);
+
+    int16_t dst[] = {30000, -30000};
+    int16_t src[] = {30000, -30000};
+    audio_mix(dst, src, 2);
+    CHECK(dst[0] == 32767 && dst[1] == -32768);
+
+    float floats[] = {
+            1.0f, -1.0f, 0.0f, 2.0f, std::numeric_limits<float>::quiet_NaN()
+    };
+    int16_t converted[5];
+    audio_float_to_int16(floats, converted, 5);
+    CHECK(converted[0] == 32767);
+    CHECK(converted[1] == -32768);
+    CHECK(converted[2] == 0);
+    CHECK(converted[3] == 32767);
+    CHECK(converted[4] == 0);
+}
+
+int main() {
+    check_scalar();
+
+    CHECK(!audio_select_kernels("unknown"));
+
+    const char* names[] = {"sse2", "avx2", "neon"};
+    for (const char* name : names) {
+        if (!audio_select_kernels(name)) {
+            std::printf("%s: not supported, skipped\n", name);
+            continue;
+        }
+        check_kernels(name);
+        std::printf("%s: checked against scalar\n", name);
+    }
+
+    return TEST_RESULT();
+}
@@ -0,0 +1,138 @@
+//
+// Copyright (c) 2024, Daily
+//
+
+#include "daily_audio_meter.h"
+
+#include "test.h"
+
+#include <cmath>
+#include <vector>
+
+using namespace rtvi;
+
+static bool near(float value, float expected) {
+    return std::fabs(value - expected) < 0.001f;
+}
+
+// A 10ms block of 16 kHz mono audio with the given sample value.
+static std::vector<int16_t> constant_block(int16_t value) {
+    return std::vector<int16_t>(160, value);
+}
+
+static void check_levels() {
+    DailyAudioMeter meter(16000, 1, -45.0f, 300);
+
+    std::vector<int16_t> block = constant_block(16384);
+    meter.process(block.data(), block.size());
+    CHECK(near(meter.levels().rms, 0.5f));
+    CHECK(near(meter.levels().peak, 0.5f));
+
+    // A square wave has the same RMS and peak levels, a sine wave doesn't.
+    for (size_t i = 0; i < block.size(); ++i) {
+        block[i] = i % 2 ? 8192 : -8192;
+    }
+    meter.process(block.data(), block.size());
+    CHECK(near(meter.levels().rms, 0.25f));
+    CHECK(near(meter.levels().peak, 0.25f));
+
+    for (size_t i = 0; i < block.size(); ++i) {
+        block[i] = static_cast<int16_t>(
+                16384 * std::sin(2 * 3.14159265358979 * 1000 * i / 16000)
+        );
+    }
+    meter.process(block.data(), block.size());
+    CHECK(near(meter.levels().rms, 0.5f / std::sqrt(2.0f)));
+    CHECK(near(meter.levels().peak, 0.5f));
+
+    // The most negative sample is full scale.
+    block = constant_block(-32768);
+    meter.process(block.data(), block.size());
+    CHECK(near(meter.levels().peak, 1.0f));
+
+    CHECK(meter.blocks() == 4);
+}
+
+// Levels are only published once a block is complete, whatever the size of
+// the writes.
+static void check_partial_blocks() {
+    DailyAudioMeter meter(48000, 2, -45.0f, 300);
+
+    // 10ms of 48 kHz stereo, with only the right channel.
+    std::vector<int16_t> frames(2 * 480, 0);
+    for (size_t i = 0; i < 480; ++i) {
+        frames[2 * i + 1] = 16384;
+    }
+
+    meter.process(frames.data(), 300);
+    CHECK(meter.blocks() == 0);
+    CHECK(meter.levels().peak == 0.0f);
+
+    meter.process(frames.data() + 2 * 300, 180);
+    CHECK(meter.blocks() == 1);
+    CHECK(near(meter.levels().peak, 0.5f));
+    CHECK(near(meter.levels().rms, 0.5f / std::sqrt(2.0f)));
+
+    // Many blocks in a single write.
+    std::vector<int16_t> second(2 * 4800, 0);
+    meter.process(second.data(), 4800);
+    CHECK(meter.blocks() == 11);
+    CHECK(meter.levels().rms == 0.0f);
+}
+
+// -20 dBFS is an RMS level of 0.1, and the hangover is 3 blocks.
+static void check_speaking() {
+    DailyAudioMeter meter(16000, 1, -20.0f, 30);
+
+    std::vector<int16_t> loud = constant_block(16384);
+    std::vector<int16_t> quiet = constant_block(1000);
+    std::vector<int16_t> threshold = constant_block(3277);
+
+    CHECK(!meter.process(quiet.data(), quiet.size()));
+    CHECK(!meter.speaking());
+
+    // Reaching the threshold starts speech.
+    CHECK(meter.process(threshold.data(), threshold.size()));
+    CHECK(meter.speaking() && meter.levels().speaking);
+    CHECK(!meter.process(loud.data(), loud.size()));
+
+    // Two quiet blocks are not enough, and a loud one starts over.
+    CHECK(!meter.process(quiet.data(), quiet.size()));
+    CHECK(!meter.process(quiet.data(), quiet.size()));
+    CHECK(!meter.process(loud.data(), loud.size()));
+    CHECK(!meter.process(quiet.data(), quiet.size()));
+    CHECK(!meter.process(quiet.data(), quiet.size()));
+    CHECK(meter.speaking());
+
+    CHECK(meter.process(quiet.data(), quiet.size()));
+    CHECK(!meter.speaking() && !meter.levels().speaking);
+    CHECK(!meter.process(quiet.data(), quiet.size()));
+
+    // Short hangovers still need one quiet block.
+    DailyAudioMeter short_meter(16000, 1, -20.0f, 0);
+    CHECK(short_meter.process(loud.data(), loud.size()));
+    CHECK(short_meter.process(quiet.data(), quiet.size()));
+}
+
+// Formats without a sample in a 10ms block can't be measured, and must not
+// hang or divide by zero.
+static void check_invalid_format() {
+    std::vector<int16_t> block = constant_block(16384);
+
+    DailyAudioMeter slow(50, 1, -45.0f, 300);
+    CHECK(!slow.process(block.data(), block.size()));
+    CHECK(slow.blocks() == 0);
+    CHECK(slow.levels().rms == 0.0f);
+
+    DailyAudioMeter no_channels(16000, 0, -45.0f, 300);
+    CHECK(!no_channels.process(block.data(), block.size()));
+    CHECK(no_channels.blocks() == 0);
+}
+
+int main() {
+    check_levels();
+    check_partial_blocks();
+    check_speaking();
+    check_invalid_format();
+    return TEST_RESULT();
+}
@@ -0,0 +1,113 @@
+//
+// Copyright (c) 2024, Daily
+//
+
+#include "daily_audio_pacer.h"
+
+#include "test.h"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+using namespace rtvi;
+
+static const uint32_t SAMPLE_RATE = 16000;
+static const size_t BLOCK_FRAMES = SAMPLE_RATE / 100;
+
+// Waits until the pacer has no more audio queued, or gives up after a second.
+static void wait_drained(DailyAudioPacer& pacer) {
+    for (int i = 0; i < 1000 && pacer.queued_frames() > 0; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    // Let the last block go through the writer.
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+}
+
+static void check_writes() {
+    std::atomic<size_t> received {0};
+    DailyAudioPacer pacer(
+            SAMPLE_RATE, 1, [&](const int16_t* frames, size_t num_frames) {
+                received += num_frames;
+                return static_cast<int32_t>(num_frames);
+            }
+    );
+    pacer.start(10.0);
+
+    std::vector<int16_t> audio(BLOCK_FRAMES * 5 + 7);
+    pacer.push(audio.data(), audio.size());
+    wait_drained(pacer);
+
+    DailyAudioPacerStats stats = pacer.stats();
+    CHECK(received == audio.size());
+    CHECK(stats.frames_written == audio.size());
+    CHECK(stats.frames_dropped == 0);
+    CHECK(stats.write_errors == 0);
+
+    pacer.stop();
+}
+
+// Frames the writer doesn't take are reported instead of counted as written.
+static void check_failures() {
+    std::atomic<int> calls {0};
+    DailyAudioPacer pacer(
+            SAMPLE_RATE, 1, [&](const int16_t* frames, size_t num_frames) {
+                switch (calls++) {
+                case 0:
+                    return static_cast<int32_t>(num_frames);
+                case 1:
+                    return -1;
+                default:
+                    return static_cast<int32_t>(num_frames / 2);
+                }
+            }
+    );
+    pacer.start(10.0);
+
+    std::vector<int16_t> audio(BLOCK_FRAMES * 3);
+    pacer.push(audio.data(), audio.size());
+    wait_drained(pacer);
+
+    DailyAudioPacerStats stats = pacer.stats();
+    CHECK(stats.frames_written == BLOCK_FRAMES + BLOCK_FRAMES / 2);
+    CHECK(stats.frames_dropped == BLOCK_FRAMES + BLOCK_FRAMES / 2);
+    CHECK(stats.write_errors == 1);
+
+    pacer.stop();
+}
+
+// Without audio the pacer thread waits instead of ticking every block, and
+// wakes up as soon as audio is queued.
+static void check_idle() {
+    std::atomic<size_t> received {0};
+    DailyAudioPacer pacer(
+            SAMPLE_RATE, 1, [&](const int16_t* frames, size_t num_frames) {
+                received += num_frames;
+                return static_cast<int32_t>(num_frames);
+            }
+    );
+    pacer.start(1.0);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    CHECK(pacer.stats().idle_ticks == 1);
+
+    std::vector<int16_t> audio(BLOCK_FRAMES);
+    pacer.push(audio.data(), audio.size());
+    wait_drained(pacer);
+    CHECK(received == BLOCK_FRAMES);
+    CHECK(pacer.stats().idle_ticks == 2);
+
+    // Stopping wakes up the idle thread.
+    auto start = std::chrono::steady_clock::now();
+    pacer.stop();
+    CHECK(std::chrono::steady_clock::now() - start <
+          std::chrono::milliseconds(100));
+}
+
+int main() {
+    check_writes();
+    check_failures();
+    check_idle();
+    return TEST_RESULT();
+}
@@ -0,0 +1,87 @@
+//
+// Copyright (c) 2024, Daily
+//
+
+#include "daily_audio_processor.h"
+
+#include "test.h"
+
+#include <memory>
+#include <random>
+#include <vector>
+
+using namespace rtvi;
+
+static const uint32_t SAMPLE_RATE = 16000;
+static const size_t BLOCK_FRAMES = SAMPLE_RATE / 100;
+
+// Delay between the bot audio being read and its echo being recorded.
+static const size_t ECHO_DELAY = SAMPLE_RATE * 40 / 1000;
+
+static double energy(const int16_t* frames, size_t num_frames) {
+    double sum = 0;
+    for (size_t i = 0; i < num_frames; ++i) {
+        sum += double(frames[i]) * frames[i];
+    }
+    return sum;
+}
+
+// Bot audio read while the user wasn't sending audio must not delay the
+// reference of the echo that comes after.
+static void check_stale_reference() {
+    DailyAudioProcessor processor(SAMPLE_RATE, 1);
+    processor.add_stage(std::make_unique<DailyEchoCanceller>(SAMPLE_RATE));
+
+    std::mt19937 random(1);
+    std::uniform_int_distribution<int> noise(-8000, 8000);
+
+    std::vector<int16_t> stale(SAMPLE_RATE);
+    for (int16_t& sample : stale) {
+        sample = static_cast<int16_t>(noise(random));
+    }
+    processor.add_reference(stale.data(), stale.size(), SAMPLE_RATE, 1);
+
+    // Two seconds of echo only, measured over the last half.
+    size_t num_blocks = 200;
+    std::vector<int16_t> bot(ECHO_DELAY + num_blocks * BLOCK_FRAMES, 0);
+    std::vector<int16_t> user(BLOCK_FRAMES);
+    std::vector<int16_t> output(2 * BLOCK_FRAMES);
+    double echo_energy = 0;
+    double residual_energy = 0;
+    for (size_t block = 0; block < num_blocks; ++block) {
+        int16_t* reference = bot.data() + ECHO_DELAY + block * BLOCK_FRAMES;
+        for (size_t i = 0; i < BLOCK_FRAMES; ++i) {
+            reference[i] = static_cast<int16_t>(noise(random));
+        }
+        processor.add_reference(reference, BLOCK_FRAMES, SAMPLE_RATE, 1);
+
+        for (size_t i = 0; i < BLOCK_FRAMES; ++i) {
+            user[i] = reference[int64_t(i) - int64_t(ECHO_DELAY)] / 2;
+        }
+
+        size_t count =
+                processor.process(user.data(), BLOCK_FRAMES, output.data());
+        CHECK(count == BLOCK_FRAMES);
+
+        if (block >= num_blocks / 2) {
+            echo_energy += energy(user.data(), BLOCK_FRAMES);
+            residual_energy += energy(output.data(), count);
+        }
+    }
+
+    // At least 20 dB of echo removed.
+    CHECK(residual_energy < echo_energy / 100);
+}
+
+// The filter tail is bounded, whatever the sample rate.
+static void check_max_taps() {
+    CHECK(DailyEchoCanceller(16000).reference_frames() == 1023);
+    CHECK(DailyEchoCanceller(48000).reference_frames() == 1023);
+    CHECK(DailyEchoCanceller(8000).reference_frames() == 511);
+}
+
+int main() {
+    check_stale_reference();
+    check_max_taps();
+    return TEST_RESULT();
+}
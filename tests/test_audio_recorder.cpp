@@ -0,0 +1,292 @@
+//
+// Copyright (c) 2024, Daily
+//
+
+#include "daily_audio_recorder.h"
+
+#include "test.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+using namespace rtvi;
+
+static const int32_t INDEX_TABLE[16] = {
+        -1, -1, -1, -1, 2, 4, 6, 8, -1, -1, -1, -1, 2, 4, 6, 8
+};
+
+static const int32_t STEP_TABLE[89] = {
+        7,     8,     9,     10,    11,    12,    13,    14,    16,    17,
+        19,    21,    23,    25,    28,    31,    34,    37,    41,    45,
+        50,    55,    60,    66,    73,    80,    88,    97,    107,   118,
+        130,   143,   157,   173,   190,   209,   230,   253,   279,   307,
+        337,   371,   408,   449,   494,   544,   598,   658,   724,   796,
+        876,   963,   1060,  1166,  1282,  1411,  1552,  1707,  1878,  2066,
+        2272,  2499,  2749,  3024,  3327,  3660,  4026,  4428,  4871,  5358,
+        5894,  6484,  7132,  7845,  8630,  9493,  10442, 11487, 12635, 13899,
+        15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767
+};
+
+struct Wav {
+    uint16_t format;
+    uint16_t num_channels;
+    uint32_t sample_rate;
+    uint16_t block_size;
+    uint16_t block_samples;
+    uint32_t num_samples;
+    std::vector<int16_t> samples;
+};
+
+static uint32_t get_u16(const uint8_t* p) {
+    return p[0] | (p[1] << 8);
+}
+
+static uint32_t get_u32(const uint8_t* p) {
+    return get_u16(p) | (get_u16(p + 2) << 16);
+}
+
+static bool has_tag(const uint8_t* p, const char* tag) {
+    return std::equal(tag, tag + 4, p);
+}
+
+static int16_t
+decode_nibble(uint8_t nibble, int32_t& predictor, int32_t& index) {
+    int32_t step = STEP_TABLE[index];
+
+    int32_t delta = step >> 3;
+    if (nibble & 4) {
+        delta += step;
+    }
+    if (nibble & 2) {
+        delta += step >> 1;
+    }
+    if (nibble & 1) {
+        delta += step >> 2;
+    }
+
+    predictor += (nibble & 8) ? -delta : delta;
+    predictor = std::clamp(predictor, -32768, 32767);
+
+    index = std::clamp(index + INDEX_TABLE[nibble], 0, 88);
+
+    return static_cast<int16_t>(predictor);
+}
+
+// Reads and decodes a mono IMA ADPCM WAV file, as written by the recorder.
+static bool read_wav(const std::string& path, Wav& wav) {
+    std::FILE* file = std::fopen(path.c_str(), "rb");
+    if (!file) {
+        return false;
+    }
+
+    std::vector<uint8_t> data;
+    uint8_t buffer[4096];
+    size_t n;
+    while ((n = std::fread(buffer, 1, sizeof(buffer), file)) > 0) {
+        data.insert(data.end(), buffer, buffer + n);
+    }
+    std::fclose(file);
+
+    const size_t header_size = 60;
+    if (data.size() < header_size || !has_tag(&data[0], "RIFF") ||
+        get_u32(&data[4]) != data.size() - 8 || !has_tag(&data[8], "WAVE") ||
+        !has_tag(&data[12], "fmt ") || !has_tag(&data[40], "fact") ||
+        !has_tag(&data[52], "data") ||
+        get_u32(&data[56]) != data.size() - header_size) {
+        return false;
+    }
+
+    wav.format = get_u16(&data[20]);
+    wav.num_channels = get_u16(&data[22]);
+    wav.sample_rate = get_u32(&data[24]);
+    wav.block_size = get_u16(&data[32]);
+    wav.block_samples = get_u16(&data[38]);
+    wav.num_samples = get_u32(&data[48]);
+
+    if (wav.num_channels != 1 || wav.block_size == 0 ||
+        (data.size() - header_size) % wav.block_size != 0 ||
+        wav.block_samples != (wav.block_size - 4) * 2 + 1) {
+        return false;
+    }
+
+    wav.samples.clear();
+    for (size_t offset = header_size; offset < data.size();
+         offset += wav.block_size) {
+        const uint8_t* block = &data[offset];
+
+        int32_t predictor = static_cast<int16_t>(get_u16(block));
+        int32_t index = block[2];
+        if (index > 88) {
+            return false;
+        }
+        wav.samples.push_back(static_cast<int16_t>(predictor));
+
+        for (size_t i = 4; i < wav.block_size; ++i) {
+            wav.samples.push_back(
+                    decode_nibble(block[i] & 0x0f, predictor, index)
+            );
+            wav.samples.push_back(decode_nibble(block[i] >> 4, predictor, index)
+            );
+        }
+    }
+
+    // The last block is padded.
+    if (wav.num_samples > wav.samples.size() ||
+        wav.samples.size() - wav.num_samples >= wav.block_samples) {
+        return false;
+    }
+    wav.samples.resize(wav.num_samples);
+
+    return true;
+}
+
+// A sine wave with a rising amplitude.
+static std::vector<int16_t> make_audio(uint32_t sample_rate, size_t count) {
+    std::vector<int16_t> samples(count);
+    for (size_t i = 0; i < count; ++i) {
+        double amplitude = 2000.0 + 12000.0 * i / count;
+        samples[i] = static_cast<int16_t>(
+                amplitude *
+                std::sin(2 * 3.14159265358979 * 440 * i / sample_rate)
+        );
+    }
+    return samples;
+}
+
+// The same audio in all the channels.
+static std::vector<int16_t>
+interleave(const std::vector<int16_t>& mono, uint32_t num_channels) {
+    std::vector<int16_t> frames;
+    for (int16_t sample : mono) {
+        frames.insert(frames.end(), num_channels, sample);
+    }
+    return frames;
+}
+
+// ADPCM is lossy, the decoded audio has to be close to the input.
+static bool matches(const std::vector<int16_t>& decoded,
+                    const std::vector<int16_t>& input) {
+    if (decoded.size() != input.size()) {
+        return false;
+    }
+
+    double signal = 0;
+    double noise = 0;
+    for (size_t i = 0; i < input.size(); ++i) {
+        double error = double(decoded[i]) - input[i];
+        signal += double(input[i]) * input[i];
+        noise += error * error;
+    }
+
+    // At least 30 dB of SNR.
+    return noise * 1000 < signal;
+}
+
+// Records in 10ms writes, like the transport does.
+static void record(DailyAudioRecorder& recorder,
+                   const std::vector<int16_t>& user,
+                   uint32_t user_channels,
+                   const std::vector<int16_t>& bot,
+                   uint32_t bot_channels) {
+    size_t user_frames = user_channels ? user.size() / user_channels : 0;
+    size_t bot_frames = bot_channels ? bot.size() / bot_channels : 0;
+
+    size_t user_block = 160;
+    size_t bot_block = 240;
+
+    for (size_t u = 0, b = 0; u < user_frames || b < bot_frames;) {
+        if (u < user_frames) {
+            size_t n = std::min(user_block, user_frames - u);
+            recorder.record_user_audio(&user[u * user_channels], n);
+            u += n;
+        }
+        if (b < bot_frames) {
+            size_t n = std::min(bot_block, bot_frames - b);
+            recorder.record_bot_audio(&bot[b * bot_channels], n);
+            b += n;
+        }
+    }
+}
+
+static void check_round_trip() {
+    std::string user_path = "test_audio_recorder_user.wav";
+    std::string bot_path = "test_audio_recorder_bot.wav";
+
+    // One second of user audio, and a bit more than a second of bot audio,
+    // which doesn't end on a block boundary.
+    std::vector<int16_t> user = make_audio(16000, 16000);
+    std::vector<int16_t> bot = make_audio(24000, 24000 + 1234);
+
+    DailyAudioRecorder recorder(
+            DailyAudioRecorder::Track {
+                    .path = user_path, .sample_rate = 16000, .num_channels = 1
+            },
+            DailyAudioRecorder::Track {
+                    .path = bot_path, .sample_rate = 24000, .num_channels = 2
+            }
+    );
+    CHECK(recorder.start());
+    record(recorder, user, 1, interleave(bot, 2), 2);
+    recorder.stop();
+
+    DailyRecordingStats stats = recorder.stats();
+    CHECK(stats.frames_recorded == user.size() + bot.size());
+    CHECK(stats.dropped_frames == 0);
+
+    Wav wav;
+    CHECK(read_wav(user_path, wav));
+    CHECK(wav.format == 0x0011);
+    CHECK(wav.sample_rate == 16000);
+    CHECK(matches(wav.samples, user));
+    uint64_t bytes_written = 60 + (user.size() + 504) / 505 * 256;
+
+    CHECK(read_wav(bot_path, wav));
+    CHECK(wav.sample_rate == 24000);
+    CHECK(matches(wav.samples, bot));
+    bytes_written += 60 + (bot.size() + 504) / 505 * 256;
+
+    CHECK(stats.bytes_written == bytes_written);
+
+    std::remove(user_path.c_str());
+    std::remove(bot_path.c_str());
+}
+
+// More than two channels are downmixed, and a track without channels is not
+// recorded.
+static void check_channels() {
+    std::string user_path = "test_audio_recorder_no_channels.wav";
+    std::string bot_path = "test_audio_recorder_multichannel.wav";
+    std::remove(user_path.c_str());
+
+    std::vector<int16_t> bot = make_audio(16000, 8000);
+
+    DailyAudioRecorder recorder(
+            DailyAudioRecorder::Track {
+                    .path = user_path, .sample_rate = 16000, .num_channels = 0
+            },
+            DailyAudioRecorder::Track {
+                    .path = bot_path, .sample_rate = 16000, .num_channels = 4
+            }
+    );
+    CHECK(recorder.start());
+    record(recorder, bot, 0, interleave(bot, 4), 4);
+    recorder.stop();
+
+    CHECK(recorder.stats().frames_recorded == bot.size());
+
+    Wav wav;
+    CHECK(!read_wav(user_path, wav));
+    CHECK(read_wav(bot_path, wav));
+    CHECK(matches(wav.samples, bot));
+
+    std::remove(bot_path.c_str());
+}
+
+int main() {
+    check_round_trip();
+    check_channels();
+    return TEST_RESULT();
+}
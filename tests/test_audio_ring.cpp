@@ -0,0 +1,151 @@
+//
+// Copyright (c) 2024, Daily
+//
+
+#include "daily_audio_ring.h"
+#include "daily_participant_audio.h"
+
+#include "test.h"
+
+#include <vector>
+
+using namespace rtvi;
+
+// Writes and reads across the end of the buffer many times.
+static void check_wrap_around() {
+    DailyAudioRing ring(100, 2);
+
+    std::vector<int16_t> input(2 * 70);
+    std::vector<int16_t> output(2 * 70);
+    bool same = true;
+    for (int round = 0; round < 10; ++round) {
+        for (size_t i = 0; i < input.size(); ++i) {
+            input[i] = static_cast<int16_t>(round * 1000 + i);
+        }
+        CHECK(ring.write(input.data(), 70) == 70);
+        CHECK(ring.available() == 70);
+        CHECK(ring.read(output.data(), 70) == 70);
+        same = same && output == input;
+    }
+    CHECK(same);
+    CHECK(ring.dropped_frames() == 0);
+    CHECK(ring.read(output.data(), 70) == 0);
+}
+
+static void check_full() {
+    DailyAudioRing ring(100, 1);
+
+    std::vector<int16_t> input(150, 1);
+    CHECK(ring.write(input.data(), 150) == 100);
+    CHECK(ring.dropped_frames() == 50);
+    CHECK(ring.write(input.data(), 1) == 0);
+    CHECK(ring.dropped_frames() == 51);
+
+    std::vector<int16_t> output(150);
+    CHECK(ring.read(output.data(), 150) == 100);
+}
+
+static void check_skip() {
+    DailyAudioRing ring(100, 2);
+
+    std::vector<int16_t> input(2 * 80);
+    for (size_t i = 0; i < input.size(); ++i) {
+        input[i] = static_cast<int16_t>(i);
+    }
+    CHECK(ring.write(input.data(), 80) == 80);
+    CHECK(ring.skip(30) == 30);
+    CHECK(ring.available() == 50);
+
+    int16_t frame[2];
+    CHECK(ring.read(frame, 1) == 1);
+    CHECK(frame[0] == 60 && frame[1] == 61);
+
+    CHECK(ring.skip(100) == 49);
+    CHECK(ring.available() == 0);
+    CHECK(ring.dropped_frames() == 0);
+}
+
+static void check_no_channels() {
+    DailyAudioRing ring(100, 0);
+    int16_t frames[4] = {};
+    CHECK(ring.write(frames, 4) == 0);
+    CHECK(ring.read(frames, 4) == 0);
+    CHECK(ring.available() == 0);
+    CHECK(ring.skip(4) == 0);
+
+    // daily-core decides the format of participant audio, so it needs to be
+    // validated.
+    DailyParticipantAudioStream stream("participant", 100);
+    stream.write(frames, 4, 16000, 0);
+    CHECK(stream.num_channels() == 0);
+    CHECK(stream.read(frames, 4) == 0);
+
+    stream.write(frames, 2, 16000, 2);
+    CHECK(stream.num_channels() == 2);
+    CHECK(stream.read(frames, 4) == 2);
+}
+
+// Audio queued in a previous format is dropped instead of being read with the
+// new number of channels.
+static void check_format_change() {
+    DailyParticipantAudioStream stream("participant", 100);
+
+    int16_t stereo[20];
+    int16_t mono[10];
+    for (int16_t i = 0; i < 20; ++i) {
+        stereo[i] = i;
+    }
+    for (int16_t i = 0; i < 10; ++i) {
+        mono[i] = 100 + i;
+    }
+
+    stream.write(stereo, 10, 16000, 2);
+    CHECK(stream.num_channels() == 2);
+    CHECK(stream.sample_rate() == 16000);
+
+    int16_t frames[40] = {};
+    CHECK(stream.read(frames, 2) == 2);
+    CHECK(frames[0] == 0 && frames[3] == 3);
+
+    // The reader finds out about the new format before reading it.
+    stream.write(stereo, 10, 16000, 2);
+    stream.write(mono, 10, 48000, 1);
+    CHECK(stream.read(frames, 20) == 0);
+    CHECK(stream.num_channels() == 1);
+    CHECK(stream.sample_rate() == 48000);
+    CHECK(stream.read(frames, 20) == 10);
+    CHECK(frames[0] == 100 && frames[9] == 109);
+
+    // Or when checking the format.
+    stream.write(stereo, 10, 16000, 2);
+    CHECK(stream.num_channels() == 2);
+    CHECK(stream.read(frames, 20) == 10);
+    CHECK(frames[0] == 0 && frames[19] == 19);
+
+    // A sample rate change is a format change too.
+    stream.write(stereo, 10, 16000, 2);
+    stream.write(stereo, 5, 24000, 2);
+    CHECK(stream.read(frames, 20) == 0);
+    CHECK(stream.sample_rate() == 24000);
+    CHECK(stream.read(frames, 20) == 5);
+
+    // Buffers the reader is done with are freed on the next format change.
+    size_t memory_bytes = stream.memory_bytes();
+    for (uint32_t i = 0; i < 10; ++i) {
+        stream.write(mono, 10, 16000, 1);
+        stream.write(stereo, 10, 16000, 2);
+    }
+    CHECK(stream.memory_bytes() <= memory_bytes * 2);
+    CHECK(stream.num_channels() == 2);
+    CHECK(stream.read(frames, 20) == 10);
+    CHECK(stream.dropped_frames() == 0);
+}
+
+int main() {
+    check_wrap_around();
+    check_full();
+    check_skip();
+    check_no_channels();
+    check_format_change();
+    return TEST_RESULT();
+}
@@ -0,0 +1,173 @@
+//
+// Copyright (c) 2024, Daily
+//
+
+#include "daily_bot_audio.h"
+
+#include "test.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+using namespace rtvi;
+
+static void check_same_format() {
+    DailyBotAudioStream stream(16000, 1, 16000);
+
+    std::vector<int16_t> input(160);
+    for (size_t i = 0; i < input.size(); ++i) {
+        input[i] = static_cast<int16_t>(i);
+    }
+    stream.write(input.data(), input.size(), 16000, 1);
+
+    std::vector<int16_t> output(160);
+    CHECK(stream.read(output.data(), output.size()) == 160);
+    CHECK(output == input);
+}
+
+static void check_channels() {
+    DailyBotAudioStream mono(16000, 1, 16000);
+    int16_t stereo[] = {100, 300, -100, -300};
+    mono.write(stereo, 2, 16000, 2);
+
+    int16_t frames[2];
+    CHECK(mono.read(frames, 2) == 2);
+    CHECK(frames[0] == 200 && frames[1] == -200);
+
+    DailyBotAudioStream stereo_stream(16000, 2, 16000);
+    int16_t samples[] = {100, -100};
+    stereo_stream.write(samples, 2, 16000, 1);
+
+    int16_t stereo_frames[4];
+    CHECK(stereo_stream.read(stereo_frames, 2) == 2);
+    CHECK(stereo_frames[0] == 100 && stereo_frames[1] == 100);
+    CHECK(stereo_frames[2] == -100 && stereo_frames[3] == -100);
+}
+
+// RMS of a 16 kHz stream fed with one second of a 48 kHz tone, once the
+// low-pass filter is filled.
+static double resampled_tone_rms(double frequency) {
+    DailyBotAudioStream stream(16000, 1, 16000);
+
+    std::vector<int16_t> input(480);
+    for (int chunk = 0; chunk < 100; ++chunk) {
+        for (size_t i = 0; i < input.size(); ++i) {
+            double t = (chunk * 480.0 + i) / 48000;
+            input[i] = static_cast<int16_t>(
+                    10000 * std::sin(2 * 3.14159265358979 * frequency * t)
+            );
+        }
+        stream.write(input.data(), input.size(), 48000, 1);
+    }
+
+    std::vector<int16_t> output(16000);
+    CHECK(stream.read(output.data(), output.size()) == 16000);
+
+    double sum = 0;
+    for (size_t i = 160; i < output.size(); ++i) {
+        sum += static_cast<double>(output[i]) * output[i];
+    }
+    return std::sqrt(sum / (output.size() - 160));
+}
+
+// Frequencies above 8 kHz would fold back into the 16 kHz output (12 kHz
+// becomes 4 kHz) without filtering, while speech frequencies are kept.
+static void check_anti_aliasing() {
+    double passband = resampled_tone_rms(1000);
+    CHECK(passband > 7071 * 0.95 && passband < 7071 * 1.05);
+
+    // At least 60 dB below the tone.
+    CHECK(resampled_tone_rms(12000) < 7.1);
+    CHECK(resampled_tone_rms(20000) < 7.1);
+}
+
+// 48 kHz written in 10 ms chunks needs to become exactly as many 16 kHz
+// frames, following the input signal (delayed by the low-pass filter).
+static void check_resampling() {
+    DailyBotAudioStream stream(16000, 1, 16000);
+
+    std::vector<int16_t> input(480);
+    for (int chunk = 0; chunk < 10; ++chunk) {
+        for (size_t i = 0; i < input.size(); ++i) {
+            input[i] = static_cast<int16_t>(chunk * 480 + i);
+        }
+        stream.write(input.data(), input.size(), 48000, 1);
+    }
+
+    std::vector<int16_t> output(1600);
+    CHECK(stream.read(output.data(), output.size()) == 1600);
+    // The filter has a delay of 31 input frames, and needs as many to fill.
+    bool follows = true;
+    for (size_t i = 21; i < output.size(); ++i) {
+        follows = follows && std::abs(output[i] - (3 * int(i) - 31)) <= 1;
+    }
+    CHECK(follows);
+}
+
+// Without audio, reads are paced and return silence.
+static void check_silence() {
+    DailyBotAudioStream stream(16000, 1, 16000);
+
+    std::vector<int16_t> output(160, 1);
+    auto start = std::chrono::steady_clock::now();
+    CHECK(stream.read(output.data(), output.size()) == 160);
+    auto elapsed = std::chrono::steady_clock::now() - start;
+
+    CHECK(elapsed >= std::chrono::milliseconds(9));
+    CHECK(output == std::vector<int16_t>(160, 0));
+}
+
+static void check_close() {
+    DailyBotAudioStream stream(16000, 1, 16000);
+
+    std::thread closer([&] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        stream.close();
+    });
+
+    // One second, so we would notice if close didn't wake us up.
+    std::vector<int16_t> output(16000);
+    auto start = std::chrono::steady_clock::now();
+    CHECK(stream.read(output.data(), output.size()) == 0);
+    CHECK(std::chrono::steady_clock::now() - start <
+          std::chrono::milliseconds(500));
+    closer.join();
+
+    int16_t samples[160] = {};
+    stream.write(samples, 160, 16000, 1);
+    CHECK(stream.read(output.data(), 160) == 0);
+
+    stream.open();
+    stream.write(samples, 160, 16000, 1);
+    CHECK(stream.read(output.data(), 160) == 160);
+}
+
+static void check_overflow() {
+    DailyBotAudioStream stream(16000, 1, 100);
+
+    int16_t samples[150];
+    for (int i = 0; i < 150; ++i) {
+        samples[i] = static_cast<int16_t>(i);
+    }
+    stream.write(samples, 150, 16000, 1);
+    CHECK(stream.dropped_frames() == 50);
+
+    // The oldest frames are dropped.
+    int16_t output[100];
+    CHECK(stream.read(output, 100) == 100);
+    CHECK(output[0] == 50 && output[99] == 149);
+}
+
+int main() {
+    check_same_format();
+    check_channels();
+    check_resampling();
+    check_anti_aliasing();
+    check_silence();
+    check_close();
+    check_overflow();
+    return TEST_RESULT();
+}
@@ -0,0 +1,162 @@
+//
+// Copyright (c) 2024, Daily
+//
+
+#include "daily_callback_dispatcher.h"
+
+#include "test.h"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <utility>
+#include <vector>
+
+using namespace rtvi;
+
+static void wait_for(const std::atomic<bool>& flag) {
+    while (!flag) {
+        std::this_thread::yield();
+    }
+}
+
+// Callbacks from each producer are delivered in the order they were posted,
+// whatever the interleaving with other producers.
+static void check_producer_order() {
+    const int num_producers = 4;
+    const int num_callbacks = 10000;
+
+    DailyCallbackDispatcher dispatcher;
+    dispatcher.start();
+
+    // Only touched by the dispatcher thread until it is stopped.
+    std::vector<std::pair<int, int>> delivered;
+
+    std::vector<std::thread> producers;
+    for (int producer = 0; producer < num_producers; ++producer) {
+        producers.emplace_back([&, producer] {
+            for (int i = 0; i < num_callbacks; ++i) {
+                dispatcher.post([&delivered, producer, i] {
+                    delivered.emplace_back(producer, i);
+                });
+            }
+        });
+    }
+    for (std::thread& producer : producers) {
+        producer.join();
+    }
+
+    dispatcher.stop();
+
+    CHECK(delivered.size() == size_t(num_producers * num_callbacks));
+
+    std::vector<int> next(num_producers, 0);
+    bool in_order = true;
+    for (const auto& [producer, i] : delivered) {
+        in_order = in_order && i == next[producer]++;
+    }
+    CHECK(in_order);
+
+    DailyCallbackStats stats = dispatcher.stats();
+    CHECK(stats.delivered == uint64_t(num_producers * num_callbacks));
+    CHECK(stats.pending == 0);
+}
+
+// Stopping delivers the callbacks that are already queued, callbacks posted
+// afterwards are not delivered.
+static void check_stop() {
+    std::atomic<bool> release(false);
+    std::atomic<int> count(0);
+
+    {
+        DailyCallbackDispatcher dispatcher;
+        dispatcher.start();
+
+        // Keep the dispatcher busy while more callbacks are queued.
+        dispatcher.post([&] {
+            wait_for(release);
+            count++;
+        });
+        for (int i = 0; i < 100; ++i) {
+            dispatcher.post([&] { count++; });
+        }
+        CHECK(dispatcher.stats().pending == 101);
+
+        release = true;
+        dispatcher.stop();
+        CHECK(count == 101);
+        CHECK(dispatcher.stats().pending == 0);
+
+        dispatcher.post([&] { count++; });
+        CHECK(dispatcher.stats().pending == 1);
+    }
+
+    CHECK(count == 101);
+}
+
+// The lag is the time between posting and delivering a callback.
+static void check_lag() {
+    const auto delay = std::chrono::milliseconds(20);
+    const uint64_t delay_us = 20000;
+
+    DailyCallbackDispatcher dispatcher;
+    dispatcher.start();
+
+    // The second callback waits for the first one, which only starts sleeping
+    // once the second one is posted.
+    std::atomic<bool> posted(false);
+    dispatcher.post([&] {
+        wait_for(posted);
+        std::this_thread::sleep_for(delay);
+    });
+    dispatcher.post([] {});
+    posted = true;
+
+    dispatcher.stop();
+
+    DailyCallbackStats stats = dispatcher.stats();
+    CHECK(stats.delivered == 2);
+    CHECK(stats.last_lag_us >= delay_us);
+    CHECK(stats.max_lag_us >= stats.last_lag_us);
+    CHECK(stats.total_lag_us >= stats.max_lag_us);
+}
+
+// With an executor, callbacks are handed over in order and the lag includes
+// the time they spend in the executor.
+static void check_executor() {
+    std::vector<DailyCallbackDispatcher::Callback> executor_queue;
+    DailyCallbackDispatcher dispatcher(
+            [&](DailyCallbackDispatcher::Callback callback) {
+                executor_queue.push_back(std::move(callback));
+            }
+    );
+    dispatcher.start();
+
+    std::vector<int> delivered;
+    for (int i = 0; i < 10; ++i) {
+        dispatcher.post([&delivered, i] { delivered.push_back(i); });
+    }
+    CHECK(delivered.empty());
+    CHECK(dispatcher.stats().pending == 10);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    for (auto& callback : executor_queue) {
+        callback();
+    }
+
+    CHECK(delivered == std::vector<int>({0, 1, 2, 3, 4, 5, 6, 7, 8, 9}));
+
+    DailyCallbackStats stats = dispatcher.stats();
+    CHECK(stats.delivered == 10);
+    CHECK(stats.pending == 0);
+    CHECK(stats.max_lag_us >= 10000);
+    CHECK(stats.total_lag_us >= 10 * 10000);
+}
+
+int main() {
+    check_producer_order();
+    check_stop();
+    check_lag();
+    check_executor();
+    return TEST_RESULT();
+}
@@ -0,0 +1,136 @@
+//
+// Copyright (c) 2024, Daily
+//
+
+#include "daily_dispatch.h"
+
+#include "test.h"
+
+#include <nlohmann/json.hpp>
+
+#include <optional>
+#include <random>
+#include <string>
+
+using namespace rtvi;
+
+static const char* KEY = "action";
+
+// Checks that peeking agrees with parsing. Peeking may only give up on JSON
+// with escape sequences, which is then parsed.
+static void check_agrees(const std::string& json) {
+    nlohmann::json parsed = nlohmann::json::parse(json);
+    std::optional<std::string_view> peeked = daily_json_peek_string(json, KEY);
+
+    bool has_string = parsed.contains(KEY) && parsed[KEY].is_string();
+    if (peeked) {
+        CHECK(has_string && *peeked == parsed[KEY].get<std::string>());
+    } else if (has_string) {
+        CHECK(json.find('\\') != std::string::npos);
+    }
+}
+
+static nlohmann::json random_value(std::mt19937& random, int depth);
+
+static std::string random_string(std::mt19937& random) {
+    static const char* STRINGS[] = {
+            "action",
+            "participant-joined",
+            "app-message",
+            "with \"quotes\"",
+            "back\\slash",
+            "new\nline",
+            "caf\xC3\xA9",
+            "{\"action\": \"nested\"}",
+            "",
+    };
+    return STRINGS[random() % (sizeof(STRINGS) / sizeof(STRINGS[0]))];
+}
+
+static nlohmann::json random_object(std::mt19937& random, int depth) {
+    nlohmann::json object = nlohmann::json::object();
+    size_t size = random() % 5;
+    for (size_t i = 0; i < size; ++i) {
+        object[random_string(random)] = random_value(random, depth + 1);
+    }
+    return object;
+}
+
+static nlohmann::json random_value(std::mt19937& random, int depth) {
+    switch (depth < 3 ? random() % 6 : random() % 4) {
+    case 0:
+        return random_string(random);
+    case 1:
+        return static_cast<int>(random() % 1000);
+    case 2:
+        return random() % 2 == 0;
+    case 3:
+        return nullptr;
+    case 4: {
+        nlohmann::json array = nlohmann::json::array();
+        size_t size = random() % 4;
+        for (size_t i = 0; i < size; ++i) {
+            array.push_back(random_value(random, depth + 1));
+        }
+        return array;
+    }
+    default:
+        return random_object(random, depth);
+    }
+}
+
+static void check_random_events() {
+    std::mt19937 random(1);
+    for (int i = 0; i < 5000; ++i) {
+        nlohmann::json event = random_object(random, 0);
+        check_agrees(event.dump());
+        check_agrees(event.dump(2));
+    }
+}
+
+static void check_edge_cases() {
+    const char* events[] = {
+            R"({"action":"app-message"})",
+            R"( { "action" : "app-message" } )",
+            R"({"data":{"action":"nested"},"action":"top"})",
+            R"({"data":["action", {"action":"nested"}],"action":"top"})",
+            R"({"from":"action","action":"top"})",
+            R"({"action":"with \"escapes\""})",
+            R"({"action":"café"})",
+            R"({"\u0061ction":"escaped-key"})",
+            R"({"action":5})",
+            R"({"action":null})",
+            R"({"other":"value"})",
+            R"({})",
+            R"(["action"])",
+    };
+    for (const char* event : events) {
+        check_agrees(event);
+    }
+
+    // Malformed JSON isn't peeked, parsing reports it.
+    CHECK(!daily_json_peek_string(R"({"action":"unterminated)", KEY));
+    CHECK(!daily_json_peek_string(R"({"action":)", KEY));
+    CHECK(!daily_json_peek_string("", KEY));
+}
+
+static void check_perfect_hash() {
+    static constexpr DailyPerfectHash<4> KEYS(
+            {"participant-joined", "participant-left", "app-message", "a"}
+    );
+    static_assert(KEYS.valid(), "no perfect hash");
+
+    for (size_t i = 0; i < 4; ++i) {
+        CHECK(KEYS.find(KEYS.key(i)) == static_cast<int32_t>(i));
+    }
+    CHECK(KEYS.find("participant-updated") == -1);
+    CHECK(KEYS.find("") == -1);
+    CHECK(KEYS.find("app-message ") == -1);
+}
+
+int main() {
+    check_random_events();
+    check_edge_cases();
+    check_perfect_hash();
+    return TEST_RESULT();
+}
@@ -0,0 +1,191 @@
+//
+// Copyright (c) 2024, Daily
+//
+
+#include "daily_message_chunks.h"
+
+#include "test.h"
+
+#include <nlohmann/json.hpp>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+using namespace rtvi;
+
+// Splits `message` and reassembles the chunks in the given order, checking
+// the escaped size of their data.
+static std::string round_trip(
+        const std::string& message,
+        size_t chunk_size,
+        bool reverse = false
+) {
+    std::vector<std::string> chunks =
+            daily_split_message(message, 7, chunk_size);
+    if (reverse) {
+        std::reverse(chunks.begin(), chunks.end());
+    }
+
+    DailyMessageAssembler assembler;
+    std::optional<std::string> result;
+    for (const std::string& chunk : chunks) {
+        nlohmann::json parsed = nlohmann::json::parse(chunk);
+        CHECK(parsed["label"] == DAILY_MESSAGE_CHUNK_LABEL);
+        CHECK(parsed["total"] == chunks.size());
+
+        // A single character is always sent, even if it doesn't fit.
+        std::string data = parsed["data"];
+        size_t escaped_data = nlohmann::json(data).dump().size() - 2;
+        CHECK(escaped_data <= std::max<size_t>(chunk_size, 6));
+        CHECK(!data.empty());
+
+        CHECK(!result);
+        result = assembler.add_chunk(
+                "sender",
+                parsed["id"],
+                parsed["seq"],
+                parsed["total"],
+                std::move(data)
+        );
+    }
+    CHECK(assembler.pending() == 0);
+    CHECK(assembler.memory().bytes() == 0);
+    return result.value_or("");
+}
+
+static void check_round_trips() {
+    std::string ascii = R"({"label":"rtvi-ai","type":"action","data":{}})";
+    // 2, 3 and 4 byte UTF-8 sequences.
+    std::string utf8 = "caf\xC3\xA9 \xE2\x82\xAC \xF0\x9F\x98\x80 end";
+    std::string escaped = "\"quoted\"\\\n\ttab\x01";
+
+    for (const std::string& message : {ascii, utf8, escaped}) {
+        for (size_t chunk_size = 1; chunk_size <= 12; ++chunk_size) {
+            CHECK(round_trip(message, chunk_size) == message);
+            CHECK(round_trip(message, chunk_size, true) == message);
+        }
+        CHECK(round_trip(message, 1000) == message);
+    }
+}
+
+// Quotes double in size once escaped, so more chunks are needed.
+static void check_escaped_size() {
+    std::string quotes(100, '"');
+    CHECK(daily_split_message(quotes, 1, 50).size() == 4);
+    std::string letters(100, 'a');
+    CHECK(daily_split_message(letters, 1, 50).size() == 2);
+}
+
+static void check_max_pending() {
+    DailyMessageAssembler assembler(2);
+    CHECK(!assembler.add_chunk("a", 1, 0, 2, "x"));
+    CHECK(!assembler.add_chunk("a", 2, 0, 2, "x"));
+    CHECK(!assembler.add_chunk("a", 3, 0, 2, "x"));
+    CHECK(assembler.pending() == 2);
+    CHECK(assembler.discarded() == 1);
+
+    // Message 1 was discarded.
+    CHECK(!assembler.add_chunk("a", 1, 1, 2, "y"));
+    CHECK(assembler.add_chunk("a", 3, 1, 2, "y") == std::string("xy"));
+}
+
+// Remote participants choose `total`, which must not be able to make us
+// allocate more than the budget.
+static void check_max_bytes() {
+    size_t max_bytes = 64 * 1024;
+    DailyMessageAssembler assembler(16, max_bytes);
+
+    for (uint64_t id = 0; id < 16; ++id) {
+        assembler.add_chunk("a", id, 0, 65536, "x");
+        CHECK(assembler.memory().bytes() <= max_bytes);
+    }
+    CHECK(assembler.pending() == 0);
+    CHECK(assembler.discarded() == 16);
+
+    // Large chunks evict older messages, and messages that don't fit on
+    // their own are dropped.
+    std::string half(max_bytes / 2, 'x');
+    CHECK(!assembler.add_chunk("a", 100, 0, 2, half));
+    CHECK(!assembler.add_chunk("a", 101, 0, 2, half));
+    CHECK(assembler.pending() == 1);
+    CHECK(!assembler.add_chunk("a", 101, 1, 2, half));
+    CHECK(assembler.pending() == 0);
+    CHECK(assembler.memory().bytes() <= max_bytes);
+
+    CHECK(!assembler.add_chunk("a", 102, 0, 2, "x"));
+    CHECK(assembler.add_chunk("a", 102, 1, 2, "y") == std::string("xy"));
+    CHECK(assembler.memory().bytes() == 0);
+}
+
+// Chunk fields come from remote participants, so anything can be in them.
+static void check_malformed_messages() {
+    DailyMessageAssembler assembler;
+
+    nlohmann::json valid = {
+            {"label", DAILY_MESSAGE_CHUNK_LABEL},
+            {"id", 1},
+            {"seq", 0},
+            {"total", 1},
+            {"data", "x"}
+    };
+    CHECK(assembler.add_chunk("a", valid) == std::string("x"));
+
+    std::vector<nlohmann::json> malformed = {
+            nlohmann::json::object(),
+            nlohmann::json::array(),
+            "chunk",
+            42,
+            nullptr
+    };
+    for (const char* field : {"id", "seq", "total", "data"}) {
+        for (nlohmann::json value :
+             {nlohmann::json(-1),
+              nlohmann::json(0.5),
+              nlohmann::json(nullptr),
+              nlohmann::json::array({1}),
+              nlohmann::json::object({{"a", 1}})}) {
+            nlohmann::json chunk = valid;
+            chunk[field] = value;
+            malformed.push_back(chunk);
+        }
+        nlohmann::json chunk = valid;
+        chunk.erase(field);
+        malformed.push_back(chunk);
+    }
+    for (const char* field : {"id", "seq", "total"}) {
+        nlohmann::json chunk = valid;
+        chunk[field] = "1";
+        malformed.push_back(chunk);
+    }
+    // Parsed negative numbers are signed ones.
+    malformed.push_back(nlohmann::json::parse(
+            R"({"id": 1, "seq": -1, "total": 1, "data": "x"})"
+    ));
+    for (const char* field : {"seq", "total"}) {
+        // Would be truncated to 0 or 1 as a uint32_t.
+        for (uint64_t value : {uint64_t(1) << 32, (uint64_t(1) << 32) + 1}) {
+            nlohmann::json chunk = valid;
+            chunk[field] = value;
+            malformed.push_back(chunk);
+        }
+    }
+
+    for (const nlohmann::json& chunk : malformed) {
+        CHECK(!assembler.add_chunk("a", chunk));
+    }
+    CHECK(assembler.pending() == 0);
+
+    // A large but valid `id` works.
+    valid["id"] = UINT64_MAX;
+    CHECK(assembler.add_chunk("a", valid) == std::string("x"));
+}
+
+int main() {
+    check_round_trips();
+    check_escaped_size();
+    check_max_pending();
+    check_max_bytes();
+    check_malformed_messages();
+    return TEST_RESULT();
+}
@@ -0,0 +1,81 @@
+//
+// Copyright (c) 2024, Daily
+//
+
+#include "daily_message_queue.h"
+
+#include "test.h"
+
+using namespace rtvi;
+
+static void check_order() {
+    DailyMessageQueue queue;
+
+    queue.push("bulk", DailyMessagePriority::Bulk);
+    queue.push("normal 1", DailyMessagePriority::Normal);
+    queue.push("control", DailyMessagePriority::Control);
+    queue.push("normal 2", DailyMessagePriority::Normal);
+
+    CHECK(queue.blocking_pop() == "control");
+    CHECK(queue.blocking_pop() == "normal 1");
+    CHECK(queue.blocking_pop() == "normal 2");
+    CHECK(queue.blocking_pop() == "bulk");
+
+    CHECK(queue.stats(DailyMessagePriority::Normal).pushed == 2);
+    CHECK(queue.stats(DailyMessagePriority::Normal).pending == 0);
+}
+
+// Priorities outside the enum go to the normal lane instead of out of bounds.
+static void check_invalid_priority() {
+    DailyMessageQueue queue;
+
+    auto invalid = static_cast<DailyMessagePriority>(7);
+    CHECK(queue.push("invalid", invalid));
+    queue.push("bulk", DailyMessagePriority::Bulk);
+
+    CHECK(queue.stats(invalid).pushed == 1);
+    CHECK(queue.stats(DailyMessagePriority::Normal).pushed == 1);
+    CHECK(queue.blocking_pop() == "invalid");
+    CHECK(queue.blocking_pop() == "bulk");
+
+    auto negative = static_cast<DailyMessagePriority>(-1);
+    CHECK(queue.push(std::vector<std::string> {"a", "b"}, negative));
+    CHECK(queue.stats(DailyMessagePriority::Normal).pushed == 3);
+}
+
+static void check_limit() {
+    DailyMessageQueue queue(1024);
+
+    CHECK(queue.push(std::string(512, 'a'), DailyMessagePriority::Normal));
+
+    // All the chunks or none of them.
+    std::vector<std::string> chunks(2, std::string(400, 'b'));
+    CHECK(!queue.push(chunks, DailyMessagePriority::Bulk));
+    CHECK(queue.stats(DailyMessagePriority::Bulk).dropped == 2);
+    CHECK(queue.stats(DailyMessagePriority::Bulk).pending == 0);
+
+    CHECK(queue.blocking_pop() == std::string(512, 'a'));
+    CHECK(queue.memory().bytes() == 0);
+    CHECK(queue.push(chunks, DailyMessagePriority::Bulk));
+}
+
+static void check_stop() {
+    DailyMessageQueue queue;
+
+    queue.push("pending", DailyMessagePriority::Normal);
+    queue.stop();
+    CHECK(!queue.blocking_pop());
+
+    queue.restart();
+    CHECK(queue.memory().bytes() == 0);
+    queue.push("new", DailyMessagePriority::Normal);
+    CHECK(queue.blocking_pop() == "new");
+}
+
+int main() {
+    check_order();
+    check_invalid_priority();
+    check_limit();
+    check_stop();
+    return TEST_RESULT();
+}
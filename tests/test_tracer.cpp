@@ -0,0 +1,77 @@
+//
+// Copyright (c) 2024, Daily
+//
+
+#include "daily_tracer.h"
+
+#include "test.h"
+
+#include <nlohmann/json.hpp>
+
+#include <string>
+#include <thread>
+
+using namespace rtvi;
+
+// Returns the number of events named `name` in the exported trace.
+static size_t count_events(const std::string& name) {
+    nlohmann::json trace =
+            nlohmann::json::parse(DailyTracer::instance().chrome_trace());
+    size_t count = 0;
+    for (const nlohmann::json& event : trace["traceEvents"]) {
+        if (event["name"] == name || event["args"].value("name", "") == name) {
+            count++;
+        }
+    }
+    return count;
+}
+
+// Naming threads and recording while disabled doesn't allocate rings.
+static void check_disabled() {
+    DailyTracer& tracer = DailyTracer::instance();
+
+    std::thread thread([&tracer] {
+        tracer.set_thread_name("disabled");
+        tracer.record(1, "disabled-span", 0, 1, 0);
+    });
+    thread.join();
+
+    CHECK(tracer.memory_bytes() == 0);
+    CHECK(count_events("disabled-span") == 0);
+}
+
+// Events of exited threads are exported until the next recording, which
+// releases their rings.
+static void check_exited_threads() {
+    DailyTracer& tracer = DailyTracer::instance();
+    tracer.start(16);
+
+    std::thread thread([&tracer] {
+        tracer.set_thread_name("worker");
+        tracer.record(1, "worker-span", 0, 1, 0);
+    });
+    thread.join();
+
+    CHECK(tracer.memory_bytes() > 0);
+    CHECK(count_events("worker-span") == 1);
+    CHECK(count_events("worker") == 1);
+
+    tracer.start(16);
+    CHECK(tracer.memory_bytes() == 0);
+    CHECK(count_events("worker-span") == 0);
+
+    // Live threads keep their ring.
+    tracer.record(1, "main-span", 0, 1, 0);
+    size_t bytes = tracer.memory_bytes();
+    CHECK(bytes > 0);
+    tracer.start(16);
+    CHECK(tracer.memory_bytes() == bytes);
+
+    tracer.stop();
+}
+
+int main() {
+    check_disabled();
+    check_exited_threads();
+    return TEST_RESULT();
+}